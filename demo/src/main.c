@@ -26,7 +26,7 @@ int main()
     const uint8_t*      keystate = esz_get_keyboard_state();
     esz_status          status;
     esz_window_t*       window   = NULL;
-    esz_window_config_t config   = { 640, 360, 384, 216, false, false };
+    esz_window_config_t config   = { 640, 360, 384, 216, false, false, false };
     esz_core_t*         core     = NULL;
 
     status = esz_create_window("Tau Ceti", &config, &window);
@@ -46,6 +46,11 @@ int main()
 
     while (esz_is_core_active(core))
     {
+        if (esz_is_map_staged(core))
+        {
+            esz_swap_map(core);
+        }
+
         esz_update_core(window, core);
 
         status = esz_show_scene(window, core);
@@ -74,15 +79,21 @@ static void key_down_callback(esz_window_t* window, esz_core_t* core)
     {
         case SDLK_F5:
         {
-            if (esz_is_map_loaded(core))
+            if (esz_is_map_loaded(core) || esz_is_map_loading(core))
             {
                 esz_unload_map(window, core);
             }
             else
             {
-                esz_load_map(MAP_FILE, window, core);
+                esz_load_map_async(MAP_FILE, window, core);
             }
             break;
         }
+        case SDLK_F6:
+        {
+            // Reload without interrupting the running map.
+            esz_stage_map(MAP_FILE, window, core);
+            break;
+        }
     }
 }
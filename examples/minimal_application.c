@@ -11,7 +11,7 @@ int main()
 {
     esz_status          status;
     esz_window_t*       window = NULL;
-    esz_window_config_t config = { 640, 360, 384, 216, false, false };
+    esz_window_config_t config = { 640, 360, 384, 216, false, false, false };
     esz_core_t*         core   = NULL;
 
     status = esz_create_window("eszFW", &config, &window);
@@ -11,7 +11,9 @@
 #include <math.h>
 #include <stdbool.h>
 #include <stdint.h>
+#include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 
 DISABLE_WARNING_PUSH
 DISABLE_WARNING_PADDING
@@ -28,16 +30,54 @@ DISABLE_WARNING_SYMBOL_NOT_DEFINED
 DISABLE_WARNING_POP
 
 #include "esz.h"
+#include "esz_atlas.h"
+#include "esz_cache.h"
 #include "esz_compat.h"
+#include "esz_event.h"
 #include "esz_hash.h"
 #include "esz_init.h"
+#include "esz_latency.h"
+#include "esz_pack.h"
+#include "esz_profile.h"
+#include "esz_reload.h"
 #include "esz_render.h"
+#include "esz_stream.h"
+#include "esz_trace.h"
 #include "esz_types.h"
 #include "esz_utils.h"
 
+#define MAP_LOADER_PROGRESS_MAX  1000
+#define MAP_LOADER_UPLOAD_BUDGET 4 // Milliseconds of texture uploads per frame.
+#define MAP_TEARDOWN_BUDGET      2 // Milliseconds of texture destruction per frame.
+#define MAX_FRAME_TIME           0.1 // Seconds; longer hitches are not caught up.
+
 DISABLE_WARNING_PUSH
 DISABLE_WARNING_SPECTRE_MITIGATION
 
+static void       discard_map_loader(esz_core_t* core);
+static void       finish_map_teardown(esz_window_t* window);
+static void       free_map_data(esz_core_t* core);
+static int        load_map_in_background(void* data);
+static esz_status load_map_data(const char* map_file_name, esz_window_t* window, esz_core_t* core, SDL_atomic_t* progress, SDL_atomic_t* cancelled);
+static esz_status load_map_resources(esz_window_t* window, esz_core_t* core);
+static void       notify_map_loaded(esz_window_t* window, esz_core_t* core);
+static void       record_load_stage(esz_map_load_stage stage, uint64_t* start, uint64_t* start_bytes, esz_core_t* core);
+static void       report_map_load_progress(esz_window_t* window, esz_core_t* core);
+static void       retire_map(esz_window_t* window, esz_core_t* core);
+static void       retire_map_textures(esz_window_t* window, esz_core_t* core);
+static void       retire_texture(SDL_Texture* texture, esz_window_t* window);
+static esz_status start_map_loader(const char* map_file_name, bool is_staging, esz_window_t* window, esz_core_t* core);
+static esz_status start_map_teardown(esz_map_t* map, esz_window_t* window);
+static void       swap_staged_map(esz_window_t* window, esz_core_t* core);
+static int        unload_map_in_background(void* data);
+static void       update_map_loader(esz_window_t* window, esz_core_t* core);
+static void       update_map_teardown(esz_window_t* window);
+
+static const char* const load_stage_name[ESZ_MAP_LOAD_STAGE_MAX] = {
+    "map", "tiled_map", "tile_layers", "paths", "entities",
+    "texture_atlas", "tileset", "sprites", "background"
+};
+
 bool esz_bounding_boxes_do_intersect(const esz_aabb_t bb_a, const esz_aabb_t bb_b)
 {
     double bb_a_x = bb_b.left - bb_a.right;
@@ -133,6 +173,22 @@ esz_status esz_create_window(const char* window_title, esz_window_config_t* conf
         (*window)->flags |= SDL_WINDOW_FULLSCREEN_DESKTOP;
     }
 
+    if (config->enable_premultiplied_alpha)
+    {
+        (*window)->is_premultiplied_alpha_enabled = true;
+        (*window)->blend_mode                     = SDL_ComposeCustomBlendMode(
+            SDL_BLENDFACTOR_ONE,
+            SDL_BLENDFACTOR_ONE_MINUS_SRC_ALPHA,
+            SDL_BLENDOPERATION_ADD,
+            SDL_BLENDFACTOR_ONE,
+            SDL_BLENDFACTOR_ONE_MINUS_SRC_ALPHA,
+            SDL_BLENDOPERATION_ADD);
+    }
+    else
+    {
+        (*window)->blend_mode = SDL_BLENDMODE_BLEND;
+    }
+
     if (0 > SDL_Init(SDL_INIT_VIDEO))
     {
         plog_error("%s: %s.", __func__, SDL_GetError());
@@ -235,6 +291,25 @@ esz_status esz_create_window(const char* window_title, esz_window_config_t* conf
         }
     }
 
+    (*window)->texture_format = get_texture_format(*window);
+    plog_info("Use texture format %s.", SDL_GetPixelFormatName((*window)->texture_format));
+
+    {
+        SDL_RendererInfo renderer_info = { 0 };
+
+        if (0 == SDL_GetRendererInfo((*window)->renderer, &renderer_info))
+        {
+            (*window)->max_texture_height = renderer_info.max_texture_height;
+            (*window)->max_texture_width  = renderer_info.max_texture_width;
+        }
+    }
+
+    status = create_texture_cache(*window);
+    if (ESZ_OK != status)
+    {
+        goto exit;
+    }
+
     plog_info(
         "Setting up window at resolution %dx%d @ %d Hz.",
         (*window)->width,
@@ -262,6 +337,14 @@ void esz_destroy_core(esz_core_t* core)
 {
     if (core)
     {
+        discard_map_loader(core);
+
+        if (core->retired_map)
+        {
+            retire_map(core->loader.window, core);
+        }
+
+        free_event_bus(&core->event_bus);
         free(core);
         plog_info("Destroy engine core.");
     }
@@ -269,6 +352,10 @@ void esz_destroy_core(esz_core_t* core)
 
 void esz_destroy_window(esz_window_t* window)
 {
+    unmount_asset_pack(&window->asset_pack);
+    finish_map_teardown(window);
+    destroy_texture_cache(window);
+
     if (window->esz_logo)
     {
         SDL_DestroyTexture(window->esz_logo);
@@ -289,10 +376,68 @@ void esz_destroy_window(esz_window_t* window)
         free(window);
     }
 
+    stop_trace();
+
     plog_info("Quitting.");
     SDL_Quit();
 }
 
+void esz_disable_atlas_cache(esz_core_t* core)
+{
+    core->is_atlas_cache_enabled = false;
+}
+
+void esz_disable_deferred_unload(esz_core_t* core)
+{
+    core->is_deferred_unload_enabled = false;
+}
+
+void esz_disable_hot_reload(esz_core_t* core)
+{
+    core->hot_reload.is_enabled = false;
+    unwatch_map_files(core);
+}
+
+void esz_disable_latency_overlay(esz_core_t* core)
+{
+    core->input_latency.is_overlay_enabled = false;
+}
+
+void esz_disable_map_streaming(esz_core_t* core)
+{
+    core->is_map_streaming_enabled = false;
+}
+
+void esz_dispatch_events(esz_window_t* window, esz_core_t* core)
+{
+    dispatch_deferred_events(window, core);
+}
+
+void esz_enable_atlas_cache(esz_core_t* core)
+{
+    core->is_atlas_cache_enabled = true;
+}
+
+void esz_enable_deferred_unload(esz_core_t* core)
+{
+    core->is_deferred_unload_enabled = true;
+}
+
+void esz_enable_hot_reload(esz_core_t* core)
+{
+    core->hot_reload.is_enabled = true;
+}
+
+void esz_enable_latency_overlay(esz_core_t* core)
+{
+    core->input_latency.is_overlay_enabled = true;
+}
+
+void esz_enable_map_streaming(esz_core_t* core)
+{
+    core->is_map_streaming_enabled = true;
+}
+
 const uint8_t* esz_get_keyboard_state(void)
 {
     return SDL_GetKeyboardState(NULL);
@@ -333,6 +478,21 @@ double esz_get_decimal_map_property(const uint64_t name_hash, esz_core_t* core)
     return core->map->decimal_property;
 }
 
+int32_t esz_get_event_entity_id(esz_core_t* core)
+{
+    return core->event.entity_id;
+}
+
+esz_frame_phase_stats_t esz_get_frame_phase_stats(const esz_frame_phase phase, esz_core_t* core)
+{
+    return get_frame_phase_stats(phase, &core->profiler);
+}
+
+esz_input_latency_stats_t esz_get_input_latency_stats(esz_core_t* core)
+{
+    return get_input_latency_stats(&core->input_latency);
+}
+
 int32_t esz_get_integer_map_property(const uint64_t name_hash, esz_core_t* core)
 {
     int32_t prop_cnt;
@@ -348,6 +508,21 @@ int32_t esz_get_integer_map_property(const uint64_t name_hash, esz_core_t* core)
     return core->map->integer_property;
 }
 
+double esz_get_map_load_progress(esz_core_t* core)
+{
+    return (double)SDL_AtomicGet(&core->loader.progress) / (double)MAP_LOADER_PROGRESS_MAX;
+}
+
+esz_map_load_stats_t esz_get_map_load_stats(esz_core_t* core)
+{
+    return core->load_stats;
+}
+
+esz_render_stats_t esz_get_render_stats(esz_core_t* core)
+{
+    return core->render_stats;
+}
+
 const char* esz_get_string_map_property(const uint64_t name_hash, esz_core_t* core)
 {
     int32_t prop_cnt;
@@ -385,6 +560,13 @@ esz_status esz_init_core(esz_core_t** core)
         return ESZ_ERROR_CRITICAL;
     }
 
+    if (ESZ_OK != init_event_bus(&(*core)->event_bus))
+    {
+        free(*core);
+        *core = NULL;
+        return ESZ_ERROR_CRITICAL;
+    }
+
     (*core)->is_active = true;
 
     return ESZ_OK;
@@ -410,6 +592,21 @@ bool esz_is_map_loaded(esz_core_t* core)
     return false;
 }
 
+bool esz_is_map_loading(esz_core_t* core)
+{
+    if (core->loader.core && ! core->loader.is_staged)
+    {
+        return true;
+    }
+
+    return false;
+}
+
+bool esz_is_map_staged(esz_core_t* core)
+{
+    return core->loader.is_staged;
+}
+
 bool esz_is_player_moving(esz_core_t* core)
 {
     if (! esz_is_map_loaded(core))
@@ -435,134 +632,95 @@ bool esz_is_player_moving(esz_core_t* core)
 
 esz_status esz_load_map(const char* map_file_name, esz_window_t* window, esz_core_t* core)
 {
-    char* tileset_image_source = NULL;
+    uint64_t start;
+    uint64_t start_bytes;
 
-    if (esz_is_map_loaded(core))
+    if (esz_is_map_loaded(core) || esz_is_map_loading(core))
     {
         plog_warn("A map has already been loaded: unload map first.");
         return ESZ_WARNING;
     }
 
-    // Load map file and allocate required memory
-    // ------------------------------------------------------------------------
-
-    // 1. Map
-    // ------------------------------------------------------------------------
-
-    core->map = (esz_map_t*)calloc(1, sizeof(struct esz_map));
-    if (! core->map)
-    {
-        plog_error("%s: error allocating memory.", __func__);
-        return ESZ_WARNING;
-    }
-
-    // 2. Tiled map
-    // ------------------------------------------------------------------------
-
-    if (ESZ_OK != load_tiled_map(map_file_name, core))
-    {
-        goto warning;
-    }
-    core->is_map_loaded = true;
-
-    // 3. Tile properties
-    // ------------------------------------------------------------------------
-
-    if (ESZ_OK != load_tile_properties(core))
-    {
-        goto warning;
-    }
-
-    // 4. Paths and file locations
-    // ------------------------------------------------------------------------
-
-    if (ESZ_OK != load_map_path(map_file_name, core))
-    {
-        goto warning;
-    }
-
-    // 5. Entities
-    // ------------------------------------------------------------------------
-
-    if (ESZ_OK != load_entities(core))
+    if (ESZ_OK != load_map_data(map_file_name, window, core, &core->loader.progress, &core->loader.cancelled))
     {
         goto warning;
     }
 
-    // 6. Tileset
-    // ------------------------------------------------------------------------
+    start       = SDL_GetPerformanceCounter();
+    start_bytes = get_allocated_bytes();
 
-    if (ESZ_OK != load_tileset(window, core))
+    if (ESZ_OK != upload_atlas(&core->map->atlas, window))
     {
         goto warning;
     }
+    free_atlas_pixels(&core->map->atlas);
+    store_cached_atlas(&core->map->atlas, window);
+    record_load_stage(ESZ_STAGE_TEXTURE_ATLAS, &start, &start_bytes, core);
 
-    // 7. Sprites
-    // ------------------------------------------------------------------------
-
-    if (ESZ_OK != load_sprites(window, core))
+    if (ESZ_OK != load_map_resources(window, core))
     {
         goto warning;
     }
 
-    // 8. Animated tiles
-    // ------------------------------------------------------------------------
+    plog_info(
+        "Load map file: %s containing %d entities(s) in %.2f ms.",
+        map_file_name, core->map->entity_count, core->load_stats.load_time);
 
-    if (ESZ_OK != load_animated_tiles(core))
-    {
-        goto warning;
-    }
+    notify_map_loaded(window, core);
 
-    // 9. Background
-    // ------------------------------------------------------------------------
+    return ESZ_OK;
+warning:
+    esz_unload_map(window, core);
+    return ESZ_WARNING;
+}
 
-    if (ESZ_OK != load_background(window, core))
+esz_status esz_load_map_async(const char* map_file_name, esz_window_t* window, esz_core_t* core)
+{
+    if (esz_is_map_loaded(core))
     {
-        goto warning;
+        plog_warn("A map has already been loaded: unload map first.");
+        return ESZ_WARNING;
     }
 
-    plog_info(
-        "Set gravitational constant to %f (g*%dpx/s^2).",
-        core->map->gravitation, core->map->meter_in_pixel);
-
-    core->map->animated_tile_fps = esz_get_integer_map_property(H_animated_tile_fps, core);
-    if (core->map->animated_tile_fps > window->refresh_rate)
-    {
-        // It can't update faster anyway.
-        core->map->animated_tile_fps = window->refresh_rate;
-    }
+    return start_map_loader(map_file_name, false, window, core);
+}
 
-    if (core->event.map_loaded_cb)
-    {
-        core->event.map_loaded_cb(window, core);
-    }
+void esz_lock_camera(esz_core_t* core)
+{
+    core->camera.is_locked = true;
+}
 
-    // ------------------------------------------------------------------------
+esz_status esz_mount_asset_pack(const char* pack_file_name, esz_window_t* window)
+{
+    return mount_asset_pack(pack_file_name, &window->asset_pack);
+}
 
-    core->map->height         = (int32_t)((int32_t)core->map->handle->height * get_tile_height(core->map->handle));
-    core->map->width          = (int32_t)((int32_t)core->map->handle->width * get_tile_width(core->map->handle));
-    core->map->gravitation    = esz_get_decimal_map_property(H_gravitation, core);
-    core->map->meter_in_pixel = esz_get_integer_map_property(H_meter_in_pixel, core);
+bool esz_post_event(const esz_event_type event_type, int32_t value, void* data, esz_core_t* core)
+{
+    esz_bus_event_t event = { 0 };
 
-    plog_info(
-        "Load map file: %s containing %d entities(s).",
-        map_file_name, core->map->entity_count);
+    event.type  = event_type;
+    event.value = value;
+    event.data  = data;
 
-    return ESZ_OK;
-warning:
-    esz_unload_map(window, core);
-    return ESZ_WARNING;
+    return post_event(&event, &core->event_bus);
 }
 
-void esz_lock_camera(esz_core_t* core)
+void esz_purge_texture_cache(esz_window_t* window)
 {
-    core->camera.is_locked = true;
+    evict_cached_pages(0, window);
 }
 
 void esz_register_event_callback(const esz_event_type event_type, esz_event_callback event_callback, esz_core_t* core)
 {
     switch (event_type)
     {
+        case EVENT_ENTITY_ENTERED_REGION:
+            core->event.entity_entered_region_cb = event_callback;
+            break;
+        case EVENT_ENTITY_LEFT_REGION:
+            core->event.entity_left_region_cb    = event_callback;
+            break;
         case EVENT_FINGERDOWN:
             core->event.finger_down_cb   = event_callback;
             break;
@@ -578,6 +736,9 @@ void esz_register_event_callback(const esz_event_type event_type, esz_event_call
         case EVENT_KEYUP:
             core->event.key_up_cb        = event_callback;
             break;
+        case EVENT_MAP_LOAD_PROGRESS:
+            core->event.map_load_progress_cb = event_callback;
+            break;
         case EVENT_MAP_LOADED:
             core->event.map_loaded_cb    = event_callback;
             break;
@@ -587,6 +748,9 @@ void esz_register_event_callback(const esz_event_type event_type, esz_event_call
         case EVENT_MULTIGESTURE:
             core->event.multi_gesture_cb = event_callback;
             break;
+        case EVENT_USER:
+            // Only available through esz_subscribe_event().
+            break;
     }
 }
 
@@ -694,6 +858,12 @@ void esz_set_camera_target(const int32_t id, esz_core_t* core)
     core->camera.target_actor_id = id;
 }
 
+void esz_set_texture_cache_budget(const size_t budget, esz_window_t* window)
+{
+    window->texture_cache.budget = budget;
+    evict_cached_pages(budget, window);
+}
+
 esz_status esz_set_zoom_level(const double factor, esz_window_t* window)
 {
     window->zoom_level     = factor;
@@ -729,12 +899,53 @@ esz_status esz_show_scene(esz_window_t* window, esz_core_t* core)
         goto exit;
     }
 
+    PROFILE_BEGIN(ESZ_PHASE_DRAW_SCENE, core);
     status = draw_scene(window, core);
+    PROFILE_END(ESZ_PHASE_DRAW_SCENE, core);
+    PROFILE_END_FRAME(core);
 
 exit:
     return status;
 }
 
+esz_status esz_stage_map(const char* map_file_name, esz_window_t* window, esz_core_t* core)
+{
+    return start_map_loader(map_file_name, true, window, core);
+}
+
+esz_status esz_start_trace(const char* file_name)
+{
+#if defined(USE_TRACING)
+    return start_trace(file_name);
+#else
+    (void)file_name;
+    plog_warn("%s: eszFW has been built without USE_TRACING.", __func__);
+    return ESZ_WARNING;
+#endif
+}
+
+esz_status esz_stop_trace(void)
+{
+    return stop_trace();
+}
+
+esz_status esz_subscribe_event(const esz_event_type event_type, esz_event_handler handler, void* userdata, const esz_dispatch_mode mode, esz_core_t* core)
+{
+    return subscribe_event(event_type, handler, userdata, mode, &core->event_bus);
+}
+
+esz_status esz_swap_map(esz_core_t* core)
+{
+    if (! esz_is_map_staged(core))
+    {
+        plog_warn("No map has been staged.");
+        return ESZ_WARNING;
+    }
+
+    core->loader.is_swap_requested = true;
+    return ESZ_OK;
+}
+
 esz_status esz_toggle_fullscreen(esz_window_t* window)
 {
     esz_status status = ESZ_OK;
@@ -786,8 +997,21 @@ void esz_trigger_player_action(esz_action action, esz_core_t* core)
 
 void esz_unload_map(esz_window_t* window, esz_core_t* core)
 {
-    esz_tiled_layer_t*  layer;
-    esz_tiled_object_t* tiled_object = NULL;
+    if (core->retired_map)
+    {
+        retire_map(window, core);
+    }
+
+    if (core->loader.core)
+    {
+        discard_map_loader(core);
+        plog_info("Cancel loading map.");
+
+        if (! esz_is_map_loaded(core))
+        {
+            return;
+        }
+    }
 
     if (! esz_is_map_loaded(core))
     {
@@ -797,6 +1021,13 @@ void esz_unload_map(esz_window_t* window, esz_core_t* core)
     core->is_map_loaded           = false;
     core->camera.target_actor_id = 0;
 
+    unwatch_map_files(core);
+
+    if (core->is_deferred_unload_enabled)
+    {
+        retire_map_textures(window, core);
+    }
+
     for (int32_t index = 0; index < ESZ_MAP_LAYER_LEVEL_MAX; index += 1)
     {
         if (core->map->layer_texture[index])
@@ -821,63 +1052,266 @@ void esz_unload_map(esz_window_t* window, esz_core_t* core)
         core->map->animated_tile_texture = NULL;
     }
 
-    // Free up allocated memory in reverse order
+    // 6. Texture atlas
     // ------------------------------------------------------------------------
 
-    // 9. Background
-    // ------------------------------------------------------------------------
+    // The texture cache may only be used from the render thread.
+    release_cached_atlas(&core->map->atlas, window);
 
-    if (0 < core->map->background.layer_count)
+    if (! core->is_deferred_unload_enabled || ESZ_OK != start_map_teardown(core->map, window))
     {
-        for (int32_t index = 0; index < core->map->background.layer_count; index += 1)
-        {
-            if (core->map->background.layer[index].texture)
-            {
-                SDL_DestroyTexture(core->map->background.layer[index].texture);
-                core->map->background.layer[index].texture = NULL;
-            }
-        }
+        free_map_data(core);
     }
 
-    free(core->map->background.layer);
-
-    // 8. Animated tiles
-    // ------------------------------------------------------------------------
-
-    free(core->map->animated_tile);
-
-    // 7. Sprites
-    // ------------------------------------------------------------------------
+    post_engine_event(EVENT_MAP_UNLOADED, NULL, 0, core);
 
-    if (0 < core->map->sprite_sheet_count)
+    if (core->event.map_unloaded_cb)
     {
-        for (int32_t index = 0; index < core->map->sprite_sheet_count; index += 1)
-        {
-            core->map->sprite[index].id = 0;
-
-            if (core->map->sprite[index].texture)
-            {
-                SDL_DestroyTexture(core->map->sprite[index].texture);
-                core->map->sprite[index].texture = NULL;
-            }
-        }
+        core->event.map_unloaded_cb(window, core);
     }
 
-    free(core->map->sprite);
+    plog_info("Unload map.");
+}
 
-    // 6. Tileset
-    // ------------------------------------------------------------------------
+void esz_unlock_camera(esz_core_t* core)
+{
+    core->camera.is_locked = false;
+}
 
-    if (core->map->tileset_texture)
+void esz_unmount_asset_pack(esz_window_t* window)
+{
+    unmount_asset_pack(&window->asset_pack);
+}
+
+void esz_unsubscribe_event(const esz_event_type event_type, esz_event_handler handler, void* userdata, esz_core_t* core)
+{
+    unsubscribe_event(event_type, handler, userdata, &core->event_bus);
+}
+
+void esz_update_core(esz_window_t* window, esz_core_t* core)
+{
+    double   frequency  = (double)SDL_GetPerformanceFrequency();
+    double   delta_time = 0.0;
+    double   frame_time;
+    uint64_t now;
+
+    if (core->retired_map)
+    {
+        retire_map(window, core);
+    }
+
+    update_map_teardown(window);
+
+    // Swapping is deferred to the frame boundary.
+    if (core->loader.is_swap_requested)
     {
-        SDL_DestroyTexture(core->map->tileset_texture);
-        core->map->tileset_texture = NULL;
+        swap_staged_map(window, core);
     }
 
+    PROFILE_BEGIN(ESZ_PHASE_POLL_EVENTS, core);
+    poll_events(window, core);
+    PROFILE_END(ESZ_PHASE_POLL_EVENTS, core);
+    process_events(window, core);
+
+    now        = SDL_GetPerformanceCounter();
+    frame_time = 1.0 / (double)window->refresh_rate;
+
+    // The first frame has nothing to measure against.
+    if (0 == window->frame_start)
+    {
+        window->frame_start = now - (uint64_t)(frame_time * frequency);
+    }
+
+    delta_time = (double)(now - window->frame_start) / frequency;
+
+    if (! window->vsync_enabled && frame_time > delta_time)
+    {
+        SDL_Delay((uint32_t)floor((frame_time - delta_time) * 1000.0));
+
+        now        = SDL_GetPerformanceCounter();
+        delta_time = (double)(now - window->frame_start) / frequency;
+    }
+
+    window->frame_start           = now;
+    window->time_since_last_frame = SDL_min(delta_time, MAX_FRAME_TIME);
+
+    if (esz_is_map_loading(core))
+    {
+        update_map_loader(window, core);
+    }
+
+    if (! esz_is_map_loaded(core))
+    {
+        return;
+    }
+
+    PROFILE_BEGIN(ESZ_PHASE_MOVE_CAMERA, core);
+    move_camera_to_target(window, core);
+    PROFILE_END(ESZ_PHASE_MOVE_CAMERA, core);
+
+    PROFILE_BEGIN(ESZ_PHASE_UPDATE_ENTITIES, core);
+    update_entities(window, core);
+    PROFILE_END(ESZ_PHASE_UPDATE_ENTITIES, core);
+
+    if (core->map->region)
+    {
+        update_map_regions(window, core);
+    }
+
+    update_hot_reload(window, core);
+}
+
+esz_status esz_write_map_load_stats(const char* file_name, esz_core_t* core)
+{
+    esz_map_load_stats_t* stats  = &core->load_stats;
+    char                  line[1024];
+    int                   length;
+    FILE*                 fp;
+
+    length = stbsp_snprintf(
+        line, (int)sizeof(line),
+        "{\"load_time_ms\":%.3f,\"bytes_allocated\":%llu,\"bake_time_ms\":%.3f,\"bake_draw_calls\":%d,\"tiles_baked\":%d,\"stages\":{",
+        stats->load_time,
+        (unsigned long long)stats->bytes_allocated,
+        stats->bake_time,
+        stats->bake_draw_calls,
+        stats->tiles_baked);
+
+    for (int32_t index = 0; index < ESZ_MAP_LOAD_STAGE_MAX; index += 1)
+    {
+        length += stbsp_snprintf(
+            line + length, (int)sizeof(line) - length,
+            "%s\"%s\":{\"time_ms\":%.3f,\"bytes\":%llu}",
+            (0 == index) ? "" : ",",
+            load_stage_name[index],
+            stats->stage_time[index],
+            (unsigned long long)stats->stage_bytes[index]);
+    }
+    stbsp_snprintf(line + length, (int)sizeof(line) - length, "}}\n");
+
+    if (! file_name)
+    {
+        fputs(line, stdout);
+        return ESZ_OK;
+    }
+
+    fp = fopen(file_name, "a");
+    if (! fp)
+    {
+        plog_warn("%s: could not open %s for writing.", __func__, file_name);
+        return ESZ_WARNING;
+    }
+
+    if (EOF == fputs(line, fp))
+    {
+        plog_warn("%s: could not write to %s.", __func__, file_name);
+        fclose(fp);
+        return ESZ_WARNING;
+    }
+
+    fclose(fp);
+    return ESZ_OK;
+}
+
+esz_status esz_write_trace(void)
+{
+    return write_trace();
+}
+
+static void discard_map_loader(esz_core_t* core)
+{
+    esz_map_loader_t* loader = &core->loader;
+
+    if (! loader->core)
+    {
+        return;
+    }
+
+    if (loader->thread)
+    {
+        // Let the loader stop at the next stage instead of finishing it.
+        SDL_AtomicSet(&loader->cancelled, 1);
+        SDL_WaitThread(loader->thread, NULL);
+        loader->thread = NULL;
+    }
+
+    // The private core has no callbacks registered.
+    if (esz_is_map_loaded(loader->core))
+    {
+        esz_unload_map(loader->window, loader->core);
+    }
+    else
+    {
+        free(loader->core->map);
+    }
+
+    free(loader->core);
+    free(loader->map_file_name);
+
+    loader->core          = NULL;
+    loader->map_file_name = NULL;
+    SDL_AtomicSet(&loader->cancelled, 0);
+    SDL_AtomicSet(&loader->progress, 0);
+    SDL_AtomicSet(&loader->state, LOADER_IDLE);
+}
+
+// Must be called before the renderer is destroyed.
+static void finish_map_teardown(esz_window_t* window)
+{
+    esz_map_teardown_t* teardown = &window->map_teardown;
+
+    if (teardown->thread)
+    {
+        SDL_WaitThread(teardown->thread, NULL);
+        teardown->thread = NULL;
+    }
+
+    for (int32_t index = 0; index < teardown->texture_count; index += 1)
+    {
+        SDL_DestroyTexture(teardown->texture[index]);
+    }
+    free(teardown->texture);
+
+    teardown->texture       = NULL;
+    teardown->texture_count = 0;
+    teardown->texture_limit = 0;
+}
+
+/* Frees everything esz_unload_map() leaves behind once the textures
+ * are gone.  Doesn't touch the renderer, so it may run on a worker
+ * thread.
+ */
+static void free_map_data(esz_core_t* core)
+{
+    esz_tiled_layer_t*  layer;
+    esz_tiled_object_t* tiled_object = NULL;
+
+    // Free up allocated memory in reverse order
+    // ------------------------------------------------------------------------
+
+    // 9. Background
+    // ------------------------------------------------------------------------
+
+    // The layer textures are owned by the texture atlas.
+    free(core->map->background.layer);
+
+    // 8. Sprites
+    // ------------------------------------------------------------------------
+
+    free(core->map->sprite);
+
+    // 7. Tileset
+    // ------------------------------------------------------------------------
+
+    free(core->map->tile);
+
+    // 6. Texture atlas: released by esz_unload_map().
+    // ------------------------------------------------------------------------
+
     // 5. Entities
     // ------------------------------------------------------------------------
 
-    layer = get_head_layer(core->map->handle);
+    layer = core->map->entity ? get_head_layer(core->map->handle) : NULL;
     while (layer)
     {
         if (is_tiled_layer_of_type(ESZ_OBJECT_GROUP, layer, core))
@@ -912,13 +1346,30 @@ void esz_unload_map(esz_window_t* window, esz_core_t* core)
     // 4. Paths and file locations
     // ------------------------------------------------------------------------
 
+    free(core->map->file_name);
     free(core->map->path);
 
-    // 3. Tile properties
+    // 3. Tile layers
     // ------------------------------------------------------------------------
 
+    destroy_map_regions(core);
+
+    for (int32_t index = 0; index < core->map->tile_layer_count; index += 1)
+    {
+        free(core->map->tile_layer[index].cell);
+    }
+    free(core->map->tile_layer);
+    free(core->map->animated_tile);
     free(core->map->tile_properties);
 
+    // Binary maps own their flags.
+    if (! core->map->binary_map)
+    {
+        free(core->map->tile_flag);
+        core->map->tile_flag       = NULL;
+        core->map->tile_flag_count = 0;
+    }
+
     // 2. Tiled map
     // ------------------------------------------------------------------------
 
@@ -928,52 +1379,563 @@ void esz_unload_map(esz_window_t* window, esz_core_t* core)
     // ------------------------------------------------------------------------
 
     free(core->map);
+}
 
-    if (core->event.map_unloaded_cb)
+static int load_map_in_background(void* data)
+{
+    esz_map_loader_t* loader = (esz_map_loader_t*)data;
+
+    if (ESZ_OK == load_map_data(loader->map_file_name, loader->window, loader->core, &loader->progress, &loader->cancelled))
     {
-        core->event.map_unloaded_cb(window, core);
+        SDL_AtomicSet(&loader->state, LOADER_READY);
+    }
+    else
+    {
+        SDL_AtomicSet(&loader->state, LOADER_FAILED);
     }
 
-    plog_info("Unload map.");
+    return 0;
 }
 
-void esz_unlock_camera(esz_core_t* core)
+/* Stages that do not touch the renderer; safe to run on a worker
+ * thread.  Decoded atlas pages are kept in memory until uploaded.  A
+ * cancelled load stops before the next stage.
+ */
+static esz_status load_map_data(const char* map_file_name, esz_window_t* window, esz_core_t* core, SDL_atomic_t* progress, SDL_atomic_t* cancelled)
 {
-    core->camera.is_locked = false;
+    uint64_t start;
+    uint64_t start_bytes;
+
+    // Load map file and allocate required memory
+    // ------------------------------------------------------------------------
+
+    // 1. Map
+    // ------------------------------------------------------------------------
+
+    SDL_memset(&core->load_stats, 0, sizeof(struct esz_map_load_stats));
+    start       = SDL_GetPerformanceCounter();
+    start_bytes = get_allocated_bytes();
+
+    core->map = (esz_map_t*)calloc_counted(1, sizeof(struct esz_map));
+    if (! core->map)
+    {
+        plog_error("%s: error allocating memory.", __func__);
+        return ESZ_WARNING;
+    }
+    record_load_stage(ESZ_STAGE_MAP, &start, &start_bytes, core);
+    SDL_AtomicSet(progress, 50);
+
+    // 2. Tiled map
+    // ------------------------------------------------------------------------
+
+    if (SDL_AtomicGet(cancelled) || ESZ_OK != load_tiled_map(map_file_name, core))
+    {
+        return ESZ_WARNING;
+    }
+    core->is_map_loaded = true;
+    record_load_stage(ESZ_STAGE_TILED_MAP, &start, &start_bytes, core);
+    SDL_AtomicSet(progress, 150);
+
+    // 3. Tile layers
+    // ------------------------------------------------------------------------
+
+    if (SDL_AtomicGet(cancelled) || ESZ_OK != load_tile_layers(core))
+    {
+        return ESZ_WARNING;
+    }
+    if (core->is_map_streaming_enabled)
+    {
+        if (ESZ_OK != create_map_regions(core))
+        {
+            return ESZ_WARNING;
+        }
+    }
+    record_load_stage(ESZ_STAGE_TILE_LAYERS, &start, &start_bytes, core);
+    SDL_AtomicSet(progress, 200);
+
+    // 4. Paths and file locations
+    // ------------------------------------------------------------------------
+
+    if (SDL_AtomicGet(cancelled) || ESZ_OK != load_map_path(map_file_name, core))
+    {
+        return ESZ_WARNING;
+    }
+    record_load_stage(ESZ_STAGE_PATHS, &start, &start_bytes, core);
+
+    // 5. Entities
+    // ------------------------------------------------------------------------
+
+    if (SDL_AtomicGet(cancelled) || ESZ_OK != load_entities(core))
+    {
+        return ESZ_WARNING;
+    }
+    record_load_stage(ESZ_STAGE_ENTITIES, &start, &start_bytes, core);
+    SDL_AtomicSet(progress, 250);
+
+    // 6. Texture atlas
+    // ------------------------------------------------------------------------
+
+    if (SDL_AtomicGet(cancelled) || ESZ_OK != load_texture_atlas(map_file_name, window, core, cancelled))
+    {
+        return ESZ_WARNING;
+    }
+    record_load_stage(ESZ_STAGE_TEXTURE_ATLAS, &start, &start_bytes, core);
+    SDL_AtomicSet(progress, 700);
+
+    return ESZ_OK;
 }
 
-void esz_update_core(esz_window_t* window, esz_core_t* core)
+// Remaining stages; they require the texture atlas to be uploaded.
+static esz_status load_map_resources(esz_window_t* window, esz_core_t* core)
 {
-    double delta_time = 0.0;
+    uint64_t start       = SDL_GetPerformanceCounter();
+    uint64_t start_bytes = get_allocated_bytes();
 
-    poll_events(window, core);
+    // 7. Tileset
+    // ------------------------------------------------------------------------
 
-    window->time_b = window->time_a;
-    window->time_a = SDL_GetTicks();
+    if (ESZ_OK != load_tileset(core))
+    {
+        return ESZ_WARNING;
+    }
+    record_load_stage(ESZ_STAGE_TILESET, &start, &start_bytes, core);
 
-    if (window->time_a > window->time_b)
+    // 8. Sprites
+    // ------------------------------------------------------------------------
+
+    if (ESZ_OK != load_sprites(core))
     {
-        window->time_a = window->time_b;
+        return ESZ_WARNING;
     }
+    record_load_stage(ESZ_STAGE_SPRITES, &start, &start_bytes, core);
 
-    delta_time                     = (double)(window->time_b - window->time_a) / 1000.0;
-    window->time_since_last_frame  = 1000.0 / (double)window->refresh_rate - delta_time;
+    // 9. Background
+    // ------------------------------------------------------------------------
 
-    if (! window->vsync_enabled)
+    if (ESZ_OK != load_background(core))
     {
-        double delay = floor(window->time_since_last_frame);
-        SDL_Delay((uint32_t)delay);
+        return ESZ_WARNING;
     }
+    record_load_stage(ESZ_STAGE_BACKGROUND, &start, &start_bytes, core);
 
-    window->time_since_last_frame /= 1000.0;
+    plog_info(
+        "Set gravitational constant to %f (g*%dpx/s^2).",
+        core->map->gravitation, core->map->meter_in_pixel);
 
-    if (! esz_is_map_loaded(core))
+    core->map->animated_tile_fps = esz_get_integer_map_property(H_animated_tile_fps, core);
+    if (core->map->animated_tile_fps > window->refresh_rate)
+    {
+        // It can't update faster anyway.
+        core->map->animated_tile_fps = window->refresh_rate;
+    }
+
+    SDL_AtomicSet(&core->loader.progress, MAP_LOADER_PROGRESS_MAX);
+
+    // ------------------------------------------------------------------------
+
+    core->map->height         = (int32_t)((int32_t)core->map->handle->height * get_tile_height(core->map->handle));
+    core->map->width          = (int32_t)((int32_t)core->map->handle->width * get_tile_width(core->map->handle));
+    core->map->gravitation    = esz_get_decimal_map_property(H_gravitation, core);
+    core->map->meter_in_pixel = esz_get_integer_map_property(H_meter_in_pixel, core);
+
+    return ESZ_OK;
+}
+
+// Adds the time and memory used since the last stage ended.
+/* Only the application's core is notified; maps that are merely staged
+ * are announced once they are swapped in.
+ */
+static void notify_map_loaded(esz_window_t* window, esz_core_t* core)
+{
+    post_engine_event(EVENT_MAP_LOADED, NULL, 0, core);
+
+    if (core->event.map_loaded_cb)
+    {
+        core->event.map_loaded_cb(window, core);
+    }
+}
+
+static void record_load_stage(esz_map_load_stage stage, uint64_t* start, uint64_t* start_bytes, esz_core_t* core)
+{
+    uint64_t now   = SDL_GetPerformanceCounter();
+    uint64_t bytes = get_allocated_bytes();
+    double   time  = (double)(now - *start) * 1000.0 / (double)SDL_GetPerformanceFrequency();
+
+    core->load_stats.stage_time[stage]  += time;
+    core->load_stats.stage_bytes[stage] += bytes - *start_bytes;
+    core->load_stats.load_time          += time;
+    core->load_stats.bytes_allocated    += bytes - *start_bytes;
+
+    TRACE_SCOPE("load", load_stage_name[stage], *start, now);
+    TRACE_COUNTER("load", "allocated_bytes", (double)bytes);
+
+    *start       = now;
+    *start_bytes = bytes;
+}
+
+static void report_map_load_progress(esz_window_t* window, esz_core_t* core)
+{
+    int32_t progress = SDL_AtomicGet(&core->loader.progress);
+
+    if (progress == core->loader.reported_progress)
     {
         return;
     }
+    core->loader.reported_progress = progress;
 
-    move_camera_to_target(window, core);
-    update_entities(window, core);
+    post_engine_event(EVENT_MAP_LOAD_PROGRESS, NULL, progress, core);
+
+    if (core->event.map_load_progress_cb)
+    {
+        core->event.map_load_progress_cb(window, core);
+    }
+}
+
+/* The previous map is unloaded one frame after the swap, so the frame
+ * that shows the new map doesn't pay for it.
+ */
+static void retire_map(esz_window_t* window, esz_core_t* core)
+{
+    esz_core_t retired = { 0 };
+
+    retired.map                        = core->retired_map;
+    retired.is_deferred_unload_enabled = core->is_deferred_unload_enabled;
+    retired.is_map_loaded              = true;
+    core->retired_map                  = NULL;
+
+    esz_unload_map(window, &retired);
+}
+
+// Textures are handed over to update_map_teardown().
+static void retire_map_textures(esz_window_t* window, esz_core_t* core)
+{
+    esz_map_t* map = core->map;
+
+    for (int32_t index = 0; index < ESZ_MAP_LAYER_LEVEL_MAX; index += 1)
+    {
+        retire_texture(map->layer_texture[index], window);
+        map->layer_texture[index] = NULL;
+    }
+
+    for (int32_t index = 0; index < ESZ_RENDER_LAYER_MAX; index += 1)
+    {
+        retire_texture(map->render_target[index], window);
+        map->render_target[index] = NULL;
+    }
+
+    retire_texture(map->animated_tile_texture, window);
+    map->animated_tile_texture = NULL;
+
+    for (int32_t index = 0; index < map->loaded_region_count; index += 1)
+    {
+        esz_map_region_t* region = &map->region[map->loaded_region[index]];
+
+        for (int32_t level = 0; level < ESZ_MAP_LAYER_LEVEL_MAX; level += 1)
+        {
+            retire_texture(region->texture[level], window);
+            region->texture[level] = NULL;
+        }
+    }
+
+    // Cached pages outlive the map.
+    for (int32_t index = 0; index < map->atlas.page_count; index += 1)
+    {
+        if (! is_page_cached(map->atlas.page[index].texture, window))
+        {
+            retire_texture(map->atlas.page[index].texture, window);
+            map->atlas.page[index].texture = NULL;
+        }
+    }
+}
+
+static void retire_texture(SDL_Texture* texture, esz_window_t* window)
+{
+    esz_map_teardown_t* teardown = &window->map_teardown;
+
+    if (! texture)
+    {
+        return;
+    }
+
+    if (teardown->texture_count == teardown->texture_limit)
+    {
+        int32_t       texture_limit = teardown->texture_limit ? teardown->texture_limit * 2 : 64;
+        SDL_Texture** texture_list  = (SDL_Texture**)realloc(teardown->texture, (size_t)texture_limit * sizeof(SDL_Texture*));
+
+        if (! texture_list)
+        {
+            plog_warn("%s: error allocating memory.", __func__);
+            SDL_DestroyTexture(texture);
+            return;
+        }
+
+        teardown->texture       = texture_list;
+        teardown->texture_limit = texture_limit;
+    }
+
+    teardown->texture[teardown->texture_count]  = texture;
+    teardown->texture_count                    += 1;
+}
+
+static esz_status start_map_loader(const char* map_file_name, bool is_staging, esz_window_t* window, esz_core_t* core)
+{
+    esz_map_loader_t* loader = &core->loader;
+    size_t            map_file_name_length;
+
+    if (loader->core)
+    {
+        plog_warn("A map is already being loaded.");
+        return ESZ_WARNING;
+    }
+
+    /* The worker thread loads the map into a private copy of the core,
+     * so the application can keep using the core in the meantime.
+     */
+    loader->core = (esz_core_t*)calloc(1, sizeof(struct esz_core));
+    if (! loader->core)
+    {
+        plog_error("%s: error allocating memory.", __func__);
+        return ESZ_WARNING;
+    }
+
+    loader->core->debug                    = core->debug;
+    loader->core->is_active                = core->is_active;
+    loader->core->is_atlas_cache_enabled   = core->is_atlas_cache_enabled;
+    loader->core->is_map_streaming_enabled = core->is_map_streaming_enabled;
+
+    map_file_name_length  = strlen(map_file_name) + 1;
+    loader->map_file_name = (char*)calloc(1, map_file_name_length);
+    if (! loader->map_file_name)
+    {
+        plog_error("%s: error allocating memory.", __func__);
+        discard_map_loader(core);
+        return ESZ_WARNING;
+    }
+    SDL_strlcpy(loader->map_file_name, map_file_name, map_file_name_length);
+
+    loader->window              = window;
+    loader->reported_progress   = -1;
+    loader->uploaded_page_count = 0;
+    loader->is_staged           = false;
+    loader->is_staging          = is_staging;
+    loader->is_swap_requested   = false;
+    SDL_AtomicSet(&loader->progress, 0);
+    SDL_AtomicSet(&loader->state, LOADER_RUNNING);
+
+    loader->thread = SDL_CreateThread(load_map_in_background, "esz_map_loader", loader);
+    if (! loader->thread)
+    {
+        plog_error("%s: %s.", __func__, SDL_GetError());
+        discard_map_loader(core);
+        return ESZ_WARNING;
+    }
+
+    plog_info("Load map file in the background: %s.", map_file_name);
+    return ESZ_OK;
+}
+
+static esz_status start_map_teardown(esz_map_t* map, esz_window_t* window)
+{
+    esz_map_teardown_t* teardown = &window->map_teardown;
+
+    // Only one map is torn down at a time.
+    if (teardown->thread)
+    {
+        SDL_WaitThread(teardown->thread, NULL);
+        teardown->thread = NULL;
+    }
+
+    teardown->map = map;
+    SDL_AtomicSet(&teardown->is_done, 0);
+
+    teardown->thread = SDL_CreateThread(unload_map_in_background, "esz_map_teardown", teardown);
+    if (! teardown->thread)
+    {
+        plog_error("%s: %s.", __func__, SDL_GetError());
+        teardown->map = NULL;
+        return ESZ_WARNING;
+    }
+
+    return ESZ_OK;
+}
+
+static void swap_staged_map(esz_window_t* window, esz_core_t* core)
+{
+    esz_map_loader_t* loader = &core->loader;
+
+    loader->is_swap_requested = false;
+
+    // Only one map is retired at a time.
+    if (core->retired_map)
+    {
+        retire_map(window, core);
+    }
+
+    if (esz_is_map_loaded(core))
+    {
+        core->retired_map = core->map;
+    }
+
+    core->map                    = loader->core->map;
+    core->load_stats             = loader->core->load_stats;
+    core->camera.is_locked       = loader->core->camera.is_locked;
+    core->camera.target_actor_id = loader->core->camera.target_actor_id;
+    core->is_map_loaded          = true;
+
+    loader->core->map           = NULL;
+    loader->core->is_map_loaded = false;
+    loader->is_staged           = false;
+
+    plog_info("Swap to staged map: %s.", loader->map_file_name);
+
+    // The watches belong to the old map; update_hot_reload() sets up new ones.
+    unwatch_map_files(core);
+
+    discard_map_loader(core);
+    SDL_AtomicSet(&loader->progress, MAP_LOADER_PROGRESS_MAX);
+
+    notify_map_loaded(window, core);
+}
+
+static int unload_map_in_background(void* data)
+{
+    esz_map_teardown_t* teardown = (esz_map_teardown_t*)data;
+    esz_core_t          core     = { 0 };
+
+    core.map = teardown->map;
+    free_map_data(&core);
+
+    teardown->map = NULL;
+    SDL_AtomicSet(&teardown->is_done, 1);
+
+    return 0;
+}
+
+/* Called once per frame while a map is loaded in the background.  Once
+ * the worker is done, the atlas pages are uploaded in time-sliced
+ * batches before the map is handed over to the core.
+ */
+static void update_map_loader(esz_window_t* window, esz_core_t* core)
+{
+    esz_map_loader_t* loader = &core->loader;
+    esz_atlas_t*      atlas;
+    uint32_t          start;
+    uint64_t          stage_start;
+    uint64_t          start_bytes;
+    int               state  = SDL_AtomicGet(&loader->state);
+
+    if (LOADER_RUNNING == state)
+    {
+        report_map_load_progress(window, core);
+        return;
+    }
+
+    if (loader->thread)
+    {
+        // Let the loader stop at the next stage instead of finishing it.
+        SDL_AtomicSet(&loader->cancelled, 1);
+        SDL_WaitThread(loader->thread, NULL);
+        loader->thread = NULL;
+    }
+
+    if (LOADER_FAILED == state)
+    {
+        plog_error("%s: could not load %s.", __func__, loader->map_file_name);
+        discard_map_loader(core);
+        return;
+    }
+
+    atlas       = &loader->core->map->atlas;
+    start       = SDL_GetTicks();
+    stage_start = SDL_GetPerformanceCounter();
+    start_bytes = get_allocated_bytes();
+
+    while (loader->uploaded_page_count < atlas->page_count)
+    {
+        if (ESZ_OK != upload_atlas_page(loader->uploaded_page_count, atlas, window))
+        {
+            discard_map_loader(core);
+            return;
+        }
+
+        loader->uploaded_page_count += 1;
+        SDL_AtomicSet(&loader->progress, 700 + (250 * loader->uploaded_page_count / atlas->page_count));
+
+        if (SDL_GetTicks() - start >= MAP_LOADER_UPLOAD_BUDGET && loader->uploaded_page_count < atlas->page_count)
+        {
+            record_load_stage(ESZ_STAGE_TEXTURE_ATLAS, &stage_start, &start_bytes, loader->core);
+            report_map_load_progress(window, core);
+            return;
+        }
+    }
+    free_atlas_pixels(atlas);
+    store_cached_atlas(atlas, window);
+    record_load_stage(ESZ_STAGE_TEXTURE_ATLAS, &stage_start, &start_bytes, loader->core);
+
+    if (loader->is_staging)
+    {
+        if (ESZ_OK != load_map_resources(window, loader->core))
+        {
+            discard_map_loader(core);
+            return;
+        }
+
+        loader->is_staged = true;
+        SDL_AtomicSet(&loader->progress, MAP_LOADER_PROGRESS_MAX);
+        report_map_load_progress(window, core);
+
+        plog_info("Stage map file: %s.", loader->map_file_name);
+        return;
+    }
+
+    // Hand the map over to the core, along with the camera set up for its player.
+    core->map                    = loader->core->map;
+    core->load_stats             = loader->core->load_stats;
+    core->camera.is_locked       = loader->core->camera.is_locked;
+    core->camera.target_actor_id = loader->core->camera.target_actor_id;
+    core->is_map_loaded          = true;
+
+    loader->core->map           = NULL;
+    loader->core->is_map_loaded = false;
+    plog_info(
+        "Load map file: %s containing %d entities(s).",
+        loader->map_file_name, core->map->entity_count);
+
+    discard_map_loader(core);
+    SDL_AtomicSet(&loader->progress, 950);
+
+    if (ESZ_OK != load_map_resources(window, core))
+    {
+        esz_unload_map(window, core);
+        return;
+    }
+
+    report_map_load_progress(window, core);
+    notify_map_loaded(window, core);
 }
 
 DISABLE_WARNING_POP
+
+static void update_map_teardown(esz_window_t* window)
+{
+    esz_map_teardown_t* teardown = &window->map_teardown;
+    uint32_t            start    = SDL_GetTicks();
+
+    if (teardown->thread && SDL_AtomicGet(&teardown->is_done))
+    {
+        SDL_WaitThread(teardown->thread, NULL);
+        teardown->thread = NULL;
+    }
+
+    // At least one texture per frame, however long it takes.
+    while (0 < teardown->texture_count)
+    {
+        teardown->texture_count -= 1;
+        SDL_DestroyTexture(teardown->texture[teardown->texture_count]);
+
+        if (SDL_GetTicks() - start >= MAP_TEARDOWN_BUDGET)
+        {
+            break;
+        }
+    }
+}
@@ -8,6 +8,7 @@
 #define ESZ_H
 
 #include <stdbool.h>
+#include <stddef.h>
 #include <stdint.h>
 #include "esz_types.h"
 
@@ -32,6 +33,9 @@ void esz_clear_player_state(esz_state state, esz_core_t* core);
  * @brief   Create window and rendering context
  * @details It tries to use the opengl rendering driver. If the driver
  *          is not found, the system's default driver is used instead.
+ *          If premultiplied alpha is enabled in the configuration,
+ *          all images are premultiplied when they are decoded and
+ *          every texture and render target is blended accordingly.
  * @param   window_title The window title
  * @param   config Initial window configuration
  * @param   window Pointer to window handle
@@ -65,6 +69,114 @@ void esz_destroy_core(esz_core_t* core);
  */
 void esz_destroy_window(esz_window_t* window);
 
+/**
+ * @brief Disable the texture atlas cache
+ * @param core Engine core
+ */
+void esz_disable_atlas_cache(esz_core_t* core);
+
+/**
+ * @brief Disable deferred unloading
+ * @param core Engine core
+ */
+void esz_disable_deferred_unload(esz_core_t* core);
+
+/**
+ * @brief Disable hot reloading
+ * @param core Engine core
+ */
+void esz_disable_hot_reload(esz_core_t* core);
+
+/**
+ * @brief Disable the input latency overlay
+ * @param core Engine core
+ */
+void esz_disable_latency_overlay(esz_core_t* core);
+
+/**
+ * @brief Disable map streaming
+ * @param core Engine core
+ */
+void esz_disable_map_streaming(esz_core_t* core);
+
+/**
+ * @brief   Dispatch deferred events
+ * @details Calls the deferred subscribers of every event processed
+ *          since the last call, e.g. after drawing the frame.  Events
+ *          that are still pending when esz_update_core() is called
+ *          again are dispatched there.
+ * @param   window Window handle
+ * @param   core Engine core
+ */
+void esz_dispatch_events(esz_window_t* window, esz_core_t* core);
+
+/**
+ * @brief   Enable the texture atlas cache
+ * @details If enabled, the texture atlas that is packed while loading a
+ *          map is written next to the map file (e.g. city.json.atlas)
+ *          and read back on subsequent loads instead of decoding every
+ *          image again.  The cache is rebuilt automatically as soon as
+ *          one of the images changes.
+ * @param   core Engine core
+ */
+void esz_enable_atlas_cache(esz_core_t* core);
+
+/**
+ * @brief   Enable deferred unloading
+ * @details If enabled, esz_unload_map() returns without tearing the map
+ *          down on the caller's frame: the memory held by the map is
+ *          freed on a worker thread, and its textures are destroyed
+ *          over the following frames by esz_update_core(), spending at
+ *          most 2 ms per frame on it.  Map switches, including swaps to
+ *          a staged map, no longer pay for the unload in a single
+ *          frame.
+ * @param   core Engine core
+ */
+void esz_enable_deferred_unload(esz_core_t* core);
+
+/**
+ * @brief     Enable hot reloading
+ * @details   Intended for development: the file of the loaded map and
+ *            the images it references are watched for changes.  Edited
+ *            images are uploaded over their old region of the texture
+ *            atlas, edited tile layers are swapped in place, and only
+ *            the layers (or regions, if map streaming is enabled) that
+ *            show a changed tile are baked again.  Actors keep their
+ *            position, velocity and animation as long as their object
+ *            ID still exists.  Changes to the map size, the tilesets
+ *            or the set of images, as well as images that changed size,
+ *            cause the map to be reloaded from scratch.
+ * @attention Only supported on Linux.  Files inside a mounted asset
+ *            pack are not watched.
+ * @param     core Engine core
+ */
+void esz_enable_hot_reload(esz_core_t* core);
+
+/**
+ * @brief   Enable the input latency overlay
+ * @details Draws the median, 90th and 99th percentile of the input
+ *          latency as green, yellow and red bars in the upper-left
+ *          corner of the screen, at two pixels per millisecond.  The
+ *          white ticks below mark the length of one frame.
+ * @param   core Engine core
+ */
+void esz_enable_latency_overlay(esz_core_t* core);
+
+/**
+ * @brief   Enable map streaming
+ * @details Maps loaded afterwards are split into regions of 32x32
+ *          tiles.  Instead of baking every tile layer into one map
+ *          sized texture, only the regions around the camera are
+ *          baked, a few at a time, and regions the camera has left
+ *          behind are evicted again.  Visible regions that are not
+ *          baked yet are drawn tile by tile.  The map data itself is
+ *          kept in memory.  Entities entering or leaving the loaded
+ *          regions raise EVENT_ENTITY_ENTERED_REGION and
+ *          EVENT_ENTITY_LEFT_REGION.
+ * @param   core Engine core
+ */
+void esz_enable_map_streaming(esz_core_t* core);
+
 /**
  * @brief  Get boolean map property
  * @param  name_hash Hash of the property name.
@@ -81,6 +193,50 @@ bool esz_get_boolean_map_property(const uint64_t name_hash, esz_core_t* core);
  */
 double esz_get_decimal_map_property(const uint64_t name_hash, esz_core_t* core);
 
+/**
+ * @brief  Get the entity that raised the current event
+ * @param  core Engine core
+ * @return Entity ID, only valid during EVENT_ENTITY_ENTERED_REGION and
+ *         EVENT_ENTITY_LEFT_REGION callbacks
+ */
+int32_t esz_get_event_entity_id(esz_core_t* core);
+
+/**
+ * @brief     Get frame phase statistics
+ * @details   Contains the average, the 95th and 99th percentile and the
+ *            maximum time in milliseconds spent in the given phase over
+ *            the last 128 frames.  A frame ends when esz_show_scene()
+ *            has presented it; phases that did not run in a frame, e.g.
+ *            while no map is loaded, count as 0 ms.
+ * @attention Only available if the engine has been built with
+ *            USE_PROFILER enabled, otherwise no frames are recorded.
+ * @param     phase Frame phase
+ * @param     core Engine core
+ * @return    Frame phase statistics
+ */
+esz_frame_phase_stats_t esz_get_frame_phase_stats(const esz_frame_phase phase, esz_core_t* core);
+
+/**
+ * @brief   Get input latency statistics
+ * @details Every key, finger and gesture event is timestamped when it
+ *          is queued by SDL and measured up to the return of
+ *          SDL_RenderPresent() in the frame that shows its effect,
+ *          i.e. the first frame drawn once the action, state or
+ *          velocity of the player has been changed by an input
+ *          callback or the application.  Changes made by the physics
+ *          update, such as gravity, don't count.  Contains the median,
+ *          90th and 99th percentile and the maximum in milliseconds
+ *          over the last 256 samples, as well as the number of the
+ *          frame that presented the most recent input.  Key repeats
+ *          and inputs that don't affect the player within eight frames
+ *          are not counted.
+ * @note    The time until the display actually scans out the frame is
+ *          not included.
+ * @param   core Engine core
+ * @return  Input latency statistics
+ */
+esz_input_latency_stats_t esz_get_input_latency_stats(esz_core_t* core);
+
 /**
  * @brief  Get integer map property
  * @param  name_hash Hash of the property name.
@@ -89,6 +245,35 @@ double esz_get_decimal_map_property(const uint64_t name_hash, esz_core_t* core);
  */
 int32_t esz_get_integer_map_property(const uint64_t name_hash, esz_core_t* core);
 
+/**
+ * @brief  Get progress of the map that is currently loaded
+ * @param  core Engine core
+ * @return Progress between 0.0 and 1.0
+ */
+double esz_get_map_load_progress(esz_core_t* core);
+
+/**
+ * @brief   Get loading statistics of the current map
+ * @details Contains the time in milliseconds and the number of bytes
+ *          allocated for each loading stage, the time spent baking the
+ *          map layers, the number of baked tiles and the number of draw
+ *          calls that were required to do so.  The map layers are
+ *          baked when they are rendered for the first time.
+ * @param   core Engine core
+ * @return  Map loading statistics
+ */
+esz_map_load_stats_t esz_get_map_load_stats(esz_core_t* core);
+
+/**
+ * @brief   Get render statistics of the last rendered frame
+ * @details Contains the number of actors that have been drawn and the
+ *          number of actors that have been culled because they were
+ *          outside of the viewport.
+ * @param   core Engine core
+ * @return  Render statistics
+ */
+esz_render_stats_t esz_get_render_stats(esz_core_t* core);
+
 /**
  * @brief  Get string or file type map property
  * @param  name_hash Hash of the property name.
@@ -115,9 +300,13 @@ const uint8_t* esz_get_keyboard_state(void);
 int32_t esz_get_keycode(esz_core_t* core);
 
 /**
- * @brief  Get the time since the last frame in seconds
- * @param  window Window handle
- * @return Time since last frame in seconds
+ * @brief   Get the time since the last frame in seconds
+ * @details Measured by esz_update_core() with the performance counter,
+ *          including the time a frame has been delayed to match the
+ *          refresh rate when vsync is off.  Capped at 0.1 seconds, so
+ *          a long hitch does not make everything jump ahead.
+ * @param   window Window handle
+ * @return  Time since last frame in seconds
  */
 double esz_get_time_since_last_frame(esz_window_t* window);
 
@@ -163,6 +352,24 @@ bool esz_is_core_active(esz_core_t* core);
  */
 bool esz_is_map_loaded(esz_core_t* core);
 
+/**
+ * @brief  Check if a map is currently loaded in the background
+ * @param  core Engine core
+ * @return Boolean condition
+ * @retval true Map is being loaded
+ * @retval false No map is being loaded
+ */
+bool esz_is_map_loading(esz_core_t* core);
+
+/**
+ * @brief  Check if a map has been staged and is ready to be swapped in
+ * @param  core Engine core
+ * @return Boolean condition
+ * @retval true A staged map is ready
+ * @retval false No map has been staged
+ */
+bool esz_is_map_staged(esz_core_t* core);
+
 /**
  * @brief  Check if the active player actor is currently moving
  * @param  core Engine core
@@ -183,6 +390,24 @@ bool esz_is_player_moving(esz_core_t* core);
  */
 esz_status esz_load_map(const char* map_file_name, esz_window_t* window, esz_core_t* core);
 
+/**
+ * @brief     Load map file in the background
+ * @details   Parsing and image decoding run on a worker thread; the
+ *            texture uploads are spread over the following calls of
+ *            esz_update_core().  EVENT_MAP_LOAD_PROGRESS is raised
+ *            whenever the progress changes and EVENT_MAP_LOADED once
+ *            the map is ready.
+ * @attention Before calling this function, make sure that the engine
+ *            core has been initialised!
+ * @param     map_file_name Path and file name to the map file
+ * @param     window Window handle
+ * @param     core Engine core
+ * @return    Status code
+ * @retval    ESZ_OK OK
+ * @retval    ESZ_WARNING Loading the map could not be started
+ */
+esz_status esz_load_map_async(const char* map_file_name, esz_window_t* window, esz_core_t* core);
+
 /**
  * @brief   Lock camera for engine core
  * @details If the camera is locked, it automatically follows the main
@@ -191,6 +416,43 @@ esz_status esz_load_map(const char* map_file_name, esz_window_t* window, esz_cor
  */
 void esz_lock_camera(esz_core_t* core);
 
+/**
+ * @brief   Mount asset pack
+ * @details Once mounted, images are looked up in the pack before they
+ *          are read from disk.  Asset packs are generated with the
+ *          eszpack tool.
+ * @param   pack_file_name Path and file name to the asset pack
+ * @param   window Window handle
+ * @return  Status code
+ * @retval  ESZ_OK OK
+ * @retval  ESZ_WARNING Asset pack could not be mounted
+ */
+esz_status esz_mount_asset_pack(const char* pack_file_name, esz_window_t* window);
+
+/**
+ * @brief   Post event
+ * @details Engine events are posted by eszFW itself; EVENT_USER is
+ *          meant for the application.  Events are timestamped and
+ *          queued without blocking and are dispatched during the next
+ *          call of esz_update_core().
+ * @remark  This function is thread-safe and can be called from worker
+ *          threads.
+ * @param   event_type Event type
+ * @param   value Value passed on to the subscribers
+ * @param   data Pointer passed on to the subscribers
+ * @param   core Engine core
+ * @return  False if the event queue is full and the event was dropped,
+ *          otherwise true
+ */
+bool esz_post_event(const esz_event_type event_type, int32_t value, void* data, esz_core_t* core);
+
+/**
+ * @brief  Purge texture cache
+ * @remark Textures of maps that are currently loaded are kept.
+ * @param  window Window handle
+ */
+void esz_purge_texture_cache(esz_window_t* window);
+
 /**
  * @brief Register callback function which is called when the event
  *        occurs
@@ -249,6 +511,17 @@ void esz_set_player_animation(int32_t id, esz_core_t* core);
  */
 void esz_set_player_state(esz_state state, esz_core_t* core);
 
+/**
+ * @brief   Set the texture cache budget
+ * @details Texture atlas pages of unloaded maps are kept until the
+ *          cache exceeds its budget, and are then released in least
+ *          recently used order.  The default budget is 256 MiB; with a
+ *          budget of 0 no pages are retained at all.
+ * @param   budget Budget in bytes
+ * @param   window Window handle
+ */
+void esz_set_texture_cache_budget(const size_t budget, esz_window_t* window);
+
 /**
  * @brief  Set the window's zoom level
  * @param  factor Zoom factor
@@ -278,6 +551,89 @@ void esz_show_render_layer(esz_render_layer layer, esz_core_t* core);
  */
 esz_status esz_show_scene(esz_window_t* window, esz_core_t* core);
 
+/**
+ * @brief     Stage map file in the background
+ * @details   Works like esz_load_map_async(), but the current map keeps
+ *            running while the new one is loaded.  Once
+ *            esz_is_map_staged() returns true, the staged map can be
+ *            made current with esz_swap_map().
+ * @attention Before calling this function, make sure that the engine
+ *            core has been initialised!
+ * @param     map_file_name Path and file name to the map file
+ * @param     window Window handle
+ * @param     core Engine core
+ * @return    Status code
+ * @retval    ESZ_OK OK
+ * @retval    ESZ_WARNING Staging the map could not be started
+ */
+esz_status esz_stage_map(const char* map_file_name, esz_window_t* window, esz_core_t* core);
+
+/**
+ * @brief     Start recording a trace
+ * @details   Records the loading stages, the phases of every frame and
+ *            the texture uploads, along with the allocated memory and
+ *            the number of drawn actors as counters, into a buffer of
+ *            262144 events.  The trace is written to the given file as
+ *            Chrome trace JSON, which can be opened in
+ *            chrome://tracing or https://ui.perfetto.dev, when
+ *            esz_write_trace() or esz_stop_trace() is called and when
+ *            the window is destroyed.
+ * @attention Only available if the engine has been built with
+ *            USE_TRACING enabled.
+ * @param     file_name Path and file name of the trace file
+ * @return    Status code
+ * @retval    ESZ_OK OK
+ * @retval    ESZ_WARNING
+ *            Tracing is not available or a trace is already being
+ *            recorded
+ * @retval    ESZ_ERROR_CRITICAL
+ *            Critical error; the application should be terminated
+ */
+esz_status esz_start_trace(const char* file_name);
+
+/**
+ * @brief  Stop recording the trace and write it
+ * @return Status code
+ * @retval ESZ_OK OK
+ * @retval ESZ_WARNING The trace could not be written
+ */
+esz_status esz_stop_trace(void);
+
+/**
+ * @brief   Subscribe to event
+ * @details Any number of handlers can subscribe to the same event type.
+ *          Inline handlers are called during esz_update_core(), right
+ *          after the input has been polled; deferred handlers when the
+ *          application calls esz_dispatch_events().  Subscribing the
+ *          same handler and userdata again only changes the mode.
+ * @remark  The event's value is the entity ID for
+ *          EVENT_ENTITY_ENTERED_REGION and EVENT_ENTITY_LEFT_REGION and
+ *          the progress for EVENT_MAP_LOAD_PROGRESS; input events carry
+ *          a copy of the SDL event.
+ * @param   event_type Event type
+ * @param   handler Handler function
+ * @param   userdata Pointer passed on to the handler
+ * @param   mode DISPATCH_INLINE or DISPATCH_DEFERRED
+ * @param   core Engine core
+ * @return  Status code
+ * @retval  ESZ_OK OK
+ * @retval  ESZ_ERROR_CRITICAL
+ *          Critical error; the application should be terminated
+ */
+esz_status esz_subscribe_event(const esz_event_type event_type, esz_event_handler handler, void* userdata, const esz_dispatch_mode mode, esz_core_t* core);
+
+/**
+ * @brief   Swap the staged map in
+ * @details The staged map becomes current at the beginning of the next
+ *          call of esz_update_core() and EVENT_MAP_LOADED is raised.
+ *          The previous map is unloaded during the following frame.
+ * @param   core Engine core
+ * @return  Status code
+ * @retval  ESZ_OK OK
+ * @retval  ESZ_WARNING No map has been staged
+ */
+esz_status esz_swap_map(esz_core_t* core);
+
 /**
  * @brief  Toggle between fullscreen and windowed mode
  * @param  window Window handle
@@ -311,6 +667,24 @@ void esz_unload_map(esz_window_t* window, esz_core_t* core);
  */
 void esz_unlock_camera(esz_core_t* core);
 
+/**
+ * @brief  Unmount asset pack
+ * @remark It's always safe to call this function; if no asset pack is
+ *         mounted, the function does nothing.
+ * @param  window Window handle
+ */
+void esz_unmount_asset_pack(esz_window_t* window);
+
+/**
+ * @brief  Unsubscribe from event
+ * @remark Handlers can unsubscribe themselves while being called.
+ * @param  event_type Event type
+ * @param  handler Handler function
+ * @param  userdata Pointer given when subscribing
+ * @param  core Engine core
+ */
+void esz_unsubscribe_event(const esz_event_type event_type, esz_event_handler handler, void* userdata, esz_core_t* core);
+
 /**
  * @brief   Update engine core
  * @details This function should be called cyclically in the main loop
@@ -320,4 +694,28 @@ void esz_unlock_camera(esz_core_t* core);
  */
 void esz_update_core(esz_window_t* window, esz_core_t* core);
 
+/**
+ * @brief   Write loading statistics of the current map as JSON line
+ * @details Appends one JSON object per call, so the file can be used
+ *          to track load times and memory usage across builds.
+ * @param   file_name Path and file name of the output file; if NULL,
+ *          the line is written to stdout
+ * @param   core Engine core
+ * @return  Status code
+ * @retval  ESZ_OK OK
+ * @retval  ESZ_WARNING The statistics could not be written
+ */
+esz_status esz_write_map_load_stats(const char* file_name, esz_core_t* core);
+
+/**
+ * @brief   Write the trace recorded so far
+ * @details The trace keeps being recorded; each call overwrites the
+ *          file given to esz_start_trace().
+ * @return  Status code
+ * @retval  ESZ_OK OK
+ * @retval  ESZ_WARNING
+ *          No trace is being recorded or it could not be written
+ */
+esz_status esz_write_trace(void);
+
 #endif // ESZ_H
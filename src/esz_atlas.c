@@ -0,0 +1,819 @@
+// SPDX-License-Identifier: MIT
+/**
+ * @file    esz_atlas.c
+ * @brief   eszFW texture atlas
+ * @details Skyline bottom-left packer based on
+ *          http://pds25.egloos.com/pds/201504/21/98/RectangleBinPack.pdf
+ */
+
+#include <picolog.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+
+#include "esz_macros.h"
+
+DISABLE_WARNING_PUSH
+DISABLE_WARNING_PADDING
+DISABLE_WARNING_SPECTRE_MITIGATION
+DISABLE_WARNING_SYMBOL_NOT_DEFINED
+
+#include <SDL.h>
+
+DISABLE_WARNING_POP
+
+#include "esz_atlas.h"
+#include "esz_trace.h"
+#include "esz_types.h"
+#include "esz_utils.h"
+
+#define ATLAS_FILE_MAGIC     "ESZATLAS"
+#define ATLAS_FILE_VERSION   3
+#define ATLAS_MAX_PAGE_SIZE  4096
+#define ATLAS_PADDING        1
+
+typedef struct skyline_node
+{
+    int32_t x;
+    int32_t y;
+    int32_t width;
+
+} skyline_node_t;
+
+typedef struct skyline
+{
+    skyline_node_t* node;
+    int32_t         node_count;
+    int32_t         width;
+    int32_t         height;
+    int32_t         used_width;
+    int32_t         used_height;
+
+} skyline_t;
+
+static int        compare_image_height(const void* image_a, const void* image_b);
+static esz_status create_skyline(int32_t width, int32_t height, skyline_t* skyline);
+static bool       skyline_fit(int32_t index, int32_t width, int32_t height, int32_t* pos_y, skyline_t* skyline);
+static bool       skyline_insert(int32_t width, int32_t height, SDL_Rect* rect, skyline_t* skyline);
+
+void destroy_atlas(esz_atlas_t* atlas)
+{
+    if (atlas->page)
+    {
+        for (int32_t index = 0; index < atlas->page_count; index += 1)
+        {
+            if (atlas->page[index].texture)
+            {
+                SDL_DestroyTexture(atlas->page[index].texture);
+                atlas->page[index].texture = NULL;
+            }
+        }
+    }
+
+    free_atlas_pixels(atlas);
+    free(atlas->page);
+    free(atlas->region);
+
+    atlas->page         = NULL;
+    atlas->region       = NULL;
+    atlas->page_count   = 0;
+    atlas->region_count = 0;
+}
+
+void free_atlas_pixels(esz_atlas_t* atlas)
+{
+    if (! atlas->page)
+    {
+        return;
+    }
+
+    for (int32_t index = 0; index < atlas->page_count; index += 1)
+    {
+        free(atlas->page[index].pixels);
+        atlas->page[index].pixels = NULL;
+    }
+}
+
+uint64_t generate_atlas_key(esz_image_t* image, int32_t image_count)
+{
+    uint64_t key = 5381;
+
+    for (int32_t index = 0; index < image_count; index += 1)
+    {
+        key = ((key << 5) + key) ^ image[index].key;
+    }
+
+    return key;
+}
+
+uint64_t generate_image_key(esz_image_t* image)
+{
+    struct stat file_info;
+    uint64_t    key = image->hash;
+
+    /* Include the file's modification time and size, so that the key
+     * changes whenever the source image is edited.
+     */
+    if (0 == stat(image->file_name, &file_info))
+    {
+        key = ((key << 5) + key) ^ (uint64_t)file_info.st_mtime;
+        key = ((key << 5) + key) ^ (uint64_t)file_info.st_size;
+    }
+
+    return key;
+}
+
+bool get_atlas_region(const uint64_t hash, int32_t* page, SDL_Rect* rect, esz_atlas_t* atlas)
+{
+    for (int32_t index = 0; index < atlas->region_count; index += 1)
+    {
+        if (hash == atlas->region[index].hash)
+        {
+            *page = atlas->region[index].page;
+            *rect = atlas->region[index].rect;
+            return true;
+        }
+    }
+
+    return false;
+}
+
+/* Appends the pages and regions of another atlas, which is left empty.
+ * On failure both atlases are left untouched.
+ */
+esz_status merge_atlas(esz_atlas_t* atlas, esz_atlas_t* other)
+{
+    esz_atlas_page_t*   page;
+    esz_atlas_region_t* region;
+
+    if (0 >= other->page_count)
+    {
+        return ESZ_OK;
+    }
+
+    page = (esz_atlas_page_t*)realloc_counted(atlas->page, (size_t)atlas->page_count * sizeof(struct esz_atlas_page), (size_t)(atlas->page_count + other->page_count) * sizeof(struct esz_atlas_page));
+    if (! page)
+    {
+        plog_error("%s: error allocating memory.", __func__);
+        return ESZ_ERROR_CRITICAL;
+    }
+    atlas->page = page;
+
+    region = (esz_atlas_region_t*)realloc_counted(atlas->region, (size_t)atlas->region_count * sizeof(struct esz_atlas_region), (size_t)(atlas->region_count + other->region_count) * sizeof(struct esz_atlas_region));
+    if (! region)
+    {
+        plog_error("%s: error allocating memory.", __func__);
+        return ESZ_ERROR_CRITICAL;
+    }
+    atlas->region = region;
+
+    SDL_memcpy(&atlas->page[atlas->page_count], other->page, (size_t)other->page_count * sizeof(struct esz_atlas_page));
+
+    for (int32_t index = 0; index < other->region_count; index += 1)
+    {
+        atlas->region[atlas->region_count + index]       = other->region[index];
+        atlas->region[atlas->region_count + index].page += atlas->page_count;
+    }
+
+    atlas->format        = other->format;
+    atlas->page_count   += other->page_count;
+    atlas->region_count += other->region_count;
+
+    free(other->page);
+    free(other->region);
+    SDL_memset(other, 0, sizeof(struct esz_atlas));
+
+    return ESZ_OK;
+}
+
+esz_status pack_atlas(esz_image_t* image, int32_t image_count, esz_atlas_t* atlas, esz_window_t* window)
+{
+    esz_status        status         = ESZ_OK;
+    esz_image_t**     sorted_image   = NULL;
+    skyline_t*        skyline        = NULL;
+    int32_t           skyline_count  = 0;
+    int32_t           max_width      = ATLAS_MAX_PAGE_SIZE;
+    int32_t           max_height     = ATLAS_MAX_PAGE_SIZE;
+
+    if (0 >= image_count)
+    {
+        return ESZ_OK;
+    }
+
+    // Queried once at window creation; the renderer is not thread-safe.
+    if (0 < window->max_texture_width && max_width > window->max_texture_width)
+    {
+        max_width = window->max_texture_width;
+    }
+
+    if (0 < window->max_texture_height && max_height > window->max_texture_height)
+    {
+        max_height = window->max_texture_height;
+    }
+
+    atlas->region       = (esz_atlas_region_t*)calloc_counted((size_t)image_count, sizeof(struct esz_atlas_region));
+    sorted_image        = (esz_image_t**)calloc_counted((size_t)image_count, sizeof(esz_image_t*));
+    skyline             = (skyline_t*)calloc_counted((size_t)image_count, sizeof(skyline_t));
+    atlas->region_count = image_count;
+
+    if (! atlas->region || ! sorted_image || ! skyline)
+    {
+        plog_error("%s: error allocating memory.", __func__);
+        status = ESZ_ERROR_CRITICAL;
+        goto exit;
+    }
+
+    /* Packing the tallest images first leaves less unused space
+     * beneath the skyline.
+     */
+    for (int32_t index = 0; index < image_count; index += 1)
+    {
+        sorted_image[index] = &image[index];
+    }
+    qsort(sorted_image, (size_t)image_count, sizeof(esz_image_t*), compare_image_height);
+
+    for (int32_t index = 0; index < image_count; index += 1)
+    {
+        esz_image_t*        current_image = sorted_image[index];
+        esz_atlas_region_t* region        = &atlas->region[current_image - image];
+        int32_t             width         = current_image->width  + ATLAS_PADDING;
+        int32_t             height        = current_image->height + ATLAS_PADDING;
+        bool                is_placed     = false;
+
+        region->hash = current_image->hash;
+        region->key  = current_image->key;
+
+        for (int32_t page = 0; page < skyline_count; page += 1)
+        {
+            if (skyline_insert(width, height, &region->rect, &skyline[page]))
+            {
+                region->page = page;
+                is_placed    = true;
+                break;
+            }
+        }
+
+        if (! is_placed)
+        {
+            /* Images that exceed the maximum page size get a page of
+             * their own.
+             */
+            status = create_skyline(SDL_max(max_width, width), SDL_max(max_height, height), &skyline[skyline_count]);
+            if (ESZ_OK != status)
+            {
+                goto exit;
+            }
+
+            skyline_insert(width, height, &region->rect, &skyline[skyline_count]);
+            region->page   = skyline_count;
+            skyline_count += 1;
+        }
+
+        region->rect.w = current_image->width;
+        region->rect.h = current_image->height;
+    }
+
+    atlas->page = (esz_atlas_page_t*)calloc_counted((size_t)skyline_count, sizeof(struct esz_atlas_page));
+    if (! atlas->page)
+    {
+        plog_error("%s: error allocating memory.", __func__);
+        status = ESZ_ERROR_CRITICAL;
+        goto exit;
+    }
+    atlas->page_count = skyline_count;
+    atlas->format     = window->texture_format;
+
+    for (int32_t page = 0; page < skyline_count; page += 1)
+    {
+        atlas->page[page].width  = skyline[page].used_width;
+        atlas->page[page].height = skyline[page].used_height;
+        atlas->page[page].pixels = (unsigned char*)calloc_counted((size_t)atlas->page[page].width * (size_t)atlas->page[page].height, 4);
+
+        if (! atlas->page[page].pixels)
+        {
+            plog_error("%s: error allocating memory.", __func__);
+            status = ESZ_ERROR_CRITICAL;
+            goto exit;
+        }
+    }
+
+    for (int32_t index = 0; index < image_count; index += 1)
+    {
+        esz_atlas_region_t* region     = &atlas->region[index];
+        esz_atlas_page_t*   page       = &atlas->page[region->page];
+        int32_t             page_pitch = page->width * 4;
+
+        // Convert straight into the page, so it can be uploaded as is.
+        if (0 > SDL_ConvertPixels(
+                image[index].width,
+                image[index].height,
+                SDL_PIXELFORMAT_RGBA32,
+                image[index].pixels,
+                image[index].width * 4,
+                atlas->format,
+                page->pixels + ((size_t)region->rect.y * (size_t)page_pitch) + ((size_t)region->rect.x * 4),
+                page_pitch))
+        {
+            plog_error("%s: %s.", __func__, SDL_GetError());
+            status = ESZ_ERROR_CRITICAL;
+            goto exit;
+        }
+    }
+
+    plog_info("Pack %d image(s) into %d texture atlas page(s).", image_count, atlas->page_count);
+
+exit:
+    if (skyline)
+    {
+        for (int32_t page = 0; page < skyline_count; page += 1)
+        {
+            free(skyline[page].node);
+        }
+    }
+
+    free(skyline);
+    free(sorted_image);
+
+    return status;
+}
+
+esz_status read_atlas_file(const char* file_name, const uint64_t key, const uint32_t format, esz_atlas_t* atlas)
+{
+    esz_status status              = ESZ_OK;
+    char       magic[8]            = { 0 };
+    uint32_t   version             = 0;
+    uint32_t   file_format         = 0;
+    int32_t    page_count          = 0;
+    int32_t    region_count        = 0;
+    uint64_t   file_key            = 0;
+    FILE*      fp                  = fopen(file_name, "rb");
+
+    if (! fp)
+    {
+        return ESZ_WARNING;
+    }
+
+    if (1 != fread(magic,         sizeof(magic),        1, fp) ||
+        1 != fread(&version,      sizeof(version),      1, fp) ||
+        1 != fread(&file_format,  sizeof(file_format),  1, fp) ||
+        1 != fread(&page_count,   sizeof(page_count),   1, fp) ||
+        1 != fread(&region_count, sizeof(region_count), 1, fp) ||
+        1 != fread(&file_key,     sizeof(file_key),     1, fp))
+    {
+        status = ESZ_WARNING;
+        goto exit;
+    }
+
+    if (0 != memcmp(magic, ATLAS_FILE_MAGIC, sizeof(magic)) || ATLAS_FILE_VERSION != version || key != file_key || format != file_format)
+    {
+        plog_info("Texture atlas cache %s is outdated.", file_name);
+        status = ESZ_WARNING;
+        goto exit;
+    }
+
+    if (0 >= page_count || 0 >= region_count)
+    {
+        status = ESZ_WARNING;
+        goto exit;
+    }
+
+    atlas->page   = (esz_atlas_page_t*)calloc_counted((size_t)page_count, sizeof(struct esz_atlas_page));
+    atlas->region = (esz_atlas_region_t*)calloc_counted((size_t)region_count, sizeof(struct esz_atlas_region));
+
+    if (! atlas->page || ! atlas->region)
+    {
+        plog_error("%s: error allocating memory.", __func__);
+        status = ESZ_ERROR_CRITICAL;
+        goto exit;
+    }
+
+    atlas->format       = file_format;
+    atlas->page_count   = page_count;
+    atlas->region_count = region_count;
+
+    for (int32_t index = 0; index < region_count; index += 1)
+    {
+        esz_atlas_region_t* region = &atlas->region[index];
+
+        if (1 != fread(&region->hash,   sizeof(region->hash),   1, fp) ||
+            1 != fread(&region->key,    sizeof(region->key),    1, fp) ||
+            1 != fread(&region->page,   sizeof(region->page),   1, fp) ||
+            1 != fread(&region->rect.x, sizeof(region->rect.x), 1, fp) ||
+            1 != fread(&region->rect.y, sizeof(region->rect.y), 1, fp) ||
+            1 != fread(&region->rect.w, sizeof(region->rect.w), 1, fp) ||
+            1 != fread(&region->rect.h, sizeof(region->rect.h), 1, fp))
+        {
+            status = ESZ_WARNING;
+            goto exit;
+        }
+
+        if (0 > region->page || page_count <= region->page)
+        {
+            status = ESZ_WARNING;
+            goto exit;
+        }
+    }
+
+    for (int32_t index = 0; index < page_count; index += 1)
+    {
+        esz_atlas_page_t* page = &atlas->page[index];
+        size_t            size;
+
+        if (1 != fread(&page->width,  sizeof(page->width),  1, fp) ||
+            1 != fread(&page->height, sizeof(page->height), 1, fp))
+        {
+            status = ESZ_WARNING;
+            goto exit;
+        }
+
+        if (0 >= page->width || 0 >= page->height || ATLAS_MAX_PAGE_SIZE * 4 < page->width || ATLAS_MAX_PAGE_SIZE * 4 < page->height)
+        {
+            status = ESZ_WARNING;
+            goto exit;
+        }
+
+        size        = (size_t)page->width * (size_t)page->height * 4;
+        page->pixels = (unsigned char*)malloc_counted(size);
+        if (! page->pixels)
+        {
+            plog_error("%s: error allocating memory.", __func__);
+            status = ESZ_ERROR_CRITICAL;
+            goto exit;
+        }
+
+        if (1 != fread(page->pixels, size, 1, fp))
+        {
+            status = ESZ_WARNING;
+            goto exit;
+        }
+    }
+
+    plog_info("Load texture atlas cache: %s.", file_name);
+
+exit:
+    fclose(fp);
+
+    if (ESZ_OK != status)
+    {
+        destroy_atlas(atlas);
+    }
+
+    return status;
+}
+
+/* Writes an edited image over its region of an uploaded atlas.  Images
+ * that changed size no longer fit and yield a warning.
+ */
+esz_status update_atlas_image(esz_image_t* image, int32_t* page, SDL_Rect* rect, esz_atlas_t* atlas)
+{
+    esz_status     status = ESZ_OK;
+    unsigned char* pixels;
+    TRACE_START(start);
+
+    if (! get_atlas_region(image->hash, page, rect, atlas) || ! atlas->page[*page].texture)
+    {
+        return ESZ_WARNING;
+    }
+
+    if (rect->w != image->width || rect->h != image->height)
+    {
+        plog_warn("%s: %s changed size.", __func__, image->file_name);
+        return ESZ_WARNING;
+    }
+
+    pixels = (unsigned char*)malloc((size_t)image->width * (size_t)image->height * 4);
+    if (! pixels)
+    {
+        plog_error("%s: error allocating memory.", __func__);
+        return ESZ_ERROR_CRITICAL;
+    }
+
+    if (0 > SDL_ConvertPixels(
+            image->width,
+            image->height,
+            SDL_PIXELFORMAT_RGBA32,
+            image->pixels,
+            image->width * 4,
+            atlas->format,
+            pixels,
+            image->width * 4))
+    {
+        plog_error("%s: %s.", __func__, SDL_GetError());
+        status = ESZ_ERROR_CRITICAL;
+        goto exit;
+    }
+
+    if (0 > SDL_UpdateTexture(atlas->page[*page].texture, rect, pixels, image->width * 4))
+    {
+        plog_error("%s: %s.", __func__, SDL_GetError());
+        status = ESZ_ERROR_CRITICAL;
+    }
+
+    TRACE_SCOPE("texture", "update_atlas_image", start, SDL_GetPerformanceCounter());
+
+exit:
+    free(pixels);
+
+    return status;
+}
+
+esz_status upload_atlas(esz_atlas_t* atlas, esz_window_t* window)
+{
+    for (int32_t index = 0; index < atlas->page_count; index += 1)
+    {
+        esz_status status = upload_atlas_page(index, atlas, window);
+
+        if (ESZ_OK != status)
+        {
+            return status;
+        }
+    }
+
+    return ESZ_OK;
+}
+
+esz_status upload_atlas_page(int32_t index, esz_atlas_t* atlas, esz_window_t* window)
+{
+    esz_atlas_page_t* page  = &atlas->page[index];
+    uint64_t          start = SDL_GetPerformanceCounter();
+
+    // Atlases taken from the texture cache are already uploaded.
+    if (page->texture)
+    {
+        return ESZ_OK;
+    }
+
+    // The pixels already are in the renderer's native format.
+    page->texture = SDL_CreateTexture(
+        window->renderer,
+        atlas->format,
+        SDL_TEXTUREACCESS_STATIC,
+        page->width,
+        page->height);
+
+    if (! page->texture)
+    {
+        plog_error("%s: %s.", __func__, SDL_GetError());
+        return ESZ_ERROR_CRITICAL;
+    }
+
+    if (0 > SDL_UpdateTexture(page->texture, NULL, page->pixels, page->width * 4))
+    {
+        plog_error("%s: %s.", __func__, SDL_GetError());
+        return ESZ_ERROR_CRITICAL;
+    }
+
+    if (0 > SDL_SetTextureBlendMode(page->texture, window->blend_mode))
+    {
+        plog_error("%s: %s.", __func__, SDL_GetError());
+        return ESZ_ERROR_CRITICAL;
+    }
+
+    TRACE_SCOPE("texture", "upload_atlas_page", start, SDL_GetPerformanceCounter());
+
+    plog_info(
+        "Upload texture atlas page %d (%dx%d) in %.2f ms.",
+        index + 1,
+        page->width,
+        page->height,
+        (double)(SDL_GetPerformanceCounter() - start) * 1000.0 / (double)SDL_GetPerformanceFrequency());
+
+    return ESZ_OK;
+}
+
+esz_status write_atlas_file(const char* file_name, const uint64_t key, esz_atlas_t* atlas)
+{
+    esz_status     status  = ESZ_OK;
+    const uint32_t version = ATLAS_FILE_VERSION;
+    FILE*          fp      = fopen(file_name, "wb");
+
+    if (! fp)
+    {
+        plog_warn("%s: could not open %s for writing.", __func__, file_name);
+        return ESZ_WARNING;
+    }
+
+    if (1 != fwrite(ATLAS_FILE_MAGIC,     8,                           1, fp) ||
+        1 != fwrite(&version,             sizeof(version),             1, fp) ||
+        1 != fwrite(&atlas->format,       sizeof(atlas->format),       1, fp) ||
+        1 != fwrite(&atlas->page_count,   sizeof(atlas->page_count),   1, fp) ||
+        1 != fwrite(&atlas->region_count, sizeof(atlas->region_count), 1, fp) ||
+        1 != fwrite(&key,                 sizeof(key),                 1, fp))
+    {
+        status = ESZ_WARNING;
+        goto exit;
+    }
+
+    for (int32_t index = 0; index < atlas->region_count; index += 1)
+    {
+        esz_atlas_region_t* region = &atlas->region[index];
+
+        if (1 != fwrite(&region->hash,   sizeof(region->hash),   1, fp) ||
+            1 != fwrite(&region->key,    sizeof(region->key),    1, fp) ||
+            1 != fwrite(&region->page,   sizeof(region->page),   1, fp) ||
+            1 != fwrite(&region->rect.x, sizeof(region->rect.x), 1, fp) ||
+            1 != fwrite(&region->rect.y, sizeof(region->rect.y), 1, fp) ||
+            1 != fwrite(&region->rect.w, sizeof(region->rect.w), 1, fp) ||
+            1 != fwrite(&region->rect.h, sizeof(region->rect.h), 1, fp))
+        {
+            status = ESZ_WARNING;
+            goto exit;
+        }
+    }
+
+    for (int32_t index = 0; index < atlas->page_count; index += 1)
+    {
+        esz_atlas_page_t* page = &atlas->page[index];
+
+        if (1 != fwrite(&page->width,  sizeof(page->width),  1, fp) ||
+            1 != fwrite(&page->height, sizeof(page->height), 1, fp) ||
+            1 != fwrite(page->pixels, (size_t)page->width * (size_t)page->height * 4, 1, fp))
+        {
+            status = ESZ_WARNING;
+            goto exit;
+        }
+    }
+
+    plog_info("Write texture atlas cache: %s.", file_name);
+
+exit:
+    fclose(fp);
+
+    if (ESZ_OK != status)
+    {
+        plog_warn("%s: could not write %s.", __func__, file_name);
+        remove(file_name);
+    }
+
+    return status;
+}
+
+static int compare_image_height(const void* image_a, const void* image_b)
+{
+    const esz_image_t* a = *(esz_image_t* const*)image_a;
+    const esz_image_t* b = *(esz_image_t* const*)image_b;
+
+    if (a->height != b->height)
+    {
+        return b->height - a->height;
+    }
+
+    return b->width - a->width;
+}
+
+static esz_status create_skyline(int32_t width, int32_t height, skyline_t* skyline)
+{
+    skyline->node = (skyline_node_t*)calloc_counted((size_t)width + 1, sizeof(skyline_node_t));
+    if (! skyline->node)
+    {
+        plog_error("%s: error allocating memory.", __func__);
+        return ESZ_ERROR_CRITICAL;
+    }
+
+    skyline->node[0].width = width;
+    skyline->node_count    = 1;
+    skyline->width         = width;
+    skyline->height        = height;
+    skyline->used_width    = 0;
+    skyline->used_height   = 0;
+
+    return ESZ_OK;
+}
+
+static bool skyline_fit(int32_t index, int32_t width, int32_t height, int32_t* pos_y, skyline_t* skyline)
+{
+    int32_t pos_x      = skyline->node[index].x;
+    int32_t width_left = width;
+
+    *pos_y = skyline->node[index].y;
+
+    if (pos_x + width > skyline->width)
+    {
+        return false;
+    }
+
+    while (0 < width_left)
+    {
+        if (index >= skyline->node_count)
+        {
+            return false;
+        }
+
+        if (skyline->node[index].y > *pos_y)
+        {
+            *pos_y = skyline->node[index].y;
+        }
+
+        if (*pos_y + height > skyline->height)
+        {
+            return false;
+        }
+
+        width_left -= skyline->node[index].width;
+        index      += 1;
+    }
+
+    return true;
+}
+
+static bool skyline_insert(int32_t width, int32_t height, SDL_Rect* rect, skyline_t* skyline)
+{
+    int32_t best_index = -1;
+    int32_t best_width = INT32_MAX;
+    int32_t best_y     = INT32_MAX;
+
+    for (int32_t index = 0; index < skyline->node_count; index += 1)
+    {
+        int32_t pos_y;
+
+        if (skyline_fit(index, width, height, &pos_y, skyline))
+        {
+            if (pos_y < best_y || (pos_y == best_y && skyline->node[index].width < best_width))
+            {
+                best_index = index;
+                best_width = skyline->node[index].width;
+                best_y     = pos_y;
+            }
+        }
+    }
+
+    if (-1 == best_index)
+    {
+        return false;
+    }
+
+    rect->x = skyline->node[best_index].x;
+    rect->y = best_y;
+    rect->w = width;
+    rect->h = height;
+
+    // Insert new node and shrink the nodes it covers.
+    memmove(
+        &skyline->node[best_index + 1],
+        &skyline->node[best_index],
+        (size_t)(skyline->node_count - best_index) * sizeof(skyline_node_t));
+
+    skyline->node[best_index].x     = rect->x;
+    skyline->node[best_index].y     = rect->y + height;
+    skyline->node[best_index].width = width;
+    skyline->node_count            += 1;
+
+    for (int32_t index = best_index + 1; index < skyline->node_count;)
+    {
+        skyline_node_t* previous = &skyline->node[index - 1];
+        int32_t         shrink   = (previous->x + previous->width) - skyline->node[index].x;
+
+        if (0 >= shrink)
+        {
+            break;
+        }
+
+        skyline->node[index].x     += shrink;
+        skyline->node[index].width -= shrink;
+
+        if (0 < skyline->node[index].width)
+        {
+            break;
+        }
+
+        memmove(
+            &skyline->node[index],
+            &skyline->node[index + 1],
+            (size_t)(skyline->node_count - index - 1) * sizeof(skyline_node_t));
+        skyline->node_count -= 1;
+    }
+
+    // Merge neighbouring nodes of the same height.
+    for (int32_t index = 0; index < skyline->node_count - 1;)
+    {
+        if (skyline->node[index].y == skyline->node[index + 1].y)
+        {
+            skyline->node[index].width += skyline->node[index + 1].width;
+
+            memmove(
+                &skyline->node[index + 1],
+                &skyline->node[index + 2],
+                (size_t)(skyline->node_count - index - 2) * sizeof(skyline_node_t));
+            skyline->node_count -= 1;
+        }
+        else
+        {
+            index += 1;
+        }
+    }
+
+    if (rect->x + width - ATLAS_PADDING > skyline->used_width)
+    {
+        skyline->used_width = rect->x + width - ATLAS_PADDING;
+    }
+
+    if (rect->y + height - ATLAS_PADDING > skyline->used_height)
+    {
+        skyline->used_height = rect->y + height - ATLAS_PADDING;
+    }
+
+    return true;
+}
@@ -0,0 +1,30 @@
+// SPDX-License-Identifier: MIT
+/**
+ * @file    esz_atlas.h
+ * @brief   eszFW texture atlas
+ * @details Packs images into as few textures as possible
+ */
+
+#ifndef ESZ_ATLAS_H
+#define ESZ_ATLAS_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <SDL.h>
+
+#include "esz_types.h"
+
+void       destroy_atlas(esz_atlas_t* atlas);
+void       free_atlas_pixels(esz_atlas_t* atlas);
+uint64_t   generate_atlas_key(esz_image_t* image, int32_t image_count);
+uint64_t   generate_image_key(esz_image_t* image);
+bool       get_atlas_region(const uint64_t hash, int32_t* page, SDL_Rect* rect, esz_atlas_t* atlas);
+esz_status merge_atlas(esz_atlas_t* atlas, esz_atlas_t* other);
+esz_status pack_atlas(esz_image_t* image, int32_t image_count, esz_atlas_t* atlas, esz_window_t* window);
+esz_status read_atlas_file(const char* file_name, const uint64_t key, const uint32_t format, esz_atlas_t* atlas);
+esz_status update_atlas_image(esz_image_t* image, int32_t* page, SDL_Rect* rect, esz_atlas_t* atlas);
+esz_status upload_atlas(esz_atlas_t* atlas, esz_window_t* window);
+esz_status upload_atlas_page(int32_t index, esz_atlas_t* atlas, esz_window_t* window);
+esz_status write_atlas_file(const char* file_name, const uint64_t key, esz_atlas_t* atlas);
+
+#endif // ESZ_ATLAS_H
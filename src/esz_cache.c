@@ -0,0 +1,409 @@
+// SPDX-License-Identifier: MIT
+/**
+ * @file    esz_cache.c
+ * @brief   eszFW texture cache
+ */
+
+#include <picolog.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdlib.h>
+
+#include "esz_macros.h"
+
+DISABLE_WARNING_PUSH
+DISABLE_WARNING_PADDING
+DISABLE_WARNING_SPECTRE_MITIGATION
+DISABLE_WARNING_SYMBOL_NOT_DEFINED
+
+#include <SDL.h>
+
+DISABLE_WARNING_POP
+
+#include "esz_atlas.h"
+#include "esz_cache.h"
+#include "esz_types.h"
+#include "esz_utils.h"
+
+static esz_texture_cache_entry_t* find_cached_page(const SDL_Texture* texture, esz_texture_cache_t* cache);
+static bool                       is_image_cached(const esz_image_t* image, const esz_texture_cache_entry_t* entry);
+static bool                       is_region_stale(const esz_atlas_region_t* region, const esz_image_t* image, int32_t image_count);
+static void                       remove_cached_page(int32_t index, esz_texture_cache_t* cache);
+
+/* Takes the cached pages that hold any of the images and moves the
+ * images that are still missing to the front of the list.  May be
+ * called from the map loader thread; the pages can't be evicted while
+ * they're referenced.
+ */
+esz_status acquire_cached_pages(esz_image_t* image, int32_t image_count, int32_t* missing_count, esz_atlas_t* atlas, esz_window_t* window)
+{
+    esz_texture_cache_t* cache        = &window->texture_cache;
+    esz_status           status       = ESZ_OK;
+    bool*                is_acquired  = NULL;
+    int32_t              page_count   = 0;
+    int32_t              region_count = 0;
+
+    *missing_count = image_count;
+
+    SDL_LockMutex(cache->lock);
+
+    if (0 >= cache->entry_count)
+    {
+        goto exit;
+    }
+
+    is_acquired = (bool*)calloc_counted((size_t)cache->entry_count, sizeof(bool));
+    if (! is_acquired)
+    {
+        plog_error("%s: error allocating memory.", __func__);
+        status = ESZ_ERROR_CRITICAL;
+        goto exit;
+    }
+
+    for (int32_t index = 0; index < *missing_count;)
+    {
+        bool is_covered = false;
+
+        for (int32_t entry = 0; entry < cache->entry_count; entry += 1)
+        {
+            if (is_image_cached(&image[index], &cache->entry[entry]))
+            {
+                if (! is_acquired[entry])
+                {
+                    is_acquired[entry]  = true;
+                    page_count         += 1;
+                    region_count       += cache->entry[entry].region_count;
+                }
+                is_covered = true;
+                break;
+            }
+        }
+
+        if (is_covered)
+        {
+            esz_image_t swap = image[index];
+
+            *missing_count       -= 1;
+            image[index]          = image[*missing_count];
+            image[*missing_count] = swap;
+        }
+        else
+        {
+            index += 1;
+        }
+    }
+
+    if (0 == page_count)
+    {
+        goto exit;
+    }
+
+    atlas->page   = (esz_atlas_page_t*)calloc_counted((size_t)page_count, sizeof(struct esz_atlas_page));
+    atlas->region = (esz_atlas_region_t*)calloc_counted((size_t)region_count, sizeof(struct esz_atlas_region));
+
+    if (! atlas->page || ! atlas->region)
+    {
+        plog_error("%s: error allocating memory.", __func__);
+        free(atlas->page);
+        free(atlas->region);
+        SDL_memset(atlas, 0, sizeof(struct esz_atlas));
+        *missing_count = image_count;
+        status         = ESZ_ERROR_CRITICAL;
+        goto exit;
+    }
+
+    atlas->format = window->texture_format;
+    cache->tick  += 1;
+
+    for (int32_t index = 0; index < cache->entry_count; index += 1)
+    {
+        esz_texture_cache_entry_t* entry = &cache->entry[index];
+
+        if (! is_acquired[index])
+        {
+            continue;
+        }
+
+        entry->last_used  = cache->tick;
+        entry->ref_count += 1;
+
+        atlas->page[atlas->page_count] = entry->page;
+
+        for (int32_t region = 0; region < entry->region_count; region += 1)
+        {
+            // Edited images are packed again and must not be found here.
+            if (is_region_stale(&entry->region[region], image, image_count))
+            {
+                continue;
+            }
+
+            atlas->region[atlas->region_count]      = entry->region[region];
+            atlas->region[atlas->region_count].page = atlas->page_count;
+            atlas->region_count                    += 1;
+        }
+
+        atlas->page_count += 1;
+    }
+
+exit:
+    SDL_UnlockMutex(cache->lock);
+
+    free(is_acquired);
+
+    if (0 < page_count && ESZ_OK == status)
+    {
+        plog_info("Use %d cached texture atlas page(s) for %d image(s).", page_count, image_count - *missing_count);
+    }
+
+    return status;
+}
+
+esz_status create_texture_cache(esz_window_t* window)
+{
+    window->texture_cache.budget = TEXTURE_CACHE_BUDGET;
+    window->texture_cache.lock   = SDL_CreateMutex();
+
+    if (! window->texture_cache.lock)
+    {
+        plog_error("%s: %s.", __func__, SDL_GetError());
+        return ESZ_ERROR_CRITICAL;
+    }
+
+    return ESZ_OK;
+}
+
+void destroy_texture_cache(esz_window_t* window)
+{
+    esz_texture_cache_t* cache = &window->texture_cache;
+
+    while (0 < cache->entry_count)
+    {
+        remove_cached_page(cache->entry_count - 1, cache);
+    }
+
+    free(cache->entry);
+
+    if (cache->lock)
+    {
+        SDL_DestroyMutex(cache->lock);
+    }
+
+    SDL_memset(cache, 0, sizeof(struct esz_texture_cache));
+}
+
+// Must be called from the render thread.
+void evict_cached_pages(const size_t budget, esz_window_t* window)
+{
+    esz_texture_cache_t* cache = &window->texture_cache;
+
+    SDL_LockMutex(cache->lock);
+
+    while (cache->size > budget)
+    {
+        int32_t oldest = -1;
+
+        for (int32_t index = 0; index < cache->entry_count; index += 1)
+        {
+            if (0 < cache->entry[index].ref_count)
+            {
+                continue;
+            }
+
+            if (0 > oldest || cache->entry[index].last_used < cache->entry[oldest].last_used)
+            {
+                oldest = index;
+            }
+        }
+
+        if (0 > oldest)
+        {
+            break;
+        }
+
+        plog_info("Evict cached texture atlas page (%zu bytes).", cache->entry[oldest].size);
+        remove_cached_page(oldest, cache);
+    }
+
+    SDL_UnlockMutex(cache->lock);
+}
+
+bool is_page_cached(const SDL_Texture* texture, esz_window_t* window)
+{
+    esz_texture_cache_t* cache = &window->texture_cache;
+    bool                 is_cached;
+
+    SDL_LockMutex(cache->lock);
+    is_cached = NULL != find_cached_page(texture, cache);
+    SDL_UnlockMutex(cache->lock);
+
+    return is_cached;
+}
+
+/* Pages that never made it into the cache are owned by the map and
+ * destroyed right away.
+ */
+void release_cached_atlas(esz_atlas_t* atlas, esz_window_t* window)
+{
+    esz_texture_cache_t* cache = &window->texture_cache;
+
+    SDL_LockMutex(cache->lock);
+
+    cache->tick += 1;
+
+    for (int32_t index = 0; index < atlas->page_count; index += 1)
+    {
+        esz_texture_cache_entry_t* entry = find_cached_page(atlas->page[index].texture, cache);
+
+        if (entry)
+        {
+            entry->last_used            = cache->tick;
+            entry->ref_count           -= 1;
+            atlas->page[index].texture  = NULL;
+        }
+    }
+
+    SDL_UnlockMutex(cache->lock);
+
+    destroy_atlas(atlas);
+    evict_cached_pages(cache->budget, window);
+}
+
+/* Takes over the pages of an atlas once all of them have been uploaded.
+ * With a budget of 0 nothing is retained and the map keeps ownership.
+ */
+void store_cached_atlas(esz_atlas_t* atlas, esz_window_t* window)
+{
+    esz_texture_cache_t* cache = &window->texture_cache;
+
+    SDL_LockMutex(cache->lock);
+
+    if (0 == cache->budget)
+    {
+        SDL_UnlockMutex(cache->lock);
+        return;
+    }
+
+    cache->tick += 1;
+
+    for (int32_t index = 0; index < atlas->page_count; index += 1)
+    {
+        esz_atlas_page_t*          page         = &atlas->page[index];
+        esz_texture_cache_entry_t* entry;
+        esz_atlas_region_t*        region;
+        int32_t                    region_count = 0;
+
+        if (! page->texture || find_cached_page(page->texture, cache))
+        {
+            continue;
+        }
+
+        for (int32_t region_index = 0; region_index < atlas->region_count; region_index += 1)
+        {
+            if (index == atlas->region[region_index].page)
+            {
+                region_count += 1;
+            }
+        }
+
+        region = (esz_atlas_region_t*)calloc_counted((size_t)region_count, sizeof(struct esz_atlas_region));
+        entry  = (esz_texture_cache_entry_t*)realloc_counted(cache->entry, (size_t)cache->entry_count * sizeof(struct esz_texture_cache_entry), (size_t)(cache->entry_count + 1) * sizeof(struct esz_texture_cache_entry));
+
+        if (entry)
+        {
+            cache->entry = entry;
+        }
+
+        if (! region || ! entry)
+        {
+            // The map keeps ownership of the page.
+            plog_warn("%s: error allocating memory.", __func__);
+            free(region);
+            continue;
+        }
+
+        entry               = &cache->entry[cache->entry_count];
+        entry->page         = *page;
+        entry->region       = region;
+        entry->region_count = 0;
+        entry->last_used    = cache->tick;
+        entry->size         = (size_t)page->width * (size_t)page->height * 4;
+        entry->ref_count    = 1;
+
+        for (int32_t region_index = 0; region_index < atlas->region_count; region_index += 1)
+        {
+            if (index == atlas->region[region_index].page)
+            {
+                entry->region[entry->region_count]      = atlas->region[region_index];
+                entry->region[entry->region_count].page = 0;
+                entry->region_count                    += 1;
+            }
+        }
+
+        cache->entry_count += 1;
+        cache->size        += entry->size;
+    }
+
+    SDL_UnlockMutex(cache->lock);
+}
+
+static esz_texture_cache_entry_t* find_cached_page(const SDL_Texture* texture, esz_texture_cache_t* cache)
+{
+    if (! texture)
+    {
+        return NULL;
+    }
+
+    for (int32_t index = 0; index < cache->entry_count; index += 1)
+    {
+        if (texture == cache->entry[index].page.texture)
+        {
+            return &cache->entry[index];
+        }
+    }
+
+    return NULL;
+}
+
+// Images are matched by path hash, modification time and size.
+static bool is_image_cached(const esz_image_t* image, const esz_texture_cache_entry_t* entry)
+{
+    for (int32_t index = 0; index < entry->region_count; index += 1)
+    {
+        if (image->hash == entry->region[index].hash && image->key == entry->region[index].key)
+        {
+            return true;
+        }
+    }
+
+    return false;
+}
+
+// A region is stale if the map asks for a different version of its image.
+static bool is_region_stale(const esz_atlas_region_t* region, const esz_image_t* image, int32_t image_count)
+{
+    for (int32_t index = 0; index < image_count; index += 1)
+    {
+        if (region->hash == image[index].hash)
+        {
+            return region->key != image[index].key;
+        }
+    }
+
+    return false;
+}
+
+static void remove_cached_page(int32_t index, esz_texture_cache_t* cache)
+{
+    esz_texture_cache_entry_t* entry = &cache->entry[index];
+
+    if (entry->page.texture)
+    {
+        SDL_DestroyTexture(entry->page.texture);
+    }
+    free(entry->region);
+
+    cache->size        -= entry->size;
+    cache->entry_count -= 1;
+    cache->entry[index] = cache->entry[cache->entry_count];
+}
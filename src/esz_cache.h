@@ -0,0 +1,32 @@
+// SPDX-License-Identifier: MIT
+/**
+ * @file    esz_cache.h
+ * @brief   eszFW texture cache
+ * @details Keeps the texture atlas pages of unloaded maps around, so
+ *          maps that share images don't have to decode and upload them
+ *          again.  Pages are refcounted and matched by the path hash,
+ *          modification time and size of the images they hold; unused
+ *          ones are evicted in least recently used order once the
+ *          cache exceeds its budget.
+ */
+
+#ifndef ESZ_CACHE_H
+#define ESZ_CACHE_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "esz_types.h"
+
+#define TEXTURE_CACHE_BUDGET 268435456 // 256 MiB
+
+esz_status acquire_cached_pages(esz_image_t* image, int32_t image_count, int32_t* missing_count, esz_atlas_t* atlas, esz_window_t* window);
+esz_status create_texture_cache(esz_window_t* window);
+void       destroy_texture_cache(esz_window_t* window);
+void       evict_cached_pages(const size_t budget, esz_window_t* window);
+bool       is_page_cached(const SDL_Texture* texture, esz_window_t* window);
+void       release_cached_atlas(esz_atlas_t* atlas, esz_window_t* window);
+void       store_cached_atlas(esz_atlas_t* atlas, esz_window_t* window);
+
+#endif // ESZ_CACHE_H
@@ -8,12 +8,16 @@
 #include <stdbool.h>
 #include <stdint.h>
 #include <stdio.h>
+#include <stdlib.h>
 #include <string.h>
 
 #include "esz_compat.h"
 #include "esz_hash.h"
+#include "esz_json.h"
 #include "esz_macros.h"
+#include "esz_mapfile.h"
 #include "esz_types.h"
+#include "esz_utils.h"
 
 DISABLE_WARNING_PUSH
 DISABLE_WARNING_PADDING
@@ -25,6 +29,8 @@ DISABLE_WARNING_SPECTRE_MITIGATION
     #include <tmx.h>
 #else // (cute_tiled.h)
     #define CUTE_TILED_IMPLEMENTATION
+    #define CUTE_TILED_ALLOC(size, ctx) malloc_counted(size)
+    #define CUTE_TILED_FREE(mem, ctx)   free(mem)
     #include <cute_tiled.h>
 #endif
 
@@ -36,7 +42,20 @@ DISABLE_WARNING_SYMBOL_NOT_DEFINED
 DISABLE_WARNING_POP
 
 #ifdef USE_LIBTMX
-static void tmxlib_store_property(esz_tiled_property_t* property, void* core);
+typedef tmx_tileset_list tileset_entry_t;
+#else // (cute_tiled.h)
+typedef esz_tiled_tileset_t tileset_entry_t;
+#endif
+
+static tileset_entry_t* get_tileset_entry(int32_t index, esz_tiled_map_t* tiled_map);
+static tileset_entry_t* get_tileset_entry_of_gid(int32_t gid, esz_tiled_map_t* tiled_map);
+
+#ifdef USE_LIBTMX
+static void* tmxlib_realloc(void* ptr, size_t size);
+static void  tmxlib_store_property(esz_tiled_property_t* property, void* core);
+
+#else // (cute_tiled.h)
+static bool set_tile_layer_data(esz_tiled_layer_t* layer, int32_t* next_index, esz_tiled_json_t* json);
 #endif
 
 int32_t get_first_gid(esz_tiled_map_t* tiled_map)
@@ -125,16 +144,14 @@ int32_t get_layer_property_count(esz_tiled_layer_t* tiled_layer)
 
 int32_t get_local_id(int32_t gid, esz_tiled_map_t* tiled_map)
 {
-    #ifdef USE_LIBTMX
-    (void)tiled_map;
-    return gid;
-
-    #else // (cute_tiled.h)
-    int32_t local_id = gid - get_first_gid(tiled_map);
+    tileset_entry_t* tileset = get_tileset_entry_of_gid(gid, tiled_map);
 
-    return local_id >= 0 ? local_id : 0;
+    if (! tileset)
+    {
+        return 0;
+    }
 
-    #endif
+    return gid - (int32_t)tileset->firstgid;
 }
 
 int32_t get_map_property_count(esz_tiled_map_t* tiled_map)
@@ -151,17 +168,27 @@ int32_t get_map_property_count(esz_tiled_map_t* tiled_map)
 
 int32_t get_next_animated_tile_id(int32_t gid, int32_t current_frame, esz_tiled_map_t* tiled_map)
 {
+    tileset_entry_t* tileset = get_tileset_entry_of_gid(gid, tiled_map);
+
+    if (! tileset)
+    {
+        return 0;
+    }
+
     #ifdef USE_LIBTMX
-    return (int32_t)tiled_map->tiles[gid]->animation[current_frame].tile_id;
+    if (tiled_map->tiles[gid] && tiled_map->tiles[gid]->animation)
+    {
+        return (int32_t)tileset->firstgid + (int32_t)tiled_map->tiles[gid]->animation[current_frame].tile_id;
+    }
 
     #else // (cute_tiled.h)
-    esz_tiled_tileset_t*          tileset = get_head_tileset(tiled_map);
-    cute_tiled_tile_descriptor_t* tile    = tileset->tiles;
+    int32_t                       local_id = gid - tileset->firstgid;
+    cute_tiled_tile_descriptor_t* tile     = tileset->tiles;
     while (tile)
     {
-        if (tile->tile_index == gid)
+        if (tile->tile_index == local_id)
         {
-            return tile->animation[current_frame].tileid;
+            return tileset->firstgid + tile->animation[current_frame].tileid;
         }
         tile = tile->next;
     }
@@ -171,6 +198,11 @@ int32_t get_next_animated_tile_id(int32_t gid, int32_t current_frame, esz_tiled_
     return 0;
 }
 
+int32_t get_object_id(esz_tiled_object_t* tiled_object)
+{
+    return (int32_t)tiled_object->id;
+}
+
 const char* get_object_name(esz_tiled_object_t* tiled_object)
 {
     #ifdef USE_LIBTMX
@@ -220,27 +252,27 @@ int32_t get_tile_height(esz_tiled_map_t* tiled_map)
 void get_tile_position(int32_t gid, int32_t* pos_x, int32_t* pos_y, esz_tiled_map_t* tiled_map)
 {
     #ifdef USE_LIBTMX
-    *pos_x = (int32_t)tiled_map->tiles[gid]->ul_x;
-    *pos_y = (int32_t)tiled_map->tiles[gid]->ul_y;
+    if (tiled_map->tiles[gid])
+    {
+        *pos_x = (int32_t)tiled_map->tiles[gid]->ul_x;
+        *pos_y = (int32_t)tiled_map->tiles[gid]->ul_y;
+    }
 
     #else // (cute_tiled.h)
-    esz_tiled_tileset_t* tileset  = tiled_map->tilesets;
-    int32_t              local_id = get_local_id(gid, tiled_map);
+    esz_tiled_tileset_t* tileset = get_tileset_entry_of_gid(gid, tiled_map);
+    int32_t              local_id;
 
-    *pos_x = (local_id % tileset->columns) * get_tile_width(tiled_map);
-    *pos_y = (local_id / tileset->columns) * get_tile_height(tiled_map);
+    if (! tileset || 0 >= tileset->columns)
+    {
+        *pos_x = 0;
+        *pos_y = 0;
+        return;
+    }
 
-    #endif
-}
+    local_id = gid - tileset->firstgid;
 
-int32_t get_tile_property_count(esz_tiled_tile_t* tiled_tile)
-{
-    #ifdef USE_LIBTMX
-    (void)tiled_tile;
-    return 0;
-
-    #else // (cute_tiled.h)
-    return tiled_tile->property_count;
+    *pos_x = tileset->margin + (local_id % tileset->columns) * (tileset->tilewidth  + tileset->spacing);
+    *pos_y = tileset->margin + (local_id / tileset->columns) * (tileset->tileheight + tileset->spacing);
 
     #endif
 }
@@ -257,14 +289,15 @@ int32_t get_tile_width(esz_tiled_map_t* tiled_map)
     #endif
 }
 
-void set_tileset_path(char* path_name, int32_t path_length, esz_core_t* core)
+void set_tileset_path(char* path_name, int32_t path_length, int32_t index, esz_core_t* core)
 {
+    tileset_entry_t* tileset = get_tileset_entry(index, core->map->handle);
+
     #ifdef USE_LIBTMX
-    int32_t first_gid      = get_first_gid(core->map->handle);
     char    ts_path[64]    = { 0 };
     size_t  ts_path_length = 0;
 
-    cwk_path_get_dirname(core->map->handle->ts_head->source, &ts_path_length);
+    cwk_path_get_dirname(tileset->source, &ts_path_length);
 
     if (63 <= ts_path_length)
     {
@@ -277,43 +310,81 @@ void set_tileset_path(char* path_name, int32_t path_length, esz_core_t* core)
      * accordingly.  It's a hack, but it works.
      */
 
-    SDL_strlcpy(ts_path, core->map->handle->ts_head->source, ts_path_length + 1);
+    SDL_strlcpy(ts_path, tileset->source, ts_path_length + 1);
     stbsp_snprintf(path_name, (int32_t)path_length, "%s%s%s",
         core->map->path,
         ts_path,
-        core->map->handle->tiles[first_gid]->tileset->image->source);
+        tileset->tileset->image->source);
 
     #else // (cute_tiled.h)
     stbsp_snprintf(path_name, (int32_t)path_length, "%s%s",
         core->map->path,
-        core->map->handle->tilesets->image.ptr);
+        tileset->image.ptr);
 
     #endif
 }
 
-int32_t get_tileset_path_length(esz_core_t* core)
+int32_t get_tileset_count(esz_tiled_map_t* tiled_map)
 {
-    int32_t path_length = 0;
+    int32_t count = 0;
 
     #ifdef USE_LIBTMX
-    int32_t first_gid      = get_first_gid(core->map->handle);
-    size_t  ts_path_length = 0;
+    tileset_entry_t* tileset = tiled_map->ts_head;
+
+    #else // (cute_tiled.h)
+    tileset_entry_t* tileset = tiled_map->tilesets;
+
+    #endif
+
+    while (tileset)
+    {
+        count   += 1;
+        tileset  = tileset->next;
+    }
+
+    return count;
+}
+
+int32_t get_tileset_first_gid(int32_t index, esz_tiled_map_t* tiled_map)
+{
+    return (int32_t)get_tileset_entry(index, tiled_map)->firstgid;
+}
+
+int32_t get_tileset_path_length(int32_t index, esz_core_t* core)
+{
+    int32_t          path_length = 0;
+    tileset_entry_t* tileset     = get_tileset_entry(index, core->map->handle);
+
+    #ifdef USE_LIBTMX
+    size_t ts_path_length = 0;
+
+    if (! tileset || ! tileset->tileset->image)
+    {
+        plog_error("%s: tileset %d has no image.", __func__, index + 1);
+        return 0;
+    }
 
-    cwk_path_get_dirname(core->map->handle->ts_head->source, &ts_path_length);
+    cwk_path_get_dirname(tileset->source, &ts_path_length);
 
     path_length += (int32_t)strnlen(core->map->path, 64);
-    path_length += strnlen(core->map->handle->tiles[first_gid]->tileset->image->source, 64);
+    path_length += strnlen(tileset->tileset->image->source, 64);
     path_length += (int32_t)ts_path_length + 1;
 
     #else // (cute_tiled.h)
-    if (! core->map->handle->tilesets)
+    if (! tileset)
     {
         plog_error("%s: no embedded tileset found.", __func__);
         return 0;
     }
 
+    if (! tileset->image.ptr)
+    {
+        plog_error("%s: tileset %d has no image.", __func__, index + 1);
+        return 0;
+    }
+
     path_length += (int32_t)strnlen(core->map->path, 64);
-    path_length += (int32_t)strnlen(core->map->handle->tilesets->image.ptr, 64);
+    path_length += (int32_t)strnlen(tileset->image.ptr, 64);
     path_length += 1;
 
     #endif
@@ -321,49 +392,68 @@ int32_t get_tileset_path_length(esz_core_t* core)
     return path_length;
 }
 
-bool is_gid_valid(int32_t gid, esz_tiled_map_t* tiled_map)
+int32_t get_tileset_tile_count(int32_t index, esz_tiled_map_t* tiled_map)
 {
     #ifdef USE_LIBTMX
-    if (tiled_map->tiles[gid])
-    {
-        return true;
-    }
+    return (int32_t)get_tileset_entry(index, tiled_map)->tileset->tilecount;
+
     #else // (cute_tiled.h)
-    (void)tiled_map;
+    return get_tileset_entry(index, tiled_map)->tilecount;
 
-    if (gid)
-    {
-        return true;
-    }
+    #endif
+}
+
+int32_t get_tileset_tile_height(int32_t index, esz_tiled_map_t* tiled_map)
+{
+    #ifdef USE_LIBTMX
+    return (int32_t)get_tileset_entry(index, tiled_map)->tileset->tile_height;
+
+    #else // (cute_tiled.h)
+    return get_tileset_entry(index, tiled_map)->tileheight;
+
+    #endif
+}
+
+int32_t get_tileset_tile_width(int32_t index, esz_tiled_map_t* tiled_map)
+{
+    #ifdef USE_LIBTMX
+    return (int32_t)get_tileset_entry(index, tiled_map)->tileset->tile_width;
+
+    #else // (cute_tiled.h)
+    return get_tileset_entry(index, tiled_map)->tilewidth;
 
     #endif
-    return false;
 }
 
 bool is_tile_animated(int32_t gid, int32_t* animation_length, int32_t* id, esz_tiled_map_t* tiled_map)
 {
-    int32_t local_id = get_local_id(gid, tiled_map);
+    tileset_entry_t* tileset = get_tileset_entry_of_gid(gid, tiled_map);
+
+    if (! tileset)
+    {
+        return false;
+    }
 
     #ifdef USE_LIBTMX
-    if (tiled_map->tiles[local_id])
+    if (tiled_map->tiles[gid])
     {
-        if (tiled_map->tiles[local_id]->animation)
+        if (tiled_map->tiles[gid]->animation)
         {
             if (animation_length)
             {
-                *animation_length = (int32_t)tiled_map->tiles[local_id]->animation_len;
+                *animation_length = (int32_t)tiled_map->tiles[gid]->animation_len;
             }
             if (id)
             {
-                *id = (int32_t)tiled_map->tiles[local_id]->animation[0].tile_id;
+                *id = (int32_t)tileset->firstgid + (int32_t)tiled_map->tiles[gid]->animation[0].tile_id;
             }
             return true;
         }
     }
 
     #else // (cute_tiled.h)
-    esz_tiled_tileset_t* tileset = tiled_map->tilesets;
-    esz_tiled_tile_t*    tile    = tileset->tiles;
+    int32_t           local_id = gid - tileset->firstgid;
+    esz_tiled_tile_t* tile     = tileset->tiles;
 
     while (tile)
     {
@@ -377,7 +467,7 @@ bool is_tile_animated(int32_t gid, int32_t* animation_length, int32_t* id, esz_t
                 }
                 if (id)
                 {
-                    *id = tile->animation->tileid;
+                    *id = tileset->firstgid + tile->animation->tileid;
                 }
                 return true;
             }
@@ -482,6 +572,96 @@ void load_property(const uint64_t name_hash, esz_tiled_property_t* properties, i
     #endif
 }
 
+/* Resolves the collision properties of every tile once, indexed by
+ * gid, so they don't have to be looked up for each cell.
+ */
+void load_tile_flags(uint32_t* tile_flag, int32_t tile_flag_count, esz_core_t* core)
+{
+    #ifdef USE_LIBTMX
+    for (int32_t gid = 1; gid < tile_flag_count && gid < (int32_t)core->map->handle->tilecount; gid += 1)
+    {
+        esz_tiled_tile_t* tile = core->map->handle->tiles[gid];
+
+        if (! tile || ! tile->properties)
+        {
+            continue;
+        }
+
+        if (get_boolean_property(H_climbable, tile->properties, 0, core))
+        {
+            SET_STATE(tile_flag[gid], TILE_CLIMBABLE);
+        }
+
+        if (get_boolean_property(H_solid_above, tile->properties, 0, core))
+        {
+            SET_STATE(tile_flag[gid], TILE_SOLID_ABOVE);
+        }
+
+        if (get_boolean_property(H_solid_below, tile->properties, 0, core))
+        {
+            SET_STATE(tile_flag[gid], TILE_SOLID_BELOW);
+        }
+
+        if (get_boolean_property(H_solid_left, tile->properties, 0, core))
+        {
+            SET_STATE(tile_flag[gid], TILE_SOLID_LEFT);
+        }
+
+        if (get_boolean_property(H_solid_right, tile->properties, 0, core))
+        {
+            SET_STATE(tile_flag[gid], TILE_SOLID_RIGHT);
+        }
+    }
+
+    #else // (cute_tiled.h)
+    for (esz_tiled_tileset_t* tileset = core->map->handle->tilesets; tileset; tileset = tileset->next)
+    {
+        for (esz_tiled_tile_t* tile = tileset->tiles; tile; tile = tile->next)
+        {
+            int32_t gid = tileset->firstgid + tile->tile_index;
+
+            if (gid >= tile_flag_count)
+            {
+                continue;
+            }
+
+            // One pass over the properties instead of one per flag.
+            for (int index = 0; index < tile->property_count; index += 1)
+            {
+                esz_tiled_property_t* property = &tile->properties[index];
+
+                if (CUTE_TILED_PROPERTY_BOOL != property->type || ! property->data.boolean)
+                {
+                    continue;
+                }
+
+                switch (generate_hash((const unsigned char*)property->name.ptr))
+                {
+                    case H_climbable:
+                        SET_STATE(tile_flag[gid], TILE_CLIMBABLE);
+                        break;
+                    case H_solid_above:
+                        SET_STATE(tile_flag[gid], TILE_SOLID_ABOVE);
+                        break;
+                    case H_solid_below:
+                        SET_STATE(tile_flag[gid], TILE_SOLID_BELOW);
+                        break;
+                    case H_solid_left:
+                        SET_STATE(tile_flag[gid], TILE_SOLID_LEFT);
+                        break;
+                    case H_solid_right:
+                        SET_STATE(tile_flag[gid], TILE_SOLID_RIGHT);
+                        break;
+                    default:
+                        break;
+                }
+            }
+        }
+    }
+
+    #endif
+}
+
 esz_status load_tiled_map(const char* map_file_name, esz_core_t* core)
 {
     FILE* fp = fopen(map_file_name, "r");
@@ -497,6 +677,7 @@ esz_status load_tiled_map(const char* map_file_name, esz_core_t* core)
     }
 
     #ifdef USE_LIBTMX
+    tmx_alloc_func    = tmxlib_realloc;
     core->map->handle = (esz_tiled_map_t*)tmx_load(map_file_name);
     if (! core->map->handle)
     {
@@ -507,11 +688,47 @@ esz_status load_tiled_map(const char* map_file_name, esz_core_t* core)
     #else // (cute_tiled.h)
     esz_tiled_layer_t* layer;
 
-    core->map->handle = (esz_tiled_map_t*)cute_tiled_load_map_from_file(map_file_name, NULL);
-    if (! core->map->handle)
+    if (is_map_file(map_file_name))
     {
-        plog_error("%s: %s.", __func__, cute_tiled_error_reason);
-        return ESZ_WARNING;
+        if (ESZ_OK != load_map_file(map_file_name, core))
+        {
+            return ESZ_WARNING;
+        }
+    }
+    else
+    {
+        esz_tiled_json_t json;
+
+        /* The tile data is decoded ahead of cute_tiled, which then only
+         * parses what is left of the document.  Maps the reader can't
+         * handle are parsed as a whole.
+         */
+        if (read_tiled_json(map_file_name, &json) && INT32_MAX > json.text_length)
+        {
+            int32_t next_index = 0;
+
+            core->map->handle = (esz_tiled_map_t*)cute_tiled_load_map_from_memory(json.text, (int)json.text_length, NULL);
+            if (core->map->handle)
+            {
+                if (! set_tile_layer_data(get_head_layer(core->map->handle), &next_index, &json) || next_index != json.tile_data_count)
+                {
+                    cute_tiled_free_map(core->map->handle);
+                    core->map->handle = NULL;
+                }
+            }
+        }
+        free_tiled_json(&json);
+
+        if (! core->map->handle)
+        {
+            core->map->handle = (esz_tiled_map_t*)cute_tiled_load_map_from_file(map_file_name, NULL);
+        }
+
+        if (! core->map->handle)
+        {
+            plog_error("%s: %s.", __func__, cute_tiled_error_reason);
+            return ESZ_WARNING;
+        }
     }
 
     layer = get_head_layer(core->map->handle);
@@ -546,53 +763,135 @@ int32_t remove_gid_flip_bits(int32_t gid)
     #endif
 }
 
-bool tile_has_properties(int32_t gid, esz_tiled_tile_t** tile, esz_tiled_map_t* tiled_map)
+void unload_tiled_map(esz_core_t* core)
 {
-    int32_t local_id;
-
     #ifdef USE_LIBTMX
-    return true;
+    if (core->map->handle)
+    {
+        tmx_map_free(core->map->handle);
+    }
 
     #else // (cute_tiled.h)
-    local_id = gid - get_first_gid(tiled_map);
+    core->map->hash_id_objectgroup = 0;
+    core->map->hash_id_tilelayer   = 0;
 
-    while ((*tile))
+    if (core->map->binary_map)
     {
-        if ((*tile)->tile_index == local_id)
-        {
-            if (0 < (*tile)->property_count)
-            {
-                return true;
-            }
-        }
-        (*tile) = (*tile)->next;
+        unload_map_file(core);
+    }
+    else if (core->map->handle)
+    {
+        cute_tiled_free_map(core->map->handle);
     }
+    #endif
+}
+
+static tileset_entry_t* get_tileset_entry(int32_t index, esz_tiled_map_t* tiled_map)
+{
+    #ifdef USE_LIBTMX
+    tileset_entry_t* tileset = tiled_map->ts_head;
+
+    #else // (cute_tiled.h)
+    tileset_entry_t* tileset = tiled_map->tilesets;
 
     #endif
 
-    return false;
+    while (tileset && 0 < index)
+    {
+        index   -= 1;
+        tileset  = tileset->next;
+    }
+
+    return tileset;
 }
 
-void unload_tiled_map(esz_core_t* core)
+static tileset_entry_t* get_tileset_entry_of_gid(int32_t gid, esz_tiled_map_t* tiled_map)
 {
+    tileset_entry_t* match = NULL;
+
     #ifdef USE_LIBTMX
-    if (core->map->handle)
+    tileset_entry_t* tileset = tiled_map->ts_head;
+
+    #else // (cute_tiled.h)
+    tileset_entry_t* tileset = tiled_map->tilesets;
+
+    #endif
+
+    // The tileset with the highest first GID not above gid contains it.
+    while (tileset)
     {
-        tmx_map_free(core->map->handle);
+        if ((int32_t)tileset->firstgid <= gid)
+        {
+            if (! match || match->firstgid < tileset->firstgid)
+            {
+                match = tileset;
+            }
+        }
+        tileset = tileset->next;
     }
 
-    #else // (cute_tiled.h)
-    core->map->hash_id_objectgroup = 0;
-    core->map->hash_id_tilelayer   = 0;
+    return match;
+}
 
-    if (core->map->handle)
+#ifndef USE_LIBTMX
+/* Hands the tile data decoded by read_tiled_json() over to the tile
+ * layers of the parsed map, matched by layer ID or, for maps written
+ * without IDs, by document order.
+ */
+static bool set_tile_layer_data(esz_tiled_layer_t* layer, int32_t* next_index, esz_tiled_json_t* json)
+{
+    while (layer)
     {
-        cute_tiled_free_map(core->map->handle);
+        if (layer->layers && ! set_tile_layer_data(layer->layers, next_index, json))
+        {
+            return false;
+        }
+
+        if (H_tilelayer == generate_hash((const unsigned char*)layer->type.ptr))
+        {
+            esz_tile_data_t* tile_data = NULL;
+
+            if (*next_index < json->tile_data_count && layer->id == json->tile_data[*next_index].layer_id)
+            {
+                tile_data = &json->tile_data[*next_index];
+            }
+            else
+            {
+                for (int32_t index = 0; index < json->tile_data_count; index += 1)
+                {
+                    if (0 != layer->id && layer->id == json->tile_data[index].layer_id)
+                    {
+                        tile_data = &json->tile_data[index];
+                        break;
+                    }
+                }
+            }
+
+            if (! tile_data || ! tile_data->gid || tile_data->gid_count != layer->width * layer->height)
+            {
+                return false;
+            }
+
+            free(layer->data);
+            layer->data       = (int*)tile_data->gid;
+            layer->data_count = tile_data->gid_count;
+            tile_data->gid    = NULL;
+            *next_index      += 1;
+        }
+
+        layer = layer->next;
     }
-    #endif
+
+    return true;
+}
+
+#else // (libTMX)
+// libTMX doesn't pass the old size, so its regrowth is counted in full.
+static void* tmxlib_realloc(void* ptr, size_t size)
+{
+    return realloc_counted(ptr, 0, size);
 }
 
-#ifdef USE_LIBTMX
 static void tmxlib_store_property(esz_tiled_property_t* property, void* core)
 {
     esz_core_t* core_ptr = core;
@@ -0,0 +1,316 @@
+// SPDX-License-Identifier: MIT
+/**
+ * @file    esz_event.c
+ * @brief   eszFW event bus
+ */
+
+#include <picolog.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <SDL.h>
+
+#include "esz_event.h"
+#include "esz_types.h"
+
+static void call_subscribers(const esz_bus_event_t* event, const esz_dispatch_mode mode, esz_window_t* window, esz_core_t* core);
+static bool has_subscriber(const esz_event_type event_type, const esz_dispatch_mode mode, esz_event_bus_t* bus);
+static void remove_unsubscribed(esz_event_bus_t* bus);
+static bool take_event(esz_bus_event_t* event, esz_event_bus_t* bus);
+
+void dispatch_deferred_events(esz_window_t* window, esz_core_t* core)
+{
+    esz_event_bus_t* bus = &core->event_bus;
+
+    // Handlers must not dispatch the events they are called for again.
+    if (0 < bus->dispatch_depth)
+    {
+        return;
+    }
+
+    bus->dispatch_depth += 1;
+
+    for (int32_t index = 0; index < bus->deferred_count; index += 1)
+    {
+        call_subscribers(&bus->deferred[index], DISPATCH_DEFERRED, window, core);
+    }
+
+    bus->deferred_count  = 0;
+    bus->dispatch_depth -= 1;
+
+    remove_unsubscribed(bus);
+}
+
+void free_event_bus(esz_event_bus_t* bus)
+{
+    free(bus->subscriber);
+    free(bus->deferred);
+    free(bus->slot);
+
+    memset(bus, 0, sizeof(esz_event_bus_t));
+}
+
+esz_status init_event_bus(esz_event_bus_t* bus)
+{
+    memset(bus, 0, sizeof(esz_event_bus_t));
+
+    bus->slot     = (esz_event_slot_t*)calloc(EVENT_QUEUE_SIZE, sizeof(esz_event_slot_t));
+    bus->deferred = (esz_bus_event_t*)calloc(EVENT_QUEUE_SIZE, sizeof(esz_bus_event_t));
+
+    if (! bus->slot || ! bus->deferred)
+    {
+        plog_error("%s: error allocating memory.", __func__);
+        free_event_bus(bus);
+        return ESZ_ERROR_CRITICAL;
+    }
+
+    // A slot is free for the producer whose position matches its sequence.
+    for (int32_t index = 0; index < EVENT_QUEUE_SIZE; index += 1)
+    {
+        SDL_AtomicSet(&bus->slot[index].sequence, index);
+    }
+
+    return ESZ_OK;
+}
+
+bool post_engine_event(const esz_event_type event_type, const SDL_Event* handle, int32_t value, esz_core_t* core)
+{
+    esz_bus_event_t event = { 0 };
+
+    if (handle)
+    {
+        event.handle = *handle;
+    }
+
+    event.type  = event_type;
+    event.value = value;
+
+    return post_event(&event, &core->event_bus);
+}
+
+/* Multi-producer enqueue after Dmitry Vyukov's bounded queue: producers
+ * claim a slot by advancing the tail and publish it by bumping the
+ * slot's sequence number, so posting never blocks.  Events posted while
+ * the queue is full are dropped and counted.
+ */
+bool post_event(esz_bus_event_t* event, esz_event_bus_t* bus)
+{
+    esz_event_slot_t* slot;
+    unsigned int      pos;
+
+    if (! bus->slot)
+    {
+        return false;
+    }
+
+    event->timestamp = SDL_GetPerformanceCounter();
+
+    pos = (unsigned int)SDL_AtomicGet(&bus->tail);
+
+    for (;;)
+    {
+        int difference;
+
+        slot       = &bus->slot[pos & (EVENT_QUEUE_SIZE - 1)];
+        difference = (int)((unsigned int)SDL_AtomicGet(&slot->sequence) - pos);
+
+        if (0 == difference)
+        {
+            if (SDL_AtomicCAS(&bus->tail, (int)pos, (int)(pos + 1)))
+            {
+                break;
+            }
+            pos = (unsigned int)SDL_AtomicGet(&bus->tail);
+        }
+        else if (0 > difference)
+        {
+            SDL_AtomicAdd(&bus->dropped_count, 1);
+            return false;
+        }
+        else
+        {
+            pos = (unsigned int)SDL_AtomicGet(&bus->tail);
+        }
+    }
+
+    slot->event = *event;
+
+    SDL_MemoryBarrierRelease();
+    SDL_AtomicSet(&slot->sequence, (int)(pos + 1));
+
+    return true;
+}
+
+/* Called once per frame right after the input has been polled.  Events
+ * left over for deferred subscribers are dispatched first, at the
+ * latest point they can wait for.
+ */
+void process_events(esz_window_t* window, esz_core_t* core)
+{
+    esz_event_bus_t* bus = &core->event_bus;
+    esz_bus_event_t  event;
+    int32_t          dropped_count;
+
+    if (! bus->slot || 0 < bus->dispatch_depth)
+    {
+        return;
+    }
+
+    dispatch_deferred_events(window, core);
+
+    dropped_count = SDL_AtomicSet(&bus->dropped_count, 0);
+    if (0 < dropped_count)
+    {
+        plog_warn("%s: event queue full, %d event(s) dropped.", __func__, dropped_count);
+    }
+
+    bus->dispatch_depth += 1;
+
+    // Events posted by handlers are kept for the next frame.
+    for (int32_t count = 0; count < EVENT_QUEUE_SIZE && take_event(&event, bus); count += 1)
+    {
+        call_subscribers(&event, DISPATCH_INLINE, window, core);
+
+        if (has_subscriber(event.type, DISPATCH_DEFERRED, bus))
+        {
+            bus->deferred[bus->deferred_count]  = event;
+            bus->deferred_count                += 1;
+        }
+    }
+
+    bus->dispatch_depth -= 1;
+
+    remove_unsubscribed(bus);
+}
+
+esz_status subscribe_event(const esz_event_type event_type, esz_event_handler handler, void* userdata, const esz_dispatch_mode mode, esz_event_bus_t* bus)
+{
+    esz_event_subscriber_t* subscriber;
+
+    for (int32_t index = 0; index < bus->subscriber_count; index += 1)
+    {
+        subscriber = &bus->subscriber[index];
+
+        if (event_type == subscriber->event_type && handler == subscriber->handler && userdata == subscriber->userdata)
+        {
+            subscriber->mode = mode;
+            return ESZ_OK;
+        }
+    }
+
+    if (bus->subscriber_count == bus->subscriber_limit)
+    {
+        int32_t limit = bus->subscriber_limit ? bus->subscriber_limit * 2 : 8;
+
+        subscriber = (esz_event_subscriber_t*)realloc(bus->subscriber, (size_t)limit * sizeof(esz_event_subscriber_t));
+        if (! subscriber)
+        {
+            plog_error("%s: error allocating memory.", __func__);
+            return ESZ_ERROR_CRITICAL;
+        }
+
+        bus->subscriber       = subscriber;
+        bus->subscriber_limit = limit;
+    }
+
+    subscriber             = &bus->subscriber[bus->subscriber_count];
+    subscriber->handler    = handler;
+    subscriber->userdata   = userdata;
+    subscriber->event_type = event_type;
+    subscriber->mode       = mode;
+
+    bus->subscriber_count += 1;
+
+    return ESZ_OK;
+}
+
+/* Subscribers are only marked during a dispatch and removed after it,
+ * so handlers can unsubscribe themselves.
+ */
+void unsubscribe_event(const esz_event_type event_type, esz_event_handler handler, void* userdata, esz_event_bus_t* bus)
+{
+    for (int32_t index = 0; index < bus->subscriber_count; index += 1)
+    {
+        esz_event_subscriber_t* subscriber = &bus->subscriber[index];
+
+        if (event_type == subscriber->event_type && handler == subscriber->handler && userdata == subscriber->userdata)
+        {
+            subscriber->handler = NULL;
+        }
+    }
+
+    if (0 == bus->dispatch_depth)
+    {
+        remove_unsubscribed(bus);
+    }
+}
+
+static void call_subscribers(const esz_bus_event_t* event, const esz_dispatch_mode mode, esz_window_t* window, esz_core_t* core)
+{
+    esz_event_bus_t* bus = &core->event_bus;
+
+    // Handlers may subscribe, which can move the list.
+    for (int32_t index = 0; index < bus->subscriber_count; index += 1)
+    {
+        esz_event_subscriber_t subscriber = bus->subscriber[index];
+
+        if (subscriber.handler && event->type == subscriber.event_type && mode == subscriber.mode)
+        {
+            subscriber.handler(event, subscriber.userdata, window, core);
+        }
+    }
+}
+
+static bool has_subscriber(const esz_event_type event_type, const esz_dispatch_mode mode, esz_event_bus_t* bus)
+{
+    for (int32_t index = 0; index < bus->subscriber_count; index += 1)
+    {
+        esz_event_subscriber_t* subscriber = &bus->subscriber[index];
+
+        if (subscriber->handler && event_type == subscriber->event_type && mode == subscriber->mode)
+        {
+            return true;
+        }
+    }
+
+    return false;
+}
+
+static void remove_unsubscribed(esz_event_bus_t* bus)
+{
+    int32_t count = 0;
+
+    for (int32_t index = 0; index < bus->subscriber_count; index += 1)
+    {
+        if (bus->subscriber[index].handler)
+        {
+            bus->subscriber[count]  = bus->subscriber[index];
+            count                  += 1;
+        }
+    }
+
+    bus->subscriber_count = count;
+}
+
+// The queue has a single consumer, the main thread.
+static bool take_event(esz_bus_event_t* event, esz_event_bus_t* bus)
+{
+    esz_event_slot_t* slot = &bus->slot[bus->head & (EVENT_QUEUE_SIZE - 1)];
+
+    // Published once the sequence is one ahead of the position.
+    if ((unsigned int)SDL_AtomicGet(&slot->sequence) != bus->head + 1)
+    {
+        return false;
+    }
+
+    SDL_MemoryBarrierAcquire();
+    *event = slot->event;
+
+    // Free again for the producer one lap ahead.
+    SDL_MemoryBarrierRelease();
+    SDL_AtomicSet(&slot->sequence, (int)(bus->head + EVENT_QUEUE_SIZE));
+    bus->head += 1;
+
+    return true;
+}
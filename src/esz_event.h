@@ -0,0 +1,32 @@
+// SPDX-License-Identifier: MIT
+/**
+ * @file    esz_event.h
+ * @brief   eszFW event bus
+ * @details Events are posted to a bounded lock-free queue, from any
+ *          thread, and dispatched on the main thread to every
+ *          subscriber of their type: inline subscribers right after the
+ *          input has been polled, deferred subscribers whenever the
+ *          application calls esz_dispatch_events().
+ */
+
+#ifndef ESZ_EVENT_H
+#define ESZ_EVENT_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <SDL.h>
+
+#include "esz_types.h"
+
+#define EVENT_QUEUE_SIZE 256 // Must be a power of two.
+
+void       dispatch_deferred_events(esz_window_t* window, esz_core_t* core);
+void       free_event_bus(esz_event_bus_t* bus);
+esz_status init_event_bus(esz_event_bus_t* bus);
+bool       post_engine_event(const esz_event_type event_type, const SDL_Event* handle, int32_t value, esz_core_t* core);
+bool       post_event(esz_bus_event_t* event, esz_event_bus_t* bus);
+void       process_events(esz_window_t* window, esz_core_t* core);
+esz_status subscribe_event(const esz_event_type event_type, esz_event_handler handler, void* userdata, const esz_dispatch_mode mode, esz_event_bus_t* bus);
+void       unsubscribe_event(const esz_event_type event_type, esz_event_handler handler, void* userdata, esz_event_bus_t* bus);
+
+#endif // ESZ_EVENT_H
@@ -4,11 +4,37 @@
  * @brief eszFW hash table and hash generator
  */
 
+#include <stddef.h>
 #include <stdint.h>
 
+#include "esz_macros.h"
+
+DISABLE_WARNING_PUSH
+DISABLE_WARNING_PADDING
+DISABLE_WARNING_SPECTRE_MITIGATION
+
+#include <cwalk.h>
+
+DISABLE_WARNING_POP
+
+#include "esz_hash.h"
+
 /* djb2 by Dan Bernstein
  * http://www.cse.yorku.ca/~oz/hash.html
  */
+uint64_t generate_data_hash(const void* data, size_t size)
+{
+    const unsigned char* byte = (const unsigned char*)data;
+    uint64_t             hash = 5381;
+
+    for (size_t index = 0; index < size; index += 1)
+    {
+        hash = ((hash << 5) + hash) + byte[index];
+    }
+
+    return hash;
+}
+
 uint64_t generate_hash(const unsigned char* name)
 {
     uint64_t hash = 5381;
@@ -21,3 +47,17 @@ uint64_t generate_hash(const unsigned char* name)
 
     return hash;
 }
+
+/* Paths are normalised first, so e.g. res/maps/../tilesets/city.png and
+ * res/tilesets/city.png refer to the same asset.  Paths that do not fit
+ * into the buffer are used as given.
+ */
+const char* normalise_asset_path(const char* file_name, char* normalised, size_t size)
+{
+    if (size <= cwk_path_normalize(file_name, normalised, size))
+    {
+        return file_name;
+    }
+
+    return normalised;
+}
@@ -7,8 +7,11 @@
 #ifndef ESZ_HASHES_H
 #define ESZ_HASHES_H
 
+#include <stddef.h>
 #include <stdint.h>
 
+#define ASSET_PATH_MAX                 256
+
 #define H_acceleration                 0xce26e518186a848f
 #define H_anim_id_idle                 0xce63c6afa347d913
 #define H_anim_id_jump                 0xce63c6afa348adf1
@@ -19,11 +22,15 @@
 #define H_background_is_top_aligned    0xe10d87b900773f85
 #define H_background_layer_shift       0xf42f15f4c255007e
 #define H_climbable                    0x0377c455420b8600
+#define H_compression                  0xc07ab290700c0197
 #define H_connect_horizontal_map_ends  0xb2d77d5c88cb679e
 #define H_connect_vertical_map_ends    0x8fd9bf6992bca50e
+#define H_data                         0x000000017c95915f
+#define H_encoding                     0x001ae6ffb4325b0c
 #define H_actor                        0x000000310f128ebe
 #define H_gravitation                  0xc090e5ec12404d2d
 #define H_height                       0x0000065301d688de
+#define H_id                           0x0000000000597832
 #define H_is_affected_by_gravity       0xd7df2608f228f6d1
 #define H_is_animated                  0xc09beeb13eae4983
 #define H_is_in_background             0xdba806855b4839b6
@@ -33,6 +40,7 @@
 #define H_is_moving                    0x0377cc4471f37f30
 #define H_is_player                    0x0377cc4478b16e8d
 #define H_jumping_power                0x702da8a7606d92ab
+#define H_layers                       0x000006530aeb8835
 #define H_max_velocity_x               0xa1d4b1b096163590
 #define H_meter_in_pixel               0xfbbc8a6d4a407cf9
 #define H_opengl                       0x0000065312ef9eea
@@ -57,6 +65,8 @@
 #define H_tilelayer                    0x0377d9f70e844fb0
 #endif
 
-uint64_t generate_hash(const unsigned char* name);
+uint64_t    generate_data_hash(const void* data, size_t size);
+uint64_t    generate_hash(const unsigned char* name);
+const char* normalise_asset_path(const char* file_name, char* normalised, size_t size);
 
 #endif // ESZ_HASHES_H
@@ -11,6 +11,7 @@
 #include <SDL.h>
 
 #include "esz_macros.h"
+#include "esz_utils.h"
 
 DISABLE_WARNING_PUSH
 DISABLE_WARNING_PADDING
@@ -19,6 +20,9 @@ DISABLE_WARNING_SPECTRE_MITIGATION
 #ifndef STB_IMAGE_IMPLEMENTATION
 #define STB_IMAGE_IMPLEMENTATION
 #endif
+#define STBI_MALLOC(size)                       malloc_counted(size)
+#define STBI_REALLOC_SIZED(ptr, old_size, size) realloc_counted(ptr, old_size, size)
+#define STBI_FREE(ptr)                          free(ptr)
 #include <stb_image.h>
 #include <stb_sprintf.h>
 
@@ -29,63 +33,140 @@ DISABLE_WARNING_SYMBOL_NOT_DEFINED
 
 DISABLE_WARNING_POP
 
+#include "esz_atlas.h"
+#include "esz_cache.h"
 #include "esz_compat.h"
 #include "esz_hash.h"
 #include "esz_init.h"
+#include "esz_pack.h"
+#include "esz_qoi.h"
+#include "esz_trace.h"
 #include "esz_types.h"
 #include "esz_utils.h"
 
-static esz_status load_background_layer(int32_t index, esz_window_t* window, esz_core_t* core);
-
-esz_status load_animated_tiles(esz_core_t* core)
+#define DECODE_THREAD_MAX 16
+
+static char*      create_image_source(const char* property_prefix, int32_t index, esz_core_t* core);
+static esz_status create_texture_from_pixels(unsigned char* pixels, int32_t width, int32_t height, SDL_Texture** texture, esz_window_t* window);
+static esz_status decode_image(esz_image_t* image, esz_window_t* window);
+static int        decode_image_queue(void* data);
+static esz_status decode_images(esz_image_t* image, int32_t image_count, esz_window_t* window, SDL_atomic_t* cancelled);
+static esz_status decode_pixels(const char* file_name, const unsigned char* buffer, size_t length, unsigned char** pixels, int32_t* width, int32_t* height);
+static int32_t    get_image_property_count(const char* property_prefix, esz_core_t* core);
+static esz_status load_background_layer(int32_t index, esz_core_t* core);
+static esz_status load_entity_table(esz_core_t* core);
+static void       premultiply_alpha(unsigned char* pixels, int32_t pixel_count);
+static esz_status reserve_entries(void** entry, int32_t entry_count, int32_t* entry_limit, size_t size);
+
+void free_map_images(esz_image_t* image, int32_t image_count)
 {
-    esz_tiled_layer_t* layer               = get_head_layer(core->map->handle);
-    int32_t            animated_tile_count = 0;
+    if (! image)
+    {
+        return;
+    }
 
-    while (layer)
+    for (int32_t index = 0; index < image_count; index += 1)
     {
-        if (is_tiled_layer_of_type(ESZ_TILE_LAYER, layer, core) && layer->visible)
+        if (image[index].pixels)
         {
-            for (int32_t index_height = 0; index_height < (int32_t)core->map->handle->height; index_height += 1)
-            {
-                for (int32_t index_width = 0; index_width < (int32_t)core->map->handle->width; index_width += 1)
-                {
-                    int32_t* layer_content = get_layer_content(layer);
-                    int32_t  gid           = remove_gid_flip_bits((int32_t)layer_content[(index_height * (int32_t)core->map->handle->width) + index_width]);
-
-                    if (is_tile_animated(gid, NULL, NULL, core->map->handle))
-                    {
-                        animated_tile_count += 1;
-                    }
-                }
-            }
+            stbi_image_free(image[index].pixels);
         }
-        layer = layer->next;
+        free(image[index].file_name);
+    }
+
+    free(image);
+}
+
+// Every image referenced by the map, without duplicates.
+esz_status gather_map_images(esz_image_t** image, int32_t* image_count, esz_core_t* core)
+{
+    esz_image_t* images;
+    int32_t      tileset_count          = get_tileset_count(core->map->handle);
+    int32_t      sprite_sheet_count     = get_image_property_count("sprite_sheet", core);
+    int32_t      background_layer_count = get_image_property_count("background_layer", core);
+
+    *image       = NULL;
+    *image_count = 0;
+
+    if (0 >= tileset_count)
+    {
+        plog_error("%s: map has no tileset.", __func__);
+        return ESZ_ERROR_CRITICAL;
     }
 
-    if (0 >= animated_tile_count)
+    images = (esz_image_t*)calloc_counted((size_t)(tileset_count + sprite_sheet_count + background_layer_count), sizeof(struct esz_image));
+    if (! images)
     {
-        return ESZ_OK;
+        plog_error("%s: error allocating memory.", __func__);
+        return ESZ_ERROR_CRITICAL;
     }
-    else
+    *image = images;
+
+    // Gather every image referenced by the map.
+    for (int32_t index = 0; index < tileset_count; index += 1)
     {
-        core->map->animated_tile = (esz_animated_tile_t*)calloc((size_t)animated_tile_count, sizeof(struct esz_animated_tile));
-        if (!core->map->animated_tile)
+        int32_t tileset_path_length = get_tileset_path_length(index, core);
+
+        if (0 >= tileset_path_length)
+        {
+            return ESZ_ERROR_CRITICAL;
+        }
+
+        images[*image_count].file_name = (char*)calloc_counted(1, (size_t)tileset_path_length);
+        if (! images[*image_count].file_name)
         {
             plog_error("%s: error allocating memory.", __func__);
             return ESZ_ERROR_CRITICAL;
         }
+        set_tileset_path(images[*image_count].file_name, tileset_path_length, index, core);
+
+        *image_count += 1;
+    }
+
+    for (int32_t index = 0; index < sprite_sheet_count + background_layer_count; index += 1)
+    {
+        if (index < sprite_sheet_count)
+        {
+            images[*image_count].file_name = create_image_source("sprite_sheet", index, core);
+        }
+        else
+        {
+            images[*image_count].file_name = create_image_source("background_layer", index - sprite_sheet_count, core);
+        }
+
+        if (! images[*image_count].file_name)
+        {
+            return ESZ_ERROR_CRITICAL;
+        }
+
+        *image_count += 1;
+    }
+
+    for (int32_t index = 0; index < *image_count; index += 1)
+    {
+        images[index].hash = generate_hash((const unsigned char*)images[index].file_name);
+
+        // Images referenced more than once are only packed once.
+        for (int32_t other = 0; other < index; other += 1)
+        {
+            if (images[other].hash == images[index].hash)
+            {
+                free(images[index].file_name);
+                images[index]  = images[*image_count - 1];
+                images[*image_count - 1].file_name = NULL;
+                *image_count -= 1;
+                index        -= 1;
+                break;
+            }
+        }
     }
 
-    plog_info("Load %u animated tile(s).", animated_tile_count);
     return ESZ_OK;
 }
 
-esz_status load_background(esz_window_t* window, esz_core_t* core)
+esz_status load_background(esz_core_t* core)
 {
-    char    property_name[21] = { 0 };
-    bool    search_is_running = true;
-    int32_t prop_cnt          = get_map_property_count(core->map->handle);
+    int32_t prop_cnt = get_map_property_count(core->map->handle);
 
     core->map->background.layer_shift = get_decimal_property(H_background_layer_shift, core->map->handle->properties, prop_cnt, core);
     core->map->background.velocity    = get_decimal_property(H_background_constant_velocity, core->map->handle->properties, prop_cnt, core);
@@ -104,28 +185,14 @@ esz_status load_background(esz_window_t* window, esz_core_t* core)
         core->map->background.alignment = ESZ_BOT;
     }
 
-    core->map->background.layer_count = 0;
-    while (search_is_running)
-    {
-        stbsp_snprintf(property_name, (size_t)21, "background_layer_%u", core->map->background.layer_count + 1);
-
-        if (get_string_property(generate_hash((const unsigned char*)property_name), core->map->handle->properties, prop_cnt, core))
-        {
-            core->map->background.layer_count += 1;
-        }
-        else
-        {
-            search_is_running = false;
-            break;
-        }
-    }
+    core->map->background.layer_count = get_image_property_count("background_layer", core);
 
     if (0 == core->map->background.layer_count)
     {
         return ESZ_OK;
     }
 
-    core->map->background.layer = (esz_background_layer_t*)calloc((size_t)core->map->background.layer_count, sizeof(struct esz_background_layer));
+    core->map->background.layer = (esz_background_layer_t*)calloc_counted((size_t)core->map->background.layer_count, sizeof(struct esz_background_layer));
     if (! core->map->background.layer)
     {
         plog_error("%s: error allocating memory.", __func__);
@@ -136,7 +203,10 @@ esz_status load_background(esz_window_t* window, esz_core_t* core)
     {
         for (int32_t index = 0; index < core->map->background.layer_count; index += 1)
         {
-            load_background_layer(index, window, core);
+            if (ESZ_OK != load_background_layer(index, core))
+            {
+                return ESZ_ERROR_CRITICAL;
+            }
         }
     }
     else
@@ -160,6 +230,11 @@ esz_status load_entities(esz_core_t* core)
         return ESZ_OK;
     }
 
+    if (core->map->binary_entity)
+    {
+        return load_entity_table(core);
+    }
+
     while (layer)
     {
         if (is_tiled_layer_of_type(ESZ_OBJECT_GROUP, layer, core))
@@ -176,7 +251,7 @@ esz_status load_entities(esz_core_t* core)
 
     if (core->map->entity_count)
     {
-        core->map->entity = (esz_entity_t*)calloc((size_t)core->map->entity_count, sizeof(struct esz_entity));
+        core->map->entity = (esz_entity_t*)calloc_counted((size_t)core->map->entity_count, sizeof(struct esz_entity));
         if (! core->map->entity)
         {
             plog_error("%s: error allocating memory.", __func__);
@@ -200,6 +275,7 @@ esz_status load_entities(esz_core_t* core)
                 esz_tiled_property_t* properties = tiled_object->properties;
                 int32_t               prop_cnt   = get_object_property_count(tiled_object);
 
+                entity->id    = get_object_id(tiled_object);
                 entity->pos_x = (double)tiled_object->x;
                 entity->pos_y = (double)tiled_object->y;
 
@@ -209,7 +285,7 @@ esz_status load_entities(esz_core_t* core)
                     {
                         esz_actor_t** actor = &entity->actor;
 
-                        (*actor) = (esz_actor_t*)calloc(1, sizeof(struct esz_actor));
+                        (*actor) = (esz_actor_t*)calloc_counted(1, sizeof(struct esz_actor));
                         if (! (*actor))
                         {
                             plog_error("%s: error allocating memory for actor.", __func__);
@@ -313,7 +389,7 @@ esz_status load_entities(esz_core_t* core)
                         {
                             char property_name[26] = { 0 };
 
-                            (*actor)->animation = (esz_animation_t*)calloc((size_t)(*actor)->animation_count, sizeof(struct esz_animation));
+                            (*actor)->animation = (esz_animation_t*)calloc_counted((size_t)(*actor)->animation_count, sizeof(struct esz_animation));
                             if (! (*actor)->animation)
                             {
                                 plog_error("%s: error allocating memory.", __func__);
@@ -358,7 +434,7 @@ esz_status load_entities(esz_core_t* core)
 
                 if (0 >= entity->height)
                 {
-                    entity->width = get_tile_height(core->map->handle);
+                    entity->height = get_tile_height(core->map->handle);
                 }
 
                 update_bounding_box(entity);
@@ -380,7 +456,7 @@ esz_status load_entities(esz_core_t* core)
 
 esz_status load_map_path(const char* map_file_name, esz_core_t* core)
 {
-    core->map->path = (char*)calloc(1, (size_t)(strnlen(map_file_name, 64) + 1));
+    core->map->path = (char*)calloc_counted(1, (size_t)(strnlen(map_file_name, 64) + 1));
     if (! core->map->path)
     {
         plog_error("%s: error allocating memory.", __func__);
@@ -390,178 +466,400 @@ esz_status load_map_path(const char* map_file_name, esz_core_t* core)
     cwk_path_get_dirname(map_file_name, (size_t*)&(core->map->path_length));
     SDL_strlcpy(core->map->path, map_file_name, core->map->path_length + 1);
 
+    // Kept for hot reloading.
+    core->map->file_name = (char*)calloc_counted(1, strlen(map_file_name) + 1);
+    if (! core->map->file_name)
+    {
+        plog_error("%s: error allocating memory.", __func__);
+        return ESZ_ERROR_CRITICAL;
+    }
+    SDL_strlcpy(core->map->file_name, map_file_name, strlen(map_file_name) + 1);
+
     return ESZ_OK;
 }
 
-esz_status load_sprites(esz_window_t* window, esz_core_t* core)
+esz_status load_sprites(esz_core_t* core)
 {
-    char    property_name[17] = { 0 };
-    bool    search_is_running = true;
-    int32_t prop_cnt          = get_map_property_count(core->map->handle);
+    core->map->sprite_sheet_count = get_image_property_count("sprite_sheet", core);
+
+    if (0 == core->map->sprite_sheet_count)
+    {
+        return ESZ_OK;
+    }
 
-    core->map->sprite_sheet_count = 0;
+    core->map->sprite = (esz_sprite_t*)calloc_counted((size_t)core->map->sprite_sheet_count, sizeof(struct esz_sprite));
+    if (! core->map->sprite)
+    {
+        plog_error("%s: error allocating memory.", __func__);
+        return ESZ_ERROR_CRITICAL;
+    }
 
-    while (search_is_running)
+    for (int32_t index = 0; index < core->map->sprite_sheet_count; index += 1)
     {
-        stbsp_snprintf(property_name, 17, "sprite_sheet_%u", core->map->sprite_sheet_count + 1);
+        esz_sprite_t* sprite                    = &core->map->sprite[index];
+        char*         sprite_sheet_image_source = create_image_source("sprite_sheet", index, core);
+        int32_t       page;
 
-        if (get_string_property(generate_hash((const unsigned char*)property_name), core->map->handle->properties, prop_cnt, core))
+        if (! sprite_sheet_image_source)
         {
-            core->map->sprite_sheet_count += 1;
+            return ESZ_ERROR_CRITICAL;
         }
-        else
+
+        sprite->id = index + 1;
+
+        if (! get_atlas_region(generate_hash((const unsigned char*)sprite_sheet_image_source), &page, &sprite->rect, &core->map->atlas))
         {
-            search_is_running = false;
+            plog_error("%s: %s not found in texture atlas.", __func__, sprite_sheet_image_source);
+            free(sprite_sheet_image_source);
+            return ESZ_ERROR_CRITICAL;
         }
+
+        free(sprite_sheet_image_source);
+        sprite->texture = core->map->atlas.page[page].texture;
     }
 
-    if (0 == core->map->sprite_sheet_count)
+    return ESZ_OK;
+}
+
+esz_status load_texture_atlas(const char* map_file_name, esz_window_t* window, esz_core_t* core, SDL_atomic_t* cancelled)
+{
+    esz_status   status          = ESZ_OK;
+    esz_atlas_t  packed          = { 0 };
+    esz_image_t* image           = NULL;
+    char*        cache_file_name = NULL;
+    int32_t      image_count     = 0;
+    int32_t      missing_count   = 0;
+    uint64_t     key;
+
+    status = gather_map_images(&image, &image_count, core);
+    if (ESZ_OK != status)
     {
-        return ESZ_OK;
+        goto exit;
     }
 
-    core->map->sprite = (esz_sprite_t*)calloc((size_t)core->map->sprite_sheet_count, sizeof(struct esz_sprite));
-    if (! core->map->sprite)
+    for (int32_t index = 0; index < image_count; index += 1)
     {
-        plog_error("%s: error allocating memory.", __func__);
-        return ESZ_ERROR_CRITICAL;
+        image[index].key = generate_image_key(&image[index]);
+
+        // Premultiplied pages must not be mistaken for straight ones.
+        if (window->is_premultiplied_alpha_enabled)
+        {
+            image[index].key = ((image[index].key << 5) + image[index].key) ^ 1;
+        }
     }
 
-    for (int32_t index = 0; index < core->map->sprite_sheet_count; index += 1)
+    status = acquire_cached_pages(image, image_count, &missing_count, &core->map->atlas, window);
+    if (ESZ_OK != status || 0 == missing_count)
     {
-        stbsp_snprintf(property_name, 17, "sprite_sheet_%u", index + 1);
+        goto exit;
+    }
+
+    key = generate_atlas_key(image, missing_count);
 
-        const char* file_name = get_string_property(generate_hash((const unsigned char*)property_name), core->map->handle->properties, prop_cnt, core);
+    // The file holds all images of the map, never just the missing ones.
+    if (core->is_atlas_cache_enabled && missing_count == image_count)
+    {
+        size_t cache_file_name_length = strlen(map_file_name) + 7;
 
-        if (file_name)
+        cache_file_name = (char*)calloc_counted(1, cache_file_name_length);
+        if (! cache_file_name)
         {
-            int32_t source_length             = (int32_t)(strnlen(core->map->path, 64) + strnlen(file_name, 64) + 1);
-            char*   sprite_sheet_image_source = (char*)calloc(1, source_length);
-            if (! sprite_sheet_image_source)
-            {
-                plog_error("%s: error allocating memory.", __func__);
-                return ESZ_ERROR_CRITICAL;
-            }
+            plog_error("%s: error allocating memory.", __func__);
+            status = ESZ_ERROR_CRITICAL;
+            goto exit;
+        }
+        stbsp_snprintf(cache_file_name, (int)cache_file_name_length, "%s.atlas", map_file_name);
 
-            stbsp_snprintf(sprite_sheet_image_source, source_length, "%s%s", core->map->path, file_name);
+        if (ESZ_OK == read_atlas_file(cache_file_name, key, window->texture_format, &packed))
+        {
+            status = merge_atlas(&core->map->atlas, &packed);
+            goto exit;
+        }
+    }
 
-            core->map->sprite[index].id = index + 1;
+    status = decode_images(image, missing_count, window, cancelled);
+    if (ESZ_OK != status)
+    {
+        goto exit;
+    }
 
-            if (ESZ_ERROR_CRITICAL == load_texture_from_file(sprite_sheet_image_source, &core->map->sprite[index].texture, window))
-            {
-                free(sprite_sheet_image_source);
-                return ESZ_ERROR_CRITICAL;
-            }
+    status = pack_atlas(image, missing_count, &packed, window);
+    if (ESZ_OK != status)
+    {
+        goto exit;
+    }
 
-            free(sprite_sheet_image_source);
-        }
+    if (cache_file_name)
+    {
+        write_atlas_file(cache_file_name, key, &packed);
     }
 
-    return ESZ_OK;
+    status = merge_atlas(&core->map->atlas, &packed);
+
+exit:
+    // On success the pages are kept in memory until they are uploaded.
+    if (ESZ_OK != status)
+    {
+        free_atlas_pixels(&core->map->atlas);
+    }
+
+    destroy_atlas(&packed);
+    free_map_images(image, image_count);
+    free(cache_file_name);
+
+    return status;
 }
 
-esz_status load_tile_properties(esz_core_t* core)
+/* Every cell of every tile layer is visited exactly once: the scan
+ * resolves the tile properties, gathers the cells to be baked and
+ * registers the animated tiles in one go.
+ */
+esz_status load_tile_layers(esz_core_t* core)
 {
-    esz_tiled_layer_t* layer      = get_head_layer(core->map->handle);
-    int32_t            tile_count = (int32_t)(core->map->handle->height * core->map->handle->width);
-
-    core->map->tile_properties = (uint32_t*)calloc((size_t)tile_count, sizeof(uint32_t));
+    esz_status           status              = ESZ_OK;
+    esz_tiled_layer_t*   layer               = get_head_layer(core->map->handle);
+    esz_animated_tile_t* animation           = NULL;
+    int32_t              map_width           = (int32_t)core->map->handle->width;
+    int32_t              cell_count          = (int32_t)(core->map->handle->height * core->map->handle->width);
+    int32_t              tile_width          = get_tile_width(core->map->handle);
+    int32_t              tile_height         = get_tile_height(core->map->handle);
+    int32_t              animated_tile_limit = 0;
+    int32_t              layer_index         = 0;
+
+    core->map->tile_properties = (uint32_t*)calloc_counted((size_t)cell_count, sizeof(uint32_t));
     if (! core->map->tile_properties)
     {
         plog_error("%s: error allocating memory.", __func__);
         return ESZ_WARNING;
     }
 
+    // Binary maps come with the flags already resolved.
+    if (! core->map->tile_flag)
+    {
+        core->map->tile_flag_count = 1;
+
+        for (int32_t index = 0; index < get_tileset_count(core->map->handle); index += 1)
+        {
+            int32_t last_gid = get_tileset_first_gid(index, core->map->handle) + get_tileset_tile_count(index, core->map->handle);
+
+            if (last_gid > core->map->tile_flag_count)
+            {
+                core->map->tile_flag_count = last_gid;
+            }
+        }
+
+        core->map->tile_flag = (uint32_t*)calloc_counted((size_t)core->map->tile_flag_count, sizeof(uint32_t));
+        if (! core->map->tile_flag)
+        {
+            plog_error("%s: error allocating memory.", __func__);
+            return ESZ_WARNING;
+        }
+
+        load_tile_flags(core->map->tile_flag, core->map->tile_flag_count, core);
+    }
+
+    // Animations are looked up once per gid instead of once per cell.
+    animation = (esz_animated_tile_t*)calloc_counted((size_t)core->map->tile_flag_count, sizeof(struct esz_animated_tile));
+    if (! animation)
+    {
+        plog_error("%s: error allocating memory.", __func__);
+        return ESZ_WARNING;
+    }
+
+    for (int32_t gid = 1; gid < core->map->tile_flag_count; gid += 1)
+    {
+        if (is_tile_animated(gid, &animation[gid].animation_length, &animation[gid].id, core->map->handle))
+        {
+            animation[gid].gid = gid;
+        }
+    }
+
+    while (layer)
+    {
+        if (is_tiled_layer_of_type(ESZ_TILE_LAYER, layer, core) && layer->visible)
+        {
+            core->map->tile_layer_count += 1;
+        }
+        layer = layer->next;
+    }
+
+    if (0 < core->map->tile_layer_count)
+    {
+        core->map->tile_layer = (esz_tile_layer_t*)calloc_counted((size_t)core->map->tile_layer_count, sizeof(struct esz_tile_layer));
+        if (! core->map->tile_layer)
+        {
+            plog_error("%s: error allocating memory.", __func__);
+            status = ESZ_WARNING;
+            goto exit;
+        }
+    }
+
+    layer = get_head_layer(core->map->handle);
     while (layer)
     {
         if (is_tiled_layer_of_type(ESZ_TILE_LAYER, layer, core))
         {
-            for (int32_t index_height = 0; index_height < (int32_t)core->map->handle->height; index_height += 1)
+            int32_t*          layer_content = get_layer_content(layer);
+            esz_tile_layer_t* tile_layer    = NULL;
+            int32_t           cell_limit    = 0;
+            bool              is_animated   = false;
+
+            // Invisible layers only contribute their tile properties.
+            if (layer->visible)
             {
-                for (int32_t index_width = 0; index_width < (int32_t)core->map->handle->width; index_width += 1)
+                int32_t prop_cnt = get_layer_property_count(layer);
+
+                tile_layer        = &core->map->tile_layer[layer_index];
+                tile_layer->name  = get_layer_name(layer);
+                tile_layer->level = ESZ_MAP_LAYER_BG;
+
+                if (get_boolean_property(H_is_in_foreground, layer->properties, prop_cnt, core))
                 {
-                    esz_tiled_tileset_t* tileset       = get_head_tileset(core->map->handle);
-                    esz_tiled_tile_t*    tile          = tileset->tiles;
-                    int32_t*             layer_content = get_layer_content(layer);
-                    int32_t              gid           = remove_gid_flip_bits((int32_t)layer_content[(index_height * (int32_t)core->map->handle->width) + index_width]);
-                    int32_t              tile_index    = (index_width + 1) * (index_height + 1);
+                    tile_layer->level = ESZ_MAP_LAYER_FG;
+                }
 
-                    if (tile_has_properties(gid, &tile, core->map->handle))
-                    {
-                        int32_t prop_cnt  = get_tile_property_count(tile);
+                // Remark: animated tiles are always rendered in the background layer.
+                is_animated  = ESZ_MAP_LAYER_BG == tile_layer->level;
+                layer_index += 1;
+            }
 
-                        if (get_boolean_property(H_climbable, tile->properties, prop_cnt, core))
-                        {
-                            SET_STATE(core->map->tile_properties[tile_index], TILE_CLIMBABLE);
-                        }
+            for (int32_t index = 0; index < cell_count; index += 1)
+            {
+                int32_t gid = remove_gid_flip_bits((int32_t)layer_content[index]);
+                int32_t dst_x;
+                int32_t dst_y;
 
-                        if (get_boolean_property(H_solid_above, tile->properties, prop_cnt, core))
-                        {
-                            SET_STATE(core->map->tile_properties[tile_index], TILE_SOLID_ABOVE);
-                        }
+                if (0 >= gid || gid >= core->map->tile_flag_count)
+                {
+                    continue;
+                }
 
-                        if (get_boolean_property(H_solid_below, tile->properties, prop_cnt, core))
-                        {
-                            SET_STATE(core->map->tile_properties[tile_index], TILE_SOLID_BELOW);
-                        }
+                core->map->tile_properties[index] |= core->map->tile_flag[gid];
 
-                        if (get_boolean_property(H_solid_left, tile->properties, prop_cnt, core))
-                        {
-                            SET_STATE(core->map->tile_properties[tile_index], TILE_SOLID_LEFT);
-                        }
+                if (! tile_layer)
+                {
+                    continue;
+                }
 
-                        if (get_boolean_property(H_solid_right, tile->properties, prop_cnt, core))
-                        {
-                            SET_STATE(core->map->tile_properties[tile_index], TILE_SOLID_RIGHT);
-                        }
+                dst_x = (index % map_width) * tile_width;
+                dst_y = (index / map_width) * tile_height;
+
+                if (ESZ_OK != reserve_entries((void**)&tile_layer->cell, tile_layer->cell_count, &cell_limit, sizeof(struct esz_tile_cell)))
+                {
+                    status = ESZ_WARNING;
+                    goto exit;
+                }
+
+                tile_layer->cell[tile_layer->cell_count].dst_x = dst_x;
+                tile_layer->cell[tile_layer->cell_count].dst_y = dst_y;
+                tile_layer->cell[tile_layer->cell_count].gid   = gid;
+                tile_layer->cell_count += 1;
+
+                if (is_animated && 0 < animation[gid].gid)
+                {
+                    if (ESZ_OK != reserve_entries((void**)&core->map->animated_tile, core->map->animated_tile_index, &animated_tile_limit, sizeof(struct esz_animated_tile)))
+                    {
+                        status = ESZ_WARNING;
+                        goto exit;
                     }
+
+                    core->map->animated_tile[core->map->animated_tile_index]       = animation[gid];
+                    core->map->animated_tile[core->map->animated_tile_index].dst_x = dst_x;
+                    core->map->animated_tile[core->map->animated_tile_index].dst_y = dst_y;
+                    core->map->animated_tile_index += 1;
                 }
             }
         }
         layer = layer->next;
     }
 
-    return ESZ_OK;
+    plog_info("Load %d tile layer(s) with %d animated tile(s).", core->map->tile_layer_count, core->map->animated_tile_index);
+
+exit:
+    free(animation);
+
+    return status;
 }
 
-esz_status load_tileset(esz_window_t* window, esz_core_t* core)
+esz_status load_tileset(esz_core_t* core)
 {
-    esz_status status      = ESZ_OK;
-    char*      image_path  = NULL;
-    int32_t    path_length = get_tileset_path_length(core);
+    esz_status status        = ESZ_OK;
+    char*      image_path    = NULL;
+    int32_t    tileset_count = get_tileset_count(core->map->handle);
 
-    image_path = calloc(1, path_length);
-    if (! image_path)
+    // Gid 0 is reserved for empty cells, so the table starts there.
+    core->map->tile_count = 1;
+
+    for (int32_t index = 0; index < tileset_count; index += 1)
+    {
+        int32_t last_gid = get_tileset_first_gid(index, core->map->handle) + get_tileset_tile_count(index, core->map->handle);
+
+        if (last_gid > core->map->tile_count)
+        {
+            core->map->tile_count = last_gid;
+        }
+    }
+
+    core->map->tile = (esz_tile_t*)calloc_counted((size_t)core->map->tile_count, sizeof(struct esz_tile));
+    if (! core->map->tile)
     {
         plog_error("%s: error allocating memory.", __func__);
         return ESZ_ERROR_CRITICAL;
     }
 
-    set_tileset_path(image_path, path_length, core);
-
-    if (ESZ_OK != load_texture_from_file(image_path, &core->map->tileset_texture, window))
+    for (int32_t index = 0; index < tileset_count; index += 1)
     {
-        plog_error("%s: Error loading image '%s'.", __func__, image_path);
-        status = ESZ_ERROR_CRITICAL;
+        int32_t  path_length = get_tileset_path_length(index, core);
+        int32_t  first_gid   = get_tileset_first_gid(index, core->map->handle);
+        int32_t  tile_count  = get_tileset_tile_count(index, core->map->handle);
+        int32_t  tile_width  = get_tileset_tile_width(index, core->map->handle);
+        int32_t  tile_height = get_tileset_tile_height(index, core->map->handle);
+        int32_t  page;
+        SDL_Rect rect;
+
+        image_path = (char*)calloc_counted(1, (size_t)path_length);
+        if (! image_path)
+        {
+            plog_error("%s: error allocating memory.", __func__);
+            return ESZ_ERROR_CRITICAL;
+        }
+
+        set_tileset_path(image_path, path_length, index, core);
+
+        if (! get_atlas_region(generate_hash((const unsigned char*)image_path), &page, &rect, &core->map->atlas))
+        {
+            plog_error("%s: %s not found in texture atlas.", __func__, image_path);
+            status = ESZ_ERROR_CRITICAL;
+            break;
+        }
+
+        for (int32_t gid = first_gid; gid < first_gid + tile_count; gid += 1)
+        {
+            esz_tile_t* tile = &core->map->tile[gid];
+
+            get_tile_position(gid, &tile->src.x, &tile->src.y, core->map->handle);
+            tile->src.x += rect.x;
+            tile->src.y += rect.y;
+            tile->src.w  = tile_width;
+            tile->src.h  = tile_height;
+            tile->page   = page;
+        }
+
+        free(image_path);
+        image_path = NULL;
     }
 
     free(image_path);
+
+    plog_info("Load %d tileset(s) with %d tile(s).", tileset_count, core->map->tile_count - 1);
     return status;
 }
 
-/* Based on
- * https://wiki.libsdl.org/SDL_CreateRGBSurfaceWithFormatFrom#Code_Examples
- */
 esz_status load_texture_from_file(const char* file_name, SDL_Texture** texture, esz_window_t* window)
 {
-    SDL_Surface*   surface;
-    int            width;
-    int            height;
-    int            orig_format;
-    int            req_format = STBI_rgb_alpha;
-    int            depth;
-    int            pitch;
-    uint32_t       pixel_format;
+    esz_status     status;
+    int32_t        width;
+    int32_t        height;
     unsigned char* data;
 
     if (! file_name)
@@ -569,56 +867,35 @@ esz_status load_texture_from_file(const char* file_name, SDL_Texture** texture,
         return ESZ_WARNING;
     }
 
-    data = stbi_load(file_name, &width, &height, &orig_format, req_format);
-
-    if (NULL == data)
+    // Assets in the mounted asset pack are decoded from mapped memory.
     {
-        plog_error("%s: %s.", __func__, stbi_failure_reason());
-        return ESZ_ERROR_CRITICAL;
-    }
+        const unsigned char* buffer;
+        size_t               length;
 
-    if (STBI_rgb == req_format)
-    {
-        depth        = 24;
-        pitch        = 3 * width; // 3 bytes per pixel * pixels per row
-        pixel_format = SDL_PIXELFORMAT_RGB24;
-    }
-    else
-    {
-        // STBI_rgb_alpha (RGBA)
-        depth        = 32;
-        pitch        = 4 * width;
-        pixel_format = SDL_PIXELFORMAT_RGBA32;
+        if (find_in_asset_pack(file_name, &buffer, &length, &window->asset_pack))
+        {
+            plog_info("Loading image from asset pack: %s.", file_name);
+            return load_texture_from_memory(buffer, (int)length, texture, window);
+        }
     }
 
-    surface = SDL_CreateRGBSurfaceWithFormatFrom((void*)data, width, height, depth, pitch, pixel_format);
-
-    if (NULL == surface)
+    if (ESZ_OK != decode_pixels(file_name, NULL, 0, &data, &width, &height))
     {
-        plog_error("%s: %s.", __func__, SDL_GetError());
-        stbi_image_free(data);
         return ESZ_ERROR_CRITICAL;
     }
 
-    *texture = SDL_CreateTextureFromSurface(window->renderer, surface);
-
-    SDL_FreeSurface(surface);
+    status = create_texture_from_pixels(data, width, height, texture, window);
     stbi_image_free(data);
 
     plog_info("Loading image from file: %s.", file_name);
-    return ESZ_OK;
+    return status;
 }
 
 esz_status load_texture_from_memory(const unsigned char* buffer, const int length, SDL_Texture** texture, esz_window_t* window)
 {
-    SDL_Surface*   surface;
-    int            width;
-    int            height;
-    int            orig_format;
-    int            req_format = STBI_rgb_alpha;
-    int            depth;
-    int            pitch;
-    uint32_t       pixel_format;
+    esz_status     status;
+    int32_t        width;
+    int32_t        height;
     unsigned char* data;
 
     if (! buffer)
@@ -626,145 +903,455 @@ esz_status load_texture_from_memory(const unsigned char* buffer, const int lengt
         return ESZ_WARNING;
     }
 
-    data = stbi_load_from_memory(buffer, length, &width, &height, &orig_format, req_format);
-
-    if (NULL == data)
+    if (ESZ_OK != decode_pixels(NULL, buffer, (size_t)length, &data, &width, &height))
     {
-        plog_error("%s: %s.", __func__, stbi_failure_reason());
         return ESZ_ERROR_CRITICAL;
     }
 
-    if (STBI_rgb == req_format)
+    status = create_texture_from_pixels(data, width, height, texture, window);
+    stbi_image_free(data);
+
+    plog_info("Loading image from memory.");
+    return status;
+}
+
+/* Decodes an edited image and writes it over its region of the
+ * uploaded texture atlas.  The page and region are returned, so the
+ * tiles drawn from it can be baked again.
+ */
+esz_status reload_map_image(const char* file_name, int32_t* page, SDL_Rect* rect, esz_window_t* window, esz_core_t* core)
+{
+    esz_image_t image = { 0 };
+    esz_status  status;
+
+    image.file_name = (char*)file_name;
+    image.hash      = generate_hash((const unsigned char*)file_name);
+
+    // The file may still be in the middle of being written.
+    if (ESZ_OK != decode_image(&image, window))
     {
-        depth        = 24;
-        pitch        = 3 * width; // 3 bytes per pixel * pixels per row
-        pixel_format = SDL_PIXELFORMAT_RGB24;
+        return ESZ_WARNING;
     }
-    else
+
+    status = update_atlas_image(&image, page, rect, &core->map->atlas);
+    stbi_image_free(image.pixels);
+
+    return status;
+}
+
+static char* create_image_source(const char* property_prefix, int32_t index, esz_core_t* core)
+{
+    char        property_name[32] = { 0 };
+    char*       image_source;
+    const char* file_name;
+    int32_t     prop_cnt          = get_map_property_count(core->map->handle);
+    int32_t     source_length;
+
+    stbsp_snprintf(property_name, 32, "%s_%d", property_prefix, index + 1);
+
+    file_name = get_string_property(generate_hash((const unsigned char*)property_name), core->map->handle->properties, prop_cnt, core);
+    if (! file_name)
     {
-        // STBI_rgb_alpha (RGBA)
-        depth        = 32;
-        pitch        = 4 * width;
-        pixel_format = SDL_PIXELFORMAT_RGBA32;
+        plog_error("%s: property %s not found.", __func__, property_name);
+        return NULL;
     }
 
-    surface = SDL_CreateRGBSurfaceWithFormatFrom((void*)data, width, height, depth, pitch, pixel_format);
+    source_length = (int32_t)(strnlen(core->map->path, 64) + strnlen(file_name, 64) + 1);
+    image_source  = (char*)calloc_counted(1, source_length);
+    if (! image_source)
+    {
+        plog_error("%s: error allocating memory.", __func__);
+        return NULL;
+    }
+
+    stbsp_snprintf(image_source, source_length, "%s%s", core->map->path, file_name);
+
+    return image_source;
+}
+
+/* Converts the decoded RGBA pixels in place into the renderer's native
+ * texture format and uploads them with a single SDL_UpdateTexture()
+ * call.  This avoids the intermediate surface and the format conversion
+ * SDL_CreateTextureFromSurface() would do.
+ */
+static esz_status create_texture_from_pixels(unsigned char* pixels, int32_t width, int32_t height, SDL_Texture** texture, esz_window_t* window)
+{
+    int32_t pitch = width * 4;
+    TRACE_START(start);
+
+    if (window->is_premultiplied_alpha_enabled)
+    {
+        premultiply_alpha(pixels, width * height);
+    }
 
-    if (NULL == surface)
+    if (SDL_PIXELFORMAT_RGBA32 != window->texture_format)
+    {
+        if (0 > SDL_ConvertPixels(width, height, SDL_PIXELFORMAT_RGBA32, pixels, pitch, window->texture_format, pixels, pitch))
+        {
+            plog_error("%s: %s.", __func__, SDL_GetError());
+            return ESZ_ERROR_CRITICAL;
+        }
+    }
+
+    *texture = SDL_CreateTexture(window->renderer, window->texture_format, SDL_TEXTUREACCESS_STATIC, width, height);
+    if (! *texture)
     {
         plog_error("%s: %s.", __func__, SDL_GetError());
-        stbi_image_free(data);
         return ESZ_ERROR_CRITICAL;
     }
 
-    *texture = SDL_CreateTextureFromSurface(window->renderer, surface);
+    if (0 > SDL_UpdateTexture(*texture, NULL, pixels, pitch))
+    {
+        plog_error("%s: %s.", __func__, SDL_GetError());
+        SDL_DestroyTexture(*texture);
+        *texture = NULL;
+        return ESZ_ERROR_CRITICAL;
+    }
 
-    SDL_FreeSurface(surface);
-    stbi_image_free(data);
+    if (0 > SDL_SetTextureBlendMode(*texture, window->blend_mode))
+    {
+        plog_error("%s: %s.", __func__, SDL_GetError());
+        SDL_DestroyTexture(*texture);
+        *texture = NULL;
+        return ESZ_ERROR_CRITICAL;
+    }
+
+    TRACE_SCOPE("texture", "create_texture", start, SDL_GetPerformanceCounter());
 
-    plog_info("Loading image from memory.");
     return ESZ_OK;
 }
 
-static esz_status load_background_layer(int32_t index, esz_window_t* window, esz_core_t* core)
+static esz_status decode_image(esz_image_t* image, esz_window_t* window)
 {
-    esz_status   status        = ESZ_OK;
-    SDL_Texture* image_texture = NULL;
-    SDL_Rect     dst;
-    int32_t      image_width;
-    int32_t      image_height;
-    int32_t      prop_cnt          = get_map_property_count(core->map->handle);
-    int32_t      source_length     = 0;
-    double       layer_width_factor;
-    char         property_name[21] = { 0 };
-    char*        background_layer_image_source;
-
-    stbsp_snprintf(property_name, 21, "background_layer_%u", index + 1);
-
-    const char* file_name = get_string_property(generate_hash((const unsigned char*)property_name), core->map->handle->properties, prop_cnt, core);
-    source_length = (int32_t)(strnlen(core->map->path, 64) + strnlen(file_name, 64) + 1);
+    const unsigned char* buffer = NULL;
+    size_t               length = 0;
 
-    background_layer_image_source = (char*)calloc(1, source_length);
-    if (! background_layer_image_source)
+    find_in_asset_pack(image->file_name, &buffer, &length, &window->asset_pack);
+
+    if (ESZ_OK != decode_pixels(image->file_name, buffer, length, &image->pixels, &image->width, &image->height))
     {
-        plog_error("%s: error allocating memory.", __func__);
         return ESZ_ERROR_CRITICAL;
     }
 
-    stbsp_snprintf(background_layer_image_source, source_length, "%s%s", core->map->path, file_name);
+    if (window->is_premultiplied_alpha_enabled)
+    {
+        premultiply_alpha(image->pixels, image->width * image->height);
+    }
+
+    plog_info("Loading image from file: %s.", image->file_name);
+    return ESZ_OK;
+}
+
+static int decode_image_queue(void* data)
+{
+    esz_decode_queue_t* queue = (esz_decode_queue_t*)data;
 
-    if (ESZ_ERROR_CRITICAL == load_texture_from_file(background_layer_image_source, &image_texture, window))
+    while (! SDL_AtomicGet(&queue->failed))
     {
-        status = ESZ_ERROR_CRITICAL;
-        goto exit;
+        int32_t index = SDL_AtomicAdd(&queue->next_image, 1);
+
+        // A cancelled load stops all decoders like a failed image does.
+        if (SDL_AtomicGet(queue->cancelled))
+        {
+            SDL_AtomicSet(&queue->failed, 1);
+            break;
+        }
+
+        if (index >= queue->image_count)
+        {
+            break;
+        }
+
+        if (ESZ_OK != decode_image(&queue->image[index], queue->window))
+        {
+            SDL_AtomicSet(&queue->failed, 1);
+        }
     }
 
-    free(background_layer_image_source);
+    return 0;
+}
 
-    if (0 > SDL_QueryTexture(image_texture, NULL, NULL, &image_width, &image_height))
+/* Images are independent of each other, so they are decoded by as many
+ * threads as there are CPU cores.  The calling thread takes part, too.
+ */
+static esz_status decode_images(esz_image_t* image, int32_t image_count, esz_window_t* window, SDL_atomic_t* cancelled)
+{
+    esz_decode_queue_t queue                     = { 0 };
+    SDL_Thread*        thread[DECODE_THREAD_MAX] = { NULL };
+    int32_t            thread_count              = SDL_GetCPUCount() - 1;
+    uint64_t           start                     = SDL_GetPerformanceCounter();
+
+    queue.image       = image;
+    queue.window      = window;
+    queue.cancelled   = cancelled;
+    queue.image_count = image_count;
+
+    if (thread_count > image_count - 1)
     {
-        plog_error("%s: %s.", __func__, SDL_GetError());
-        status = ESZ_ERROR_CRITICAL;
-        goto exit;
+        thread_count = image_count - 1;
     }
 
-    layer_width_factor = ceil((double)window->width / (double)image_width);
+    if (thread_count > DECODE_THREAD_MAX)
+    {
+        thread_count = DECODE_THREAD_MAX;
+    }
 
-    core->map->background.layer[index].width  = image_width * (int32_t)layer_width_factor;
-    core->map->background.layer[index].height = image_height;
+    for (int32_t index = 0; index < thread_count; index += 1)
+    {
+        // If a thread can't be created, the others pick up its share.
+        thread[index] = SDL_CreateThread(decode_image_queue, "esz_decoder", &queue);
+        if (! thread[index])
+        {
+            plog_warn("%s: %s.", __func__, SDL_GetError());
+        }
+    }
 
-    core->map->background.layer[index].texture = SDL_CreateTexture(
-        window->renderer,
-        SDL_PIXELFORMAT_ARGB8888,
-        SDL_TEXTUREACCESS_TARGET,
-        core->map->background.layer[index].width,
-        core->map->background.layer[index].height);
+    decode_image_queue(&queue);
 
-    if (! core->map->background.layer[index].texture)
+    for (int32_t index = 0; index < thread_count; index += 1)
     {
-        plog_error("%s: %s.", __func__, SDL_GetError());
-        status = ESZ_ERROR_CRITICAL;
-        goto exit;
+        if (thread[index])
+        {
+            SDL_WaitThread(thread[index], NULL);
+        }
     }
 
-    if (0 != SDL_SetRenderTarget(window->renderer, core->map->background.layer[index].texture))
+    if (SDL_AtomicGet(&queue.failed))
     {
-        plog_error("%s: %s.", __func__, SDL_GetError());
-        status = ESZ_ERROR_CRITICAL;
-        goto exit;
+        return ESZ_ERROR_CRITICAL;
     }
 
-    dst.x = 0;
-    int32_t pass;
-    for (pass = 0; pass < layer_width_factor; pass += 1)
+    plog_info(
+        "Decode %d image(s) on %d thread(s) in %.2f ms.",
+        image_count,
+        thread_count + 1,
+        (double)(SDL_GetPerformanceCounter() - start) * 1000.0 / (double)SDL_GetPerformanceFrequency());
+
+    return ESZ_OK;
+}
+
+/* Decodes from the buffer if there is one, from the file otherwise.
+ * QOI images skip stb_image.  STBI_FREE() is plain free(), so
+ * stbi_image_free() releases the pixels of either decoder.
+ */
+static esz_status decode_pixels(const char* file_name, const unsigned char* buffer, size_t length, unsigned char** pixels, int32_t* width, int32_t* height)
+{
+    const char* failure_reason = "corrupt QOI image";
+    int         orig_format;
+
+    if (buffer)
+    {
+        if (is_qoi(buffer, length))
+        {
+            *pixels = decode_qoi(buffer, length, width, height);
+        }
+        else
+        {
+            *pixels        = stbi_load_from_memory(buffer, (int)length, width, height, &orig_format, STBI_rgb_alpha);
+            failure_reason = stbi_failure_reason();
+        }
+    }
+    else if (is_qoi_file(file_name))
     {
-        dst.y = 0;
-        dst.w = image_width;
-        dst.h = image_height;
+        void* data = map_file(file_name, &length);
 
-        if (0 > SDL_RenderCopy(window->renderer, image_texture, NULL, &dst))
+        if (! data)
         {
-            plog_error("%s: %s.", __func__, SDL_GetError());
-            status = ESZ_ERROR_CRITICAL;
-            goto exit;
+            return ESZ_ERROR_CRITICAL;
         }
 
-        dst.x += image_width;
+        *pixels = decode_qoi((const unsigned char*)data, length, width, height);
+        unmap_file(data, length);
+    }
+    else
+    {
+        *pixels        = stbi_load(file_name, width, height, &orig_format, STBI_rgb_alpha);
+        failure_reason = stbi_failure_reason();
     }
 
-    if (0 > SDL_SetTextureBlendMode(core->map->background.layer[index].texture, SDL_BLENDMODE_BLEND))
+    if (NULL == *pixels)
     {
-        plog_error("%s: %s.", __func__, SDL_GetError());
-        status = ESZ_ERROR_CRITICAL;
-        goto exit;
+        plog_error("%s: %s: %s.", __func__, file_name ? file_name : "memory", failure_reason);
+        return ESZ_ERROR_CRITICAL;
     }
 
-exit:
-    if (image_texture)
+    return ESZ_OK;
+}
+
+static int32_t get_image_property_count(const char* property_prefix, esz_core_t* core)
+{
+    char    property_name[32] = { 0 };
+    int32_t prop_cnt          = get_map_property_count(core->map->handle);
+    int32_t count             = 0;
+
+    while (true)
     {
-        SDL_DestroyTexture(image_texture);
+        stbsp_snprintf(property_name, 32, "%s_%d", property_prefix, count + 1);
+
+        if (! get_string_property(generate_hash((const unsigned char*)property_name), core->map->handle->properties, prop_cnt, core))
+        {
+            break;
+        }
+
+        count += 1;
     }
 
+    return count;
+}
+
+static esz_status load_background_layer(int32_t index, esz_core_t* core)
+{
+    esz_background_layer_t* layer = &core->map->background.layer[index];
+    int32_t                 page;
+    char*                   background_layer_image_source;
+
+    background_layer_image_source = create_image_source("background_layer", index, core);
+    if (! background_layer_image_source)
+    {
+        return ESZ_ERROR_CRITICAL;
+    }
+
+    if (! get_atlas_region(generate_hash((const unsigned char*)background_layer_image_source), &page, &layer->src, &core->map->atlas))
+    {
+        plog_error("%s: %s not found in texture atlas.", __func__, background_layer_image_source);
+        free(background_layer_image_source);
+        return ESZ_ERROR_CRITICAL;
+    }
+
+    free(background_layer_image_source);
+
+    // The layer is drawn straight from the atlas and repeated at render time.
+    layer->texture = core->map->atlas.page[page].texture;
+    layer->width   = layer->src.w;
+    layer->height  = layer->src.h;
+
     plog_info("Load background layer %d.", index + 1);
-    return status;
+    return ESZ_OK;
+}
+
+// Binary maps carry their entities with the properties already resolved.
+static esz_status load_entity_table(esz_core_t* core)
+{
+    const unsigned char* data         = (const unsigned char*)core->map->binary_map;
+    bool                 player_found = false;
+
+    core->map->entity = (esz_entity_t*)calloc_counted((size_t)core->map->binary_entity_count, sizeof(struct esz_entity));
+    if (! core->map->entity)
+    {
+        plog_error("%s: error allocating memory.", __func__);
+        return ESZ_ERROR_CRITICAL;
+    }
+    core->map->entity_count = core->map->binary_entity_count;
+
+    plog_info("Load %d entities:", core->map->entity_count);
+
+    for (int32_t index = 0; index < core->map->entity_count; index += 1)
+    {
+        const esz_entity_entry_t* entry  = &core->map->binary_entity[index];
+        esz_entity_t*             entity = &core->map->entity[index];
+        const char*               name   = entry->name_offset ? (const char*)(data + entry->name_offset) : "";
+
+        entity->id     = entry->id;
+        entity->pos_x  = entry->pos_x;
+        entity->pos_y  = entry->pos_y;
+        entity->width  = entry->width;
+        entity->height = entry->height;
+
+        if (H_actor == entry->type_hash)
+        {
+            esz_actor_t* actor = (esz_actor_t*)calloc_counted(1, sizeof(struct esz_actor));
+            if (! actor)
+            {
+                plog_error("%s: error allocating memory for actor.", __func__);
+                return ESZ_ERROR_CRITICAL;
+            }
+            entity->actor = actor;
+
+            actor->current_animation           = 1;
+            actor->acceleration                = entry->acceleration;
+            actor->jumping_power               = entry->jumping_power;
+            actor->max_velocity_x              = entry->max_velocity_x;
+            actor->sprite_sheet_id             = entry->sprite_sheet_id;
+            actor->connect_horizontal_map_ends = entry->connect_horizontal_map_ends;
+            actor->connect_vertical_map_ends   = entry->connect_vertical_map_ends;
+            actor->spawn_pos_x                 = entry->pos_x;
+            actor->spawn_pos_y                 = entry->pos_y;
+            actor->state                       = entry->state;
+
+            if (0 < entry->animation_count)
+            {
+                actor->animation = (esz_animation_t*)calloc_counted((size_t)entry->animation_count, sizeof(struct esz_animation));
+                if (! actor->animation)
+                {
+                    plog_error("%s: error allocating memory.", __func__);
+                    return ESZ_ERROR_CRITICAL;
+                }
+
+                memcpy(actor->animation, data + entry->animation_offset, (size_t)entry->animation_count * sizeof(struct esz_animation));
+                actor->animation_count = entry->animation_count;
+            }
+
+            if (entry->is_player && ! player_found)
+            {
+                player_found                      = true;
+                core->camera.is_locked            = true;
+                core->map->active_player_actor_id = index;
+                core->camera.target_actor_id      = index;
+
+                plog_info("  %d %s *", index, name);
+            }
+            else
+            {
+                plog_info("  %d %s", index, name);
+            }
+        }
+
+        update_bounding_box(entity);
+    }
+
+    if (! player_found)
+    {
+        plog_warn("  No player actor found.");
+    }
+
+    return ESZ_OK;
+}
+
+static void premultiply_alpha(unsigned char* pixels, int32_t pixel_count)
+{
+    for (int32_t index = 0; index < pixel_count; index += 1)
+    {
+        unsigned char* pixel = &pixels[index * 4];
+        uint32_t       alpha = pixel[3];
+
+        // Exact division by 255 with rounding.
+        pixel[0] = (unsigned char)(((pixel[0] * alpha) + 127) / 255);
+        pixel[1] = (unsigned char)(((pixel[1] * alpha) + 127) / 255);
+        pixel[2] = (unsigned char)(((pixel[2] * alpha) + 127) / 255);
+    }
+}
+
+// Grows an array geometrically while the number of entries isn't known up front.
+static esz_status reserve_entries(void** entry, int32_t entry_count, int32_t* entry_limit, size_t size)
+{
+    int32_t limit = *entry_limit;
+    void*   grown;
+
+    if (entry_count < limit)
+    {
+        return ESZ_OK;
+    }
+
+    limit = (0 < limit) ? limit * 2 : 256;
+    grown = realloc_counted(*entry, (size_t)*entry_limit * size, (size_t)limit * size);
+    if (! grown)
+    {
+        plog_error("%s: error allocating memory.", __func__);
+        return ESZ_ERROR_CRITICAL;
+    }
+
+    *entry       = grown;
+    *entry_limit = limit;
+
+    return ESZ_OK;
 }
@@ -12,14 +12,17 @@
 
 #include "esz_types.h"
 
-esz_status load_animated_tiles(esz_core_t* core);
-esz_status load_background(esz_window_t* window, esz_core_t* core);
+void       free_map_images(esz_image_t* image, int32_t image_count);
+esz_status gather_map_images(esz_image_t** image, int32_t* image_count, esz_core_t* core);
+esz_status load_background(esz_core_t* core);
 esz_status load_entities(esz_core_t* core);
 esz_status load_map_path(const char* map_file_name, esz_core_t* core);
-esz_status load_sprites(esz_window_t* window, esz_core_t* core);
-esz_status load_tile_properties(esz_core_t* core);
-esz_status load_tileset(esz_window_t* window, esz_core_t*);
+esz_status load_sprites(esz_core_t* core);
+esz_status load_texture_atlas(const char* map_file_name, esz_window_t* window, esz_core_t* core, SDL_atomic_t* cancelled);
+esz_status load_tile_layers(esz_core_t* core);
+esz_status load_tileset(esz_core_t* core);
 esz_status load_texture_from_file(const char* file_name, SDL_Texture** texture, esz_window_t* window);
 esz_status load_texture_from_memory(const unsigned char* buffer, const int length, SDL_Texture** texture, esz_window_t* window);
+esz_status reload_map_image(const char* file_name, int32_t* page, SDL_Rect* rect, esz_window_t* window, esz_core_t* core);
 
 #endif // ESZ_INIT_H
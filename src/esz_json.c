@@ -0,0 +1,948 @@
+// SPDX-License-Identifier: MIT
+/**
+ * @file    esz_json.c
+ * @brief   eszFW Tiled JSON reader
+ */
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && 2 <= _M_IX86_FP)
+    #define HAVE_SSE2
+    #include <emmintrin.h>
+    #ifdef _MSC_VER
+        #include <intrin.h>
+    #endif
+#endif
+
+#include "esz_hash.h"
+#include "esz_json.h"
+#include "esz_types.h"
+
+typedef enum
+{
+    JSON_TEXT = 0,
+    JSON_STRING,
+    JSON_STRING_ESCAPE,
+    JSON_DATA,
+    JSON_CSV,
+    JSON_BASE64,
+    JSON_BASE64_ESCAPE
+
+} json_state;
+
+typedef struct json_reader
+{
+    esz_tiled_json_t* json;
+    uint64_t          container_key[JSON_MAX_DEPTH];
+    int32_t           container_id[JSON_MAX_DEPTH];
+    int32_t           container_tile_data[JSON_MAX_DEPTH];
+    bool              is_object[JSON_MAX_DEPTH];
+    bool              is_compressed[JSON_MAX_DEPTH];
+    uint64_t          key_hash;
+    uint64_t          string_hash;
+    uint64_t          number;
+    size_t            key_start;
+    size_t            skip_start;
+    size_t            string_length;
+    uint32_t          gid;
+    uint32_t          sextets;
+    int32_t           byte_count;
+    int32_t           depth;
+    int32_t           digit_count;
+    int32_t           sextet_count;
+    json_state        state;
+    bool              is_comma_dropped;
+    bool              is_id_read;
+    bool              is_member_skipped;
+    bool              is_value;
+
+} json_reader_t;
+
+static bool add_tile_data(json_reader_t* reader);
+static bool append_char(char c, json_reader_t* reader);
+static void drop_trailing_comma(json_reader_t* reader);
+static bool end_base64(json_reader_t* reader);
+static bool end_string(json_reader_t* reader);
+static void end_value(json_reader_t* reader);
+static int  get_sextet(char c);
+static bool is_layer_object(json_reader_t* reader);
+static bool is_space(char c);
+static bool push_byte(unsigned char byte, esz_tile_data_t* tile_data, json_reader_t* reader);
+static bool push_gid(uint64_t gid, esz_tile_data_t* tile_data);
+static bool read_base64(const char* chunk, size_t length, size_t* pos, json_reader_t* reader);
+static bool read_chunk(const char* chunk, size_t length, json_reader_t* reader);
+static bool read_csv(const char* chunk, size_t length, size_t* pos, json_reader_t* reader);
+static bool read_key(json_reader_t* reader);
+static bool read_text(char c, json_reader_t* reader);
+static bool reserve_gids(int32_t count, esz_tile_data_t* tile_data);
+
+#ifdef HAVE_SSE2
+static int    count_trailing_zeros(uint32_t mask);
+static size_t decode_base64_blocks(const char* text, size_t length, esz_tile_data_t* tile_data);
+static size_t decode_csv_blocks(const char* text, size_t length, esz_tile_data_t* tile_data);
+#endif
+
+void free_tiled_json(esz_tiled_json_t* json)
+{
+    for (int32_t index = 0; index < json->tile_data_count; index += 1)
+    {
+        free(json->tile_data[index].gid);
+    }
+
+    free(json->tile_data);
+    free(json->text);
+
+    memset(json, 0, sizeof(esz_tiled_json_t));
+}
+
+/* Fails on anything the reader doesn't understand, e.g. malformed
+ * JSON or tile data that can't be decoded; the map is then supposed to
+ * be parsed as a whole instead.
+ */
+bool read_tiled_json(const char* file_name, esz_tiled_json_t* json)
+{
+    json_reader_t reader;
+    char*         chunk   = NULL;
+    size_t        length;
+    bool          is_done = false;
+    FILE*         fp;
+
+    memset(json,    0, sizeof(esz_tiled_json_t));
+    memset(&reader, 0, sizeof(json_reader_t));
+
+    fp = fopen(file_name, "rb");
+    if (! fp)
+    {
+        return false;
+    }
+
+    chunk = (char*)malloc(JSON_CHUNK_SIZE);
+    if (! chunk)
+    {
+        goto exit;
+    }
+
+    reader.json = json;
+
+    while (0 < (length = fread(chunk, 1, JSON_CHUNK_SIZE, fp)))
+    {
+        if (! read_chunk(chunk, length, &reader))
+        {
+            goto exit;
+        }
+    }
+
+    if (ferror(fp) || JSON_TEXT != reader.state || 0 != reader.depth)
+    {
+        goto exit;
+    }
+
+    // Terminated for convenience; the terminator isn't part of the text.
+    if (! append_char('\0', &reader))
+    {
+        goto exit;
+    }
+    json->text_length -= 1;
+
+    is_done = true;
+
+exit:
+    free(chunk);
+    fclose(fp);
+
+    if (! is_done)
+    {
+        free_tiled_json(json);
+    }
+
+    return is_done;
+}
+
+static bool add_tile_data(json_reader_t* reader)
+{
+    esz_tiled_json_t* json = reader->json;
+
+    if (json->tile_data_count == json->tile_data_limit)
+    {
+        int32_t          limit     = json->tile_data_limit ? json->tile_data_limit * 2 : 8;
+        esz_tile_data_t* tile_data = (esz_tile_data_t*)realloc(json->tile_data, (size_t)limit * sizeof(esz_tile_data_t));
+
+        if (! tile_data)
+        {
+            return false;
+        }
+
+        json->tile_data       = tile_data;
+        json->tile_data_limit = limit;
+    }
+
+    memset(&json->tile_data[json->tile_data_count], 0, sizeof(esz_tile_data_t));
+    reader->container_tile_data[reader->depth - 1] = json->tile_data_count;
+    json->tile_data_count += 1;
+
+    reader->number       = 0;
+    reader->digit_count  = 0;
+    reader->gid          = 0;
+    reader->byte_count   = 0;
+    reader->sextets      = 0;
+    reader->sextet_count = 0;
+
+    return true;
+}
+
+static bool append_char(char c, json_reader_t* reader)
+{
+    esz_tiled_json_t* json = reader->json;
+
+    if (json->text_length == json->text_limit)
+    {
+        size_t limit = json->text_limit ? json->text_limit * 2 : JSON_CHUNK_SIZE;
+        char*  text  = (char*)realloc(json->text, limit);
+
+        if (! text)
+        {
+            return false;
+        }
+
+        json->text       = text;
+        json->text_limit = limit;
+    }
+
+    json->text[json->text_length]  = c;
+    json->text_length             += 1;
+
+    return true;
+}
+
+// Removes the comma in front of a member that was left out.
+static void drop_trailing_comma(json_reader_t* reader)
+{
+    esz_tiled_json_t* json = reader->json;
+
+    while (0 < json->text_length && is_space(json->text[json->text_length - 1]))
+    {
+        json->text_length -= 1;
+    }
+
+    if (0 < json->text_length && ',' == json->text[json->text_length - 1])
+    {
+        json->text_length -= 1;
+    }
+
+    reader->is_comma_dropped = false;
+}
+
+static bool end_base64(json_reader_t* reader)
+{
+    esz_tile_data_t* tile_data = &reader->json->tile_data[reader->json->tile_data_count - 1];
+
+    switch (reader->sextet_count)
+    {
+        case 0:
+            break;
+        case 2:
+            if (! push_byte((unsigned char)(reader->sextets >> 4), tile_data, reader))
+            {
+                return false;
+            }
+            break;
+        case 3:
+            if (! push_byte((unsigned char)(reader->sextets >> 10), tile_data, reader))
+            {
+                return false;
+            }
+            if (! push_byte((unsigned char)(reader->sextets >> 2), tile_data, reader))
+            {
+                return false;
+            }
+            break;
+        default:
+            return false;
+    }
+
+    reader->state    = JSON_TEXT;
+    reader->is_value = false;
+
+    // Every GID takes four bytes.
+    return 0 == reader->byte_count;
+}
+
+static bool end_string(json_reader_t* reader)
+{
+    if (! reader->is_value)
+    {
+        return true;
+    }
+
+    if (reader->is_member_skipped)
+    {
+        if (H_compression == reader->key_hash && 0 < reader->string_length)
+        {
+            // Compressed data is left to the parser.
+            reader->is_compressed[reader->depth - 1] = true;
+        }
+        else
+        {
+            reader->json->text_length = reader->skip_start;
+            reader->is_comma_dropped  = true;
+        }
+
+        reader->is_member_skipped = false;
+    }
+
+    reader->is_value = false;
+
+    return true;
+}
+
+static void end_value(json_reader_t* reader)
+{
+    if (reader->is_id_read && 0 < reader->digit_count)
+    {
+        reader->container_id[reader->depth - 1] = (int32_t)reader->number;
+    }
+
+    reader->is_id_read        = false;
+    reader->is_member_skipped = false;
+    reader->is_value          = false;
+}
+
+static int get_sextet(char c)
+{
+    if ('A' <= c && 'Z' >= c)
+    {
+        return c - 'A';
+    }
+    else if ('a' <= c && 'z' >= c)
+    {
+        return c - 'a' + 26;
+    }
+    else if ('0' <= c && '9' >= c)
+    {
+        return c - '0' + 52;
+    }
+    else if ('+' == c)
+    {
+        return 62;
+    }
+    else if ('/' == c)
+    {
+        return 63;
+    }
+
+    return -1;
+}
+
+// Whether the innermost container is an entry of a "layers" array.
+static bool is_layer_object(json_reader_t* reader)
+{
+    int32_t depth = reader->depth;
+
+    if (2 > depth)
+    {
+        return false;
+    }
+
+    return reader->is_object[depth - 1] && ! reader->is_object[depth - 2] && H_layers == reader->container_key[depth - 2];
+}
+
+static bool is_space(char c)
+{
+    return ' ' == c || '\n' == c || '\r' == c || '\t' == c;
+}
+
+// Tiled stores GIDs as little-endian unsigned 32-bit integers.
+static bool push_byte(unsigned char byte, esz_tile_data_t* tile_data, json_reader_t* reader)
+{
+    reader->gid        |= (uint32_t)byte << (reader->byte_count * 8);
+    reader->byte_count += 1;
+
+    if (4 == reader->byte_count)
+    {
+        if (! push_gid(reader->gid, tile_data))
+        {
+            return false;
+        }
+
+        reader->gid        = 0;
+        reader->byte_count = 0;
+    }
+
+    return true;
+}
+
+static bool push_gid(uint64_t gid, esz_tile_data_t* tile_data)
+{
+    if (UINT32_MAX < gid || ! reserve_gids(1, tile_data))
+    {
+        return false;
+    }
+
+    tile_data->gid[tile_data->gid_count]  = (int32_t)(uint32_t)gid;
+    tile_data->gid_count                 += 1;
+
+    return true;
+}
+
+static bool read_base64(const char* chunk, size_t length, size_t* pos, json_reader_t* reader)
+{
+    esz_tile_data_t* tile_data = &reader->json->tile_data[reader->json->tile_data_count - 1];
+    size_t           index     = *pos;
+
+    while (index < length)
+    {
+        char c = chunk[index];
+        int  sextet;
+
+        #ifdef HAVE_SSE2
+        if (JSON_BASE64 == reader->state && 0 == reader->sextet_count && 0 == reader->byte_count)
+        {
+            size_t count = decode_base64_blocks(chunk + index, length - index, tile_data);
+
+            if (0 < count)
+            {
+                index += count;
+                continue;
+            }
+        }
+        #endif
+
+        index += 1;
+
+        if (JSON_BASE64_ESCAPE == reader->state)
+        {
+            // The only escape sequence base64 can contain is "\/".
+            if ('/' != c)
+            {
+                return false;
+            }
+
+            sextet        = 63;
+            reader->state = JSON_BASE64;
+        }
+        else if ('\\' == c)
+        {
+            reader->state = JSON_BASE64_ESCAPE;
+            continue;
+        }
+        else if ('"' == c)
+        {
+            if (! end_base64(reader))
+            {
+                return false;
+            }
+            break;
+        }
+        else if ('=' == c)
+        {
+            continue;
+        }
+        else
+        {
+            sextet = get_sextet(c);
+            if (0 > sextet)
+            {
+                return false;
+            }
+        }
+
+        reader->sextets       = (reader->sextets << 6) | (uint32_t)sextet;
+        reader->sextet_count += 1;
+
+        if (4 == reader->sextet_count)
+        {
+            if (! push_byte((unsigned char)(reader->sextets >> 16), tile_data, reader))
+            {
+                return false;
+            }
+            if (! push_byte((unsigned char)(reader->sextets >> 8), tile_data, reader))
+            {
+                return false;
+            }
+            if (! push_byte((unsigned char)reader->sextets, tile_data, reader))
+            {
+                return false;
+            }
+
+            reader->sextets      = 0;
+            reader->sextet_count = 0;
+        }
+    }
+
+    *pos = index;
+
+    return true;
+}
+
+static bool read_chunk(const char* chunk, size_t length, json_reader_t* reader)
+{
+    size_t pos = 0;
+
+    while (pos < length)
+    {
+        bool is_read;
+
+        switch (reader->state)
+        {
+            case JSON_CSV:
+                is_read = read_csv(chunk, length, &pos, reader);
+                break;
+            case JSON_BASE64:
+            case JSON_BASE64_ESCAPE:
+                is_read = read_base64(chunk, length, &pos, reader);
+                break;
+            default:
+                is_read  = read_text(chunk[pos], reader);
+                pos     += 1;
+                break;
+        }
+
+        if (! is_read)
+        {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+static bool read_csv(const char* chunk, size_t length, size_t* pos, json_reader_t* reader)
+{
+    esz_tile_data_t* tile_data = &reader->json->tile_data[reader->json->tile_data_count - 1];
+    size_t           index     = *pos;
+
+    while (index < length)
+    {
+        char c = chunk[index];
+
+        #ifdef HAVE_SSE2
+        if (0 == reader->digit_count)
+        {
+            size_t count = decode_csv_blocks(chunk + index, length - index, tile_data);
+
+            if (0 < count)
+            {
+                index += count;
+                continue;
+            }
+        }
+        #endif
+
+        index += 1;
+
+        if ('0' <= c && '9' >= c)
+        {
+            reader->number       = (reader->number * 10) + (uint64_t)(c - '0');
+            reader->digit_count += 1;
+
+            if (10 < reader->digit_count)
+            {
+                return false;
+            }
+        }
+        else if (',' == c || ']' == c)
+        {
+            if (0 < reader->digit_count)
+            {
+                if (! push_gid(reader->number, tile_data))
+                {
+                    return false;
+                }
+            }
+            else if (',' == c)
+            {
+                return false;
+            }
+
+            reader->number      = 0;
+            reader->digit_count = 0;
+
+            if (']' == c)
+            {
+                reader->state    = JSON_TEXT;
+                reader->is_value = false;
+                break;
+            }
+        }
+        else if (! is_space(c))
+        {
+            return false;
+        }
+    }
+
+    *pos = index;
+
+    return true;
+}
+
+static bool read_key(json_reader_t* reader)
+{
+    reader->key_hash = reader->string_hash;
+    reader->is_value = true;
+
+    if (! is_layer_object(reader))
+    {
+        return append_char(':', reader);
+    }
+
+    switch (reader->key_hash)
+    {
+        case H_data:
+            if (! reader->is_compressed[reader->depth - 1])
+            {
+                reader->state = JSON_DATA;
+            }
+            break;
+        case H_compression:
+        case H_encoding:
+            // The tile data is decoded already; an empty compression is
+            // dropped too.
+            reader->is_member_skipped = true;
+            reader->skip_start        = reader->key_start;
+            break;
+        case H_id:
+            reader->is_id_read  = true;
+            reader->number      = 0;
+            reader->digit_count = 0;
+            break;
+        default:
+            break;
+    }
+
+    return append_char(':', reader);
+}
+
+static bool read_text(char c, json_reader_t* reader)
+{
+    switch (reader->state)
+    {
+        case JSON_STRING:
+            if ('\\' == c)
+            {
+                reader->state = JSON_STRING_ESCAPE;
+            }
+            else if ('"' == c)
+            {
+                reader->state = JSON_TEXT;
+                return append_char(c, reader) && end_string(reader);
+            }
+            else
+            {
+                reader->string_hash    = ((reader->string_hash << 5) + reader->string_hash) + (unsigned char)c;
+                reader->string_length += 1;
+            }
+            return append_char(c, reader);
+        case JSON_STRING_ESCAPE:
+            reader->state          = JSON_STRING;
+            reader->string_length += 1;
+            return append_char(c, reader);
+        case JSON_DATA:
+            if (is_space(c))
+            {
+                return append_char(c, reader);
+            }
+            else if ('[' == c || '"' == c)
+            {
+                reader->state = ('[' == c) ? JSON_CSV : JSON_BASE64;
+                return add_tile_data(reader) && append_char('[', reader) && append_char(']', reader);
+            }
+
+            // Anything else, e.g. null, is kept as it is.
+            reader->state = JSON_TEXT;
+            break;
+        default:
+            break;
+    }
+
+    if (is_space(c))
+    {
+        return append_char(c, reader);
+    }
+
+    switch (c)
+    {
+        case '"':
+            reader->state         = JSON_STRING;
+            reader->key_start     = reader->json->text_length;
+            reader->string_hash   = 5381;
+            reader->string_length = 0;
+            break;
+        case ':':
+            return read_key(reader);
+        case ',':
+            end_value(reader);
+            if (reader->is_comma_dropped)
+            {
+                reader->is_comma_dropped = false;
+                return true;
+            }
+            break;
+        case '{':
+        case '[':
+            if (JSON_MAX_DEPTH == reader->depth)
+            {
+                return false;
+            }
+
+            reader->container_key[reader->depth]       = reader->is_value ? reader->key_hash : 0;
+            reader->container_id[reader->depth]        = 0;
+            reader->container_tile_data[reader->depth] = -1;
+            reader->is_object[reader->depth]           = ('{' == c);
+            reader->is_compressed[reader->depth]       = false;
+            reader->depth                             += 1;
+
+            end_value(reader);
+            break;
+        case '}':
+        case ']':
+            if (0 == reader->depth)
+            {
+                return false;
+            }
+
+            end_value(reader);
+            if (reader->is_comma_dropped)
+            {
+                drop_trailing_comma(reader);
+            }
+
+            reader->depth -= 1;
+
+            if ('}' == c && 0 <= reader->container_tile_data[reader->depth])
+            {
+                reader->json->tile_data[reader->container_tile_data[reader->depth]].layer_id = reader->container_id[reader->depth];
+            }
+            break;
+        default:
+            // Literals: numbers, true, false and null.
+            reader->is_member_skipped = false;
+
+            if (reader->is_id_read)
+            {
+                if ('0' <= c && '9' >= c && 9 > reader->digit_count)
+                {
+                    reader->number       = (reader->number * 10) + (uint64_t)(c - '0');
+                    reader->digit_count += 1;
+                }
+                else
+                {
+                    reader->is_id_read = false;
+                }
+            }
+            break;
+    }
+
+    return append_char(c, reader);
+}
+
+static bool reserve_gids(int32_t count, esz_tile_data_t* tile_data)
+{
+    int32_t  limit = tile_data->gid_limit ? tile_data->gid_limit : 4096;
+    int32_t* gid;
+
+    if (tile_data->gid_count + count <= tile_data->gid_limit)
+    {
+        return true;
+    }
+
+    while (tile_data->gid_count + count > limit)
+    {
+        if (INT32_MAX / 2 < limit)
+        {
+            return false;
+        }
+        limit *= 2;
+    }
+
+    gid = (int32_t*)realloc(tile_data->gid, (size_t)limit * sizeof(int32_t));
+    if (! gid)
+    {
+        return false;
+    }
+
+    tile_data->gid       = gid;
+    tile_data->gid_limit = limit;
+
+    return true;
+}
+
+#ifdef HAVE_SSE2
+static int count_trailing_zeros(uint32_t mask)
+{
+    #ifdef _MSC_VER
+    unsigned long index;
+
+    _BitScanForward(&index, mask);
+    return (int)index;
+
+    #else
+    return __builtin_ctz(mask);
+
+    #endif
+}
+
+/* Translates 16 characters into 12 bytes, i.e. three GIDs, at a time.
+ * Stops at the first block that holds anything but base64 digits, such
+ * as padding or the closing quote, which is left to the scalar path.
+ */
+static size_t decode_base64_blocks(const char* text, size_t length, esz_tile_data_t* tile_data)
+{
+    const __m128i low_bits = _mm_set1_epi32(0x3f);
+    size_t        pos      = 0;
+
+    while (pos + 16 <= length)
+    {
+        __m128i       block = _mm_loadu_si128((const __m128i*)(text + pos));
+        __m128i       upper = _mm_and_si128(_mm_cmpgt_epi8(block, _mm_set1_epi8('A' - 1)), _mm_cmplt_epi8(block, _mm_set1_epi8('Z' + 1)));
+        __m128i       lower = _mm_and_si128(_mm_cmpgt_epi8(block, _mm_set1_epi8('a' - 1)), _mm_cmplt_epi8(block, _mm_set1_epi8('z' + 1)));
+        __m128i       digit = _mm_and_si128(_mm_cmpgt_epi8(block, _mm_set1_epi8('0' - 1)), _mm_cmplt_epi8(block, _mm_set1_epi8('9' + 1)));
+        __m128i       plus  = _mm_cmpeq_epi8(block, _mm_set1_epi8('+'));
+        __m128i       slash = _mm_cmpeq_epi8(block, _mm_set1_epi8('/'));
+        __m128i       offset;
+        __m128i       sextets;
+        __m128i       words;
+        uint32_t      word[4];
+        unsigned char byte[12];
+
+        if (0xffff != _mm_movemask_epi8(_mm_or_si128(_mm_or_si128(upper, lower), _mm_or_si128(digit, _mm_or_si128(plus, slash)))))
+        {
+            break;
+        }
+
+        if (! reserve_gids(3, tile_data))
+        {
+            break;
+        }
+
+        offset = _mm_or_si128(
+            _mm_or_si128(_mm_and_si128(upper, _mm_set1_epi8(-'A')), _mm_and_si128(lower, _mm_set1_epi8(26 - 'a'))),
+            _mm_or_si128(_mm_and_si128(digit, _mm_set1_epi8(52 - '0')),
+                _mm_or_si128(_mm_and_si128(plus, _mm_set1_epi8(62 - '+')), _mm_and_si128(slash, _mm_set1_epi8(63 - '/')))));
+
+        sextets = _mm_add_epi8(block, offset);
+
+        // Each 32-bit lane holds four sextets, first one lowest; merge
+        // them into 24 bits with the first sextet on top.
+        words = _mm_or_si128(
+            _mm_or_si128(
+                _mm_slli_epi32(_mm_and_si128(sextets, low_bits), 18),
+                _mm_slli_epi32(_mm_and_si128(_mm_srli_epi32(sextets, 8), low_bits), 12)),
+            _mm_or_si128(
+                _mm_slli_epi32(_mm_and_si128(_mm_srli_epi32(sextets, 16), low_bits), 6),
+                _mm_srli_epi32(sextets, 24)));
+
+        _mm_storeu_si128((__m128i*)word, words);
+
+        for (int index = 0; index < 4; index += 1)
+        {
+            byte[(index * 3)]     = (unsigned char)(word[index] >> 16);
+            byte[(index * 3) + 1] = (unsigned char)(word[index] >> 8);
+            byte[(index * 3) + 2] = (unsigned char)word[index];
+        }
+
+        for (int index = 0; index < 12; index += 4)
+        {
+            uint32_t gid = (uint32_t)byte[index] | ((uint32_t)byte[index + 1] << 8) | ((uint32_t)byte[index + 2] << 16) | ((uint32_t)byte[index + 3] << 24);
+
+            tile_data->gid[tile_data->gid_count]  = (int32_t)gid;
+            tile_data->gid_count                 += 1;
+        }
+
+        pos += 16;
+    }
+
+    return pos;
+}
+
+/* Decodes 16 bytes at a time for as long as a block holds nothing but
+ * digits, commas and spaces, and always stops right after a comma.
+ * Runs of empty tiles, by far the most common case, are matched as a
+ * whole; other numbers are located by the comma mask.  Anything else
+ * is left to the scalar path.
+ */
+static size_t decode_csv_blocks(const char* text, size_t length, esz_tile_data_t* tile_data)
+{
+    const __m128i empty        = _mm_loadu_si128((const __m128i*)"0,0,0,0,0,0,0,0,");
+    const __m128i spaced_empty = _mm_loadu_si128((const __m128i*)" 0, 0, 0, 0, 0, ");
+    size_t        pos          = 0;
+
+    while (pos + 16 <= length)
+    {
+        __m128i  block = _mm_loadu_si128((const __m128i*)(text + pos));
+        uint32_t comma;
+        uint32_t valid;
+        int      start = 0;
+
+        if (! reserve_gids(8, tile_data))
+        {
+            break;
+        }
+
+        if (0xffff == _mm_movemask_epi8(_mm_cmpeq_epi8(block, empty)))
+        {
+            memset(tile_data->gid + tile_data->gid_count, 0, 8 * sizeof(int32_t));
+            tile_data->gid_count += 8;
+            pos                  += 16;
+            continue;
+        }
+
+        // Only the first 15 bytes, i.e. five tiles, of the spaced form.
+        if (0x7fff == (0x7fff & _mm_movemask_epi8(_mm_cmpeq_epi8(block, spaced_empty))))
+        {
+            memset(tile_data->gid + tile_data->gid_count, 0, 5 * sizeof(int32_t));
+            tile_data->gid_count += 5;
+            pos                  += 15;
+            continue;
+        }
+
+        comma = (uint32_t)_mm_movemask_epi8(_mm_cmpeq_epi8(block, _mm_set1_epi8(',')));
+        valid = comma
+            | (uint32_t)_mm_movemask_epi8(_mm_cmpeq_epi8(block, _mm_set1_epi8(' ')))
+            | (uint32_t)_mm_movemask_epi8(_mm_and_si128(_mm_cmpgt_epi8(block, _mm_set1_epi8('0' - 1)), _mm_cmplt_epi8(block, _mm_set1_epi8('9' + 1))));
+
+        if (0xffff != valid || 0 == comma)
+        {
+            break;
+        }
+
+        while (comma)
+        {
+            int      end         = count_trailing_zeros(comma);
+            uint64_t gid         = 0;
+            int      digit_count = 0;
+
+            for (int index = start; index < end; index += 1)
+            {
+                char c = text[pos + (size_t)index];
+
+                if (' ' != c)
+                {
+                    gid          = (gid * 10) + (uint64_t)(c - '0');
+                    digit_count += 1;
+                }
+            }
+
+            // Empty or oversized; the scalar path rejects it.
+            if (0 == digit_count || 10 < digit_count || UINT32_MAX < gid)
+            {
+                return pos + (size_t)start;
+            }
+
+            tile_data->gid[tile_data->gid_count]  = (int32_t)(uint32_t)gid;
+            tile_data->gid_count                 += 1;
+
+            start  = end + 1;
+            comma &= comma - 1;
+        }
+
+        pos += (size_t)start;
+    }
+
+    return pos;
+}
+#endif
@@ -0,0 +1,26 @@
+// SPDX-License-Identifier: MIT
+/**
+ * @file    esz_json.h
+ * @brief   eszFW Tiled JSON reader
+ * @details Reads a Tiled JSON map in chunks and decodes the tile data
+ *          of its layers on the fly, CSV arrays and uncompressed base64
+ *          strings alike.  The rest of the document is kept without the
+ *          tile data and is left to the JSON parser, so neither the
+ *          whole file nor the parser's scalar loops are involved in
+ *          reading large layers.
+ */
+
+#ifndef ESZ_JSON_H
+#define ESZ_JSON_H
+
+#include <stdbool.h>
+
+#include "esz_types.h"
+
+#define JSON_CHUNK_SIZE 65536
+#define JSON_MAX_DEPTH  64
+
+void free_tiled_json(esz_tiled_json_t* json);
+bool read_tiled_json(const char* file_name, esz_tiled_json_t* json);
+
+#endif // ESZ_JSON_H
@@ -0,0 +1,198 @@
+// SPDX-License-Identifier: MIT
+/**
+ * @file    esz_latency.c
+ * @brief   eszFW input latency instrumentation
+ */
+
+#include <picolog.h>
+#include <stdint.h>
+#include <SDL.h>
+
+#include "esz_latency.h"
+#include "esz_types.h"
+#include "esz_utils.h"
+
+esz_input_latency_stats_t get_input_latency_stats(const esz_input_latency_t* latency)
+{
+    esz_input_latency_stats_t stats = { 0 };
+    double                    sorted_sample[SDL_arraysize(latency->sample)];
+
+    stats.last_input_frame = latency->last_input_frame;
+    stats.sample_count     = latency->sample_count;
+
+    if (0 == latency->sample_count)
+    {
+        return stats;
+    }
+
+    SDL_memcpy(sorted_sample, latency->sample, (size_t)latency->sample_count * sizeof(double));
+    sort_samples(sorted_sample, latency->sample_count);
+
+    stats.p50 = get_percentile(sorted_sample, latency->sample_count, 50);
+    stats.p90 = get_percentile(sorted_sample, latency->sample_count, 90);
+    stats.p99 = get_percentile(sorted_sample, latency->sample_count, 99);
+    stats.max = sorted_sample[latency->sample_count - 1];
+
+    return stats;
+}
+
+/* SDL stamps events in milliseconds when they are queued, which can be
+ * well before they are polled.  The time spent in the queue is moved
+ * over to the performance counter, which the present is measured with.
+ */
+void record_input(const SDL_Event* event, esz_core_t* core)
+{
+    esz_input_latency_t* latency = &core->input_latency;
+    uint64_t             now     = SDL_GetPerformanceCounter();
+    uint32_t             ticks   = SDL_GetTicks();
+    uint32_t             queued  = 0;
+
+    switch (event->type)
+    {
+        case SDL_FINGERDOWN:
+        case SDL_FINGERMOTION:
+        case SDL_FINGERUP:
+        case SDL_KEYUP:
+        case SDL_MULTIGESTURE:
+            break;
+        case SDL_KEYDOWN:
+            if (event->key.repeat)
+            {
+                return;
+            }
+            break;
+        default:
+            return;
+    }
+
+    // Inputs beyond the limit share the latency of the ones before.
+    if ((int32_t)SDL_arraysize(latency->pending_input) == latency->pending_count)
+    {
+        return;
+    }
+
+    if (ticks > event->common.timestamp)
+    {
+        queued = ticks - event->common.timestamp;
+    }
+
+    latency->pending_frame[latency->pending_count]  = latency->frame_count;
+    latency->pending_input[latency->pending_count]  = now - ((uint64_t)queued * SDL_GetPerformanceFrequency() / 1000);
+    latency->pending_count                         += 1;
+}
+
+/* Called right after SDL_RenderPresent().  Inputs that haven't shown an
+ * effect yet are kept for a few frames, as the application may react
+ * to them later than the callback does.
+ */
+void record_present(esz_core_t* core)
+{
+    esz_input_latency_t* latency    = &core->input_latency;
+    uint64_t             now        = SDL_GetPerformanceCounter();
+    double               frequency  = (double)SDL_GetPerformanceFrequency();
+    int32_t              kept_count = 0;
+
+    latency->frame_count += 1;
+
+    for (int32_t index = 0; index < latency->effective_count; index += 1)
+    {
+        uint64_t input = latency->pending_input[index];
+
+        latency->sample[latency->next_sample] = (now > input) ? (double)(now - input) * 1000.0 / frequency : 0.0;
+        latency->next_sample                  = (latency->next_sample + 1) % (int32_t)SDL_arraysize(latency->sample);
+
+        if ((int32_t)SDL_arraysize(latency->sample) > latency->sample_count)
+        {
+            latency->sample_count += 1;
+        }
+    }
+
+    if (0 < latency->effective_count)
+    {
+        latency->last_input_frame = latency->frame_count;
+    }
+
+    for (int32_t index = latency->effective_count; index < latency->pending_count; index += 1)
+    {
+        if (LATENCY_PENDING_FRAMES > latency->frame_count - latency->pending_frame[index])
+        {
+            latency->pending_frame[kept_count]  = latency->pending_frame[index];
+            latency->pending_input[kept_count]  = latency->pending_input[index];
+            kept_count                         += 1;
+        }
+    }
+
+    latency->effective_count = 0;
+    latency->pending_count   = kept_count;
+}
+
+// Called by the update whenever the player was changed since the previous one.
+void record_state_change(esz_core_t* core)
+{
+    core->input_latency.effective_count = core->input_latency.pending_count;
+}
+
+/* Three bars in the upper-left corner: median, 90th and 99th
+ * percentile.  The ticks below mark the length of one frame at the
+ * display's refresh rate.
+ */
+esz_status render_latency_overlay(esz_window_t* window, esz_core_t* core)
+{
+    esz_input_latency_stats_t stats = get_input_latency_stats(&core->input_latency);
+    double                    value[3];
+    SDL_Rect                  dst;
+    uint8_t                   red, green, blue, alpha;
+    int32_t                   max_width   = window->logical_width - 8;
+    const uint8_t             color[3][3] = {
+        { 0x3e, 0xa9, 0x20 },
+        { 0xe0, 0xb0, 0x20 },
+        { 0xa9, 0x20, 0x3e }
+    };
+
+    value[0] = stats.p50;
+    value[1] = stats.p90;
+    value[2] = stats.p99;
+
+    if (0 > SDL_GetRenderDrawColor(window->renderer, &red, &green, &blue, &alpha))
+    {
+        plog_error("%s: %s.", __func__, SDL_GetError());
+        return ESZ_ERROR_CRITICAL;
+    }
+
+    for (int32_t index = 0; index < 3; index += 1)
+    {
+        dst.x = 4;
+        dst.y = 4 + (index * 4);
+        dst.w = SDL_min((int32_t)(value[index] * LATENCY_OVERLAY_SCALE), max_width);
+        dst.h = 3;
+
+        if (0 >= dst.w)
+        {
+            continue;
+        }
+
+        SDL_SetRenderDrawColor(window->renderer, color[index][0], color[index][1], color[index][2], SDL_ALPHA_OPAQUE);
+
+        if (0 > SDL_RenderFillRect(window->renderer, &dst))
+        {
+            plog_error("%s: %s.", __func__, SDL_GetError());
+            return ESZ_ERROR_CRITICAL;
+        }
+    }
+
+    SDL_SetRenderDrawColor(window->renderer, 0xff, 0xff, 0xff, SDL_ALPHA_OPAQUE);
+
+    for (int32_t frame = 1; frame * 1000 * LATENCY_OVERLAY_SCALE / window->refresh_rate <= max_width; frame += 1)
+    {
+        dst.x = 4 + (frame * 1000 * LATENCY_OVERLAY_SCALE / window->refresh_rate) - 1;
+        dst.y = 16;
+        dst.w = 1;
+        dst.h = 2;
+
+        SDL_RenderFillRect(window->renderer, &dst);
+    }
+
+    SDL_SetRenderDrawColor(window->renderer, red, green, blue, alpha);
+
+    return ESZ_OK;
+}
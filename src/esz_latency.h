@@ -0,0 +1,30 @@
+// SPDX-License-Identifier: MIT
+/**
+ * @file    esz_latency.h
+ * @brief   eszFW input latency instrumentation
+ * @details Every input event is timestamped when SDL queues it and kept
+ *          pending until the action, state or velocity of the player
+ *          is changed outside of the physics update, i.e. by an input
+ *          callback or the application.  The time until the next frame
+ *          has been presented is recorded as one sample, and the frame
+ *          is tagged as the one that presented the input.  Inputs
+ *          without such an effect are dropped after a few frames.
+ */
+
+#ifndef ESZ_LATENCY_H
+#define ESZ_LATENCY_H
+
+#include <SDL.h>
+
+#include "esz_types.h"
+
+#define LATENCY_OVERLAY_SCALE  2 // Pixels per millisecond.
+#define LATENCY_PENDING_FRAMES 8 // Frames an input may take to show an effect.
+
+esz_input_latency_stats_t get_input_latency_stats(const esz_input_latency_t* latency);
+void                      record_input(const SDL_Event* event, esz_core_t* core);
+void                      record_present(esz_core_t* core);
+void                      record_state_change(esz_core_t* core);
+esz_status                render_latency_overlay(esz_window_t* window, esz_core_t* core);
+
+#endif // ESZ_LATENCY_H
@@ -0,0 +1,421 @@
+// SPDX-License-Identifier: MIT
+/**
+ * @file    esz_mapfile.c
+ * @brief   eszFW binary map file
+ */
+
+#include <picolog.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "esz_macros.h"
+
+DISABLE_WARNING_PUSH
+DISABLE_WARNING_PADDING
+DISABLE_WARNING_SPECTRE_MITIGATION
+DISABLE_WARNING_SYMBOL_NOT_DEFINED
+
+#include <SDL.h>
+
+DISABLE_WARNING_POP
+
+#include "esz_hash.h"
+#include "esz_mapfile.h"
+#include "esz_types.h"
+#include "esz_utils.h"
+
+#ifndef USE_LIBTMX
+static bool is_valid_extent(const void* target, int64_t count, size_t element_size, const unsigned char* data, size_t size);
+static bool is_valid_layer(const cute_tiled_layer_t* layer, uint64_t* budget, const unsigned char* data, size_t size);
+static bool is_valid_object(const cute_tiled_object_t* object, uint64_t* budget, const unsigned char* data, size_t size);
+static bool is_valid_offset(uint64_t offset, int64_t count, size_t element_size, size_t size);
+static bool is_valid_property(const cute_tiled_property_t* property, int count, const unsigned char* data, size_t size);
+static bool is_valid_string(cute_tiled_string_t string, const unsigned char* data, size_t size);
+static bool is_valid_tile_data(const cute_tiled_layer_t* layer, const cute_tiled_map_t* map);
+static bool is_valid_tileset(const cute_tiled_tileset_t* tileset, uint64_t* budget, const unsigned char* data, size_t size);
+#endif
+
+bool is_map_file(const char* file_name)
+{
+    size_t length           = strlen(file_name);
+    size_t extension_length = strlen(MAP_FILE_EXTENSION);
+
+    if (length <= extension_length)
+    {
+        return false;
+    }
+
+    return 0 == strcmp(file_name + length - extension_length, MAP_FILE_EXTENSION);
+}
+
+esz_status load_map_file(const char* file_name, esz_core_t* core)
+{
+    #ifdef USE_LIBTMX
+    (void)core;
+    plog_error("%s: %s: binary maps require cute_tiled.", __func__, file_name);
+    return ESZ_WARNING;
+
+    #else // (cute_tiled.h)
+    const size_t           layout[] = MAP_FILE_LAYOUT;
+    esz_map_file_header_t* header;
+    esz_entity_entry_t*    entity   = NULL;
+    cute_tiled_map_t*      map;
+    unsigned char*         data;
+    uint64_t*              relocation;
+    uint64_t               budget;
+    size_t                 size     = 0;
+
+    data = (unsigned char*)map_file(file_name, &size);
+    if (! data)
+    {
+        return ESZ_WARNING;
+    }
+
+    header = (esz_map_file_header_t*)data;
+
+    if (sizeof(esz_map_file_header_t) > size                                 ||
+        0 != memcmp(header->magic, MAP_FILE_MAGIC, 8)                        ||
+        MAP_FILE_VERSION                            != header->version       ||
+        sizeof(void*)                               != header->pointer_size  ||
+        generate_data_hash(layout, sizeof(layout))  != header->layout        ||
+        (uint64_t)size                              != header->file_size)
+    {
+        plog_error("%s: %s is not compatible with this build.", __func__, file_name);
+        unmap_file(data, size);
+        return ESZ_WARNING;
+    }
+
+    if (INT64_MAX < header->relocation_count                                                                  ||
+        ! is_valid_offset(header->map_offset, 1, sizeof(cute_tiled_map_t), size)                              ||
+        ! is_valid_offset(header->tile_flag_offset, header->tile_flag_count, sizeof(uint32_t), size)          ||
+        ! is_valid_offset(header->entity_offset, header->entity_count, sizeof(esz_entity_entry_t), size)      ||
+        ! is_valid_offset(header->relocation_offset, (int64_t)header->relocation_count, sizeof(uint64_t), size))
+    {
+        plog_error("%s: %s is corrupt.", __func__, file_name);
+        unmap_file(data, size);
+        return ESZ_WARNING;
+    }
+
+    /* Pointers are stored as offsets from the start of the file.  The
+     * mapping is private, so fixing them up only touches the pages that
+     * actually contain pointers.
+     */
+    relocation = (uint64_t*)(data + header->relocation_offset);
+
+    for (uint64_t index = 0; index < header->relocation_count; index += 1)
+    {
+        uintptr_t pointer;
+
+        if (relocation[index] > size - sizeof(uintptr_t))
+        {
+            plog_error("%s: %s is corrupt.", __func__, file_name);
+            unmap_file(data, size);
+            return ESZ_WARNING;
+        }
+
+        memcpy(&pointer, data + relocation[index], sizeof(uintptr_t));
+        if (pointer >= size)
+        {
+            plog_error("%s: %s is corrupt.", __func__, file_name);
+            unmap_file(data, size);
+            return ESZ_WARNING;
+        }
+
+        if (pointer)
+        {
+            pointer += (uintptr_t)data;
+            memcpy(data + relocation[index], &pointer, sizeof(uintptr_t));
+        }
+    }
+
+    /* A relocated pointer is only known to point into the file.  Walk
+     * the map and check that every structure, array and string it
+     * references fits into the file as well.  Every list node is
+     * reached through a relocated pointer, so the relocation count
+     * bounds the walk even if a list is cyclic.
+     */
+    map    = (cute_tiled_map_t*)(data + header->map_offset);
+    budget = header->relocation_count;
+
+    if (! is_valid_string(map->orientation, data, size)                          ||
+        ! is_valid_string(map->renderorder, data, size)                          ||
+        ! is_valid_string(map->tiledversion, data, size)                         ||
+        ! is_valid_string(map->type, data, size)                                 ||
+        ! is_valid_property(map->properties, map->property_count, data, size)    ||
+        ! is_valid_layer(map->layers, &budget, data, size)                       ||
+        ! is_valid_tileset(map->tilesets, &budget, data, size)                   ||
+        ! is_valid_tile_data(map->layers, map))
+    {
+        plog_error("%s: %s is corrupt.", __func__, file_name);
+        unmap_file(data, size);
+        return ESZ_WARNING;
+    }
+
+    if (0 < header->entity_count)
+    {
+        entity = (esz_entity_entry_t*)(data + header->entity_offset);
+    }
+
+    for (int32_t index = 0; index < header->entity_count; index += 1)
+    {
+        uint64_t name_offset = entity[index].name_offset;
+
+        if (! is_valid_offset(entity[index].animation_offset, entity[index].animation_count, sizeof(esz_animation_t), size) ||
+            ! is_valid_offset(name_offset, name_offset ? 1 : 0, 1, size)                                                     ||
+            (name_offset && ! memchr(data + name_offset, 0, size - name_offset)))
+        {
+            plog_error("%s: %s is corrupt.", __func__, file_name);
+            unmap_file(data, size);
+            return ESZ_WARNING;
+        }
+    }
+
+    core->map->binary_map      = data;
+    core->map->binary_map_size = size;
+    core->map->handle          = map;
+
+    if (0 < header->tile_flag_count)
+    {
+        core->map->tile_flag       = (uint32_t*)(data + header->tile_flag_offset);
+        core->map->tile_flag_count = header->tile_flag_count;
+    }
+
+    if (0 < header->entity_count)
+    {
+        core->map->binary_entity       = entity;
+        core->map->binary_entity_count = header->entity_count;
+    }
+
+    plog_info("Map binary map file %s (%zu bytes, %llu relocations).", file_name, size, (unsigned long long)header->relocation_count);
+    return ESZ_OK;
+
+    #endif
+}
+
+void unload_map_file(esz_core_t* core)
+{
+    if (core->map->binary_map)
+    {
+        unmap_file(core->map->binary_map, core->map->binary_map_size);
+    }
+
+    core->map->binary_map      = NULL;
+    core->map->binary_map_size = 0;
+    core->map->handle          = NULL;
+    core->map->tile_flag       = NULL;
+    core->map->tile_flag_count = 0;
+
+    core->map->binary_entity       = NULL;
+    core->map->binary_entity_count = 0;
+}
+
+#ifndef USE_LIBTMX
+static bool is_valid_extent(const void* target, int64_t count, size_t element_size, const unsigned char* data, size_t size)
+{
+    if (! target)
+    {
+        return true;
+    }
+
+    if ((uintptr_t)target < (uintptr_t)data)
+    {
+        return false;
+    }
+
+    return is_valid_offset((uint64_t)((uintptr_t)target - (uintptr_t)data), count, element_size, size);
+}
+
+static bool is_valid_layer(const cute_tiled_layer_t* layer, uint64_t* budget, const unsigned char* data, size_t size)
+{
+    while (layer)
+    {
+        if (0 == *budget || ! is_valid_extent(layer, 1, sizeof(cute_tiled_layer_t), data, size))
+        {
+            return false;
+        }
+        *budget -= 1;
+
+        if (! is_valid_extent(layer->data, layer->data_count, sizeof(int), data, size)  ||
+            ! is_valid_string(layer->draworder, data, size)                             ||
+            ! is_valid_string(layer->image, data, size)                                 ||
+            ! is_valid_string(layer->name, data, size)                                  ||
+            ! is_valid_string(layer->type, data, size)                                  ||
+            ! is_valid_property(layer->properties, layer->property_count, data, size)   ||
+            ! is_valid_object(layer->objects, budget, data, size)                       ||
+            ! is_valid_layer(layer->layers, budget, data, size))
+        {
+            return false;
+        }
+
+        layer = layer->next;
+    }
+
+    return true;
+}
+
+static bool is_valid_object(const cute_tiled_object_t* object, uint64_t* budget, const unsigned char* data, size_t size)
+{
+    while (object)
+    {
+        if (0 == *budget || ! is_valid_extent(object, 1, sizeof(cute_tiled_object_t), data, size))
+        {
+            return false;
+        }
+        *budget -= 1;
+
+        if (! is_valid_extent(object->vertices, (int64_t)object->vert_count * 2, sizeof(float), data, size) ||
+            ! is_valid_string(object->name, data, size)                                                     ||
+            ! is_valid_string(object->type, data, size)                                                     ||
+            ! is_valid_property(object->properties, object->property_count, data, size))
+        {
+            return false;
+        }
+
+        object = object->next;
+    }
+
+    return true;
+}
+
+/* Checks that count elements starting at offset lie within the file.
+ * The writer aligns every block, and offset 0 is the header, so it
+ * can only stand for an empty block.
+ */
+static bool is_valid_offset(uint64_t offset, int64_t count, size_t element_size, size_t size)
+{
+    if (0 > count)
+    {
+        return false;
+    }
+
+    if (0 == offset)
+    {
+        return 0 == count;
+    }
+
+    if (offset >= size || 0 != offset % MAP_FILE_ALIGNMENT)
+    {
+        return false;
+    }
+
+    return (uint64_t)count <= (size - offset) / element_size;
+}
+
+static bool is_valid_property(const cute_tiled_property_t* property, int count, const unsigned char* data, size_t size)
+{
+    if (! is_valid_extent(property, count, sizeof(cute_tiled_property_t), data, size))
+    {
+        return false;
+    }
+
+    for (int index = 0; property && index < count; index += 1)
+    {
+        if (! is_valid_string(property[index].name, data, size))
+        {
+            return false;
+        }
+
+        if (CUTE_TILED_PROPERTY_STRING == property[index].type || CUTE_TILED_PROPERTY_FILE == property[index].type)
+        {
+            if (! is_valid_string(property[index].data.string, data, size))
+            {
+                return false;
+            }
+        }
+    }
+
+    return true;
+}
+
+static bool is_valid_string(cute_tiled_string_t string, const unsigned char* data, size_t size)
+{
+    const unsigned char* byte = (const unsigned char*)string.ptr;
+
+    if (! is_valid_extent(byte, 1, 1, data, size))
+    {
+        return false;
+    }
+
+    return ! byte || NULL != memchr(byte, 0, size - (size_t)(byte - data));
+}
+
+/* The tile layers are read as width * height cells of the map, no
+ * matter how many the layer claims to hold.  Only called once the
+ * layers are known to be valid, so the lists are finite.
+ */
+static bool is_valid_tile_data(const cute_tiled_layer_t* layer, const cute_tiled_map_t* map)
+{
+    const int64_t cell_count = (int64_t)map->width * (int64_t)map->height;
+
+    while (layer)
+    {
+        if (layer->type.ptr && H_tilelayer == generate_hash((const unsigned char*)layer->type.ptr))
+        {
+            if (0 >= map->width                   ||
+                0 >= map->height                  ||
+                map->width  != layer->width       ||
+                map->height != layer->height      ||
+                cell_count  != layer->data_count  ||
+                ! layer->data)
+            {
+                return false;
+            }
+        }
+
+        if (! is_valid_tile_data(layer->layers, map))
+        {
+            return false;
+        }
+
+        layer = layer->next;
+    }
+
+    return true;
+}
+
+static bool is_valid_tileset(const cute_tiled_tileset_t* tileset, uint64_t* budget, const unsigned char* data, size_t size)
+{
+    while (tileset)
+    {
+        const cute_tiled_tile_descriptor_t* tile;
+
+        if (0 == *budget || ! is_valid_extent(tileset, 1, sizeof(cute_tiled_tileset_t), data, size))
+        {
+            return false;
+        }
+        *budget -= 1;
+
+        if (! is_valid_string(tileset->image, data, size)                                ||
+            ! is_valid_string(tileset->name, data, size)                                 ||
+            ! is_valid_string(tileset->tiledversion, data, size)                         ||
+            ! is_valid_string(tileset->type, data, size)                                 ||
+            ! is_valid_string(tileset->source, data, size)                               ||
+            ! is_valid_property(tileset->properties, tileset->property_count, data, size))
+        {
+            return false;
+        }
+
+        for (tile = tileset->tiles; tile; tile = tile->next)
+        {
+            if (0 == *budget || ! is_valid_extent(tile, 1, sizeof(cute_tiled_tile_descriptor_t), data, size))
+            {
+                return false;
+            }
+            *budget -= 1;
+
+            if (! is_valid_extent(tile->animation, tile->frame_count, sizeof(cute_tiled_frame_t), data, size) ||
+                ! is_valid_string(tile->image, data, size)                                                    ||
+                ! is_valid_property(tile->properties, tile->property_count, data, size)                       ||
+                ! is_valid_layer(tile->objectgroup, budget, data, size))
+            {
+                return false;
+            }
+        }
+
+        tileset = tileset->next;
+    }
+
+    return true;
+}
+#endif
@@ -0,0 +1,142 @@
+// SPDX-License-Identifier: MIT
+/**
+ * @file    esz_mapfile.h
+ * @brief   eszFW binary map file
+ * @details A precompiled map is a relocatable image of the parsed
+ *          cute_tiled map.  It is mapped into memory and used in place;
+ *          only the pointers listed in the relocation table are fixed
+ *          up.  Binary maps are generated with the eszmap tool.
+ */
+
+#ifndef ESZ_MAPFILE_H
+#define ESZ_MAPFILE_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "esz_types.h"
+
+#define MAP_FILE_ALIGNMENT 8
+#define MAP_FILE_EXTENSION ".eszmap"
+#define MAP_FILE_MAGIC     "ESZBNMAP"
+#define MAP_FILE_VERSION   2
+
+#ifndef USE_LIBTMX
+/* Binary maps are only compatible with builds that share the same
+ * cute_tiled structure layout.  The layout is identified by a hash of
+ * the size of every stored structure and the offset of every field.
+ */
+#define MAP_FILE_LAYOUT {                                             \
+    sizeof(cute_tiled_string_t),                                      \
+    sizeof(struct cute_tiled_map_t),                                  \
+    offsetof(struct cute_tiled_map_t, backgroundcolor),               \
+    offsetof(struct cute_tiled_map_t, height),                        \
+    offsetof(struct cute_tiled_map_t, infinite),                      \
+    offsetof(struct cute_tiled_map_t, layers),                        \
+    offsetof(struct cute_tiled_map_t, nextobjectid),                  \
+    offsetof(struct cute_tiled_map_t, orientation),                   \
+    offsetof(struct cute_tiled_map_t, property_count),                \
+    offsetof(struct cute_tiled_map_t, properties),                    \
+    offsetof(struct cute_tiled_map_t, renderorder),                   \
+    offsetof(struct cute_tiled_map_t, tileheight),                    \
+    offsetof(struct cute_tiled_map_t, tilesets),                      \
+    offsetof(struct cute_tiled_map_t, tiledversion),                  \
+    offsetof(struct cute_tiled_map_t, tilewidth),                     \
+    offsetof(struct cute_tiled_map_t, type),                          \
+    offsetof(struct cute_tiled_map_t, version),                       \
+    offsetof(struct cute_tiled_map_t, width),                         \
+    offsetof(struct cute_tiled_map_t, nextlayerid),                   \
+    sizeof(struct cute_tiled_layer_t),                                \
+    offsetof(struct cute_tiled_layer_t, data_count),                  \
+    offsetof(struct cute_tiled_layer_t, data),                        \
+    offsetof(struct cute_tiled_layer_t, draworder),                   \
+    offsetof(struct cute_tiled_layer_t, height),                      \
+    offsetof(struct cute_tiled_layer_t, image),                       \
+    offsetof(struct cute_tiled_layer_t, layers),                      \
+    offsetof(struct cute_tiled_layer_t, name),                        \
+    offsetof(struct cute_tiled_layer_t, objects),                     \
+    offsetof(struct cute_tiled_layer_t, offsetx),                     \
+    offsetof(struct cute_tiled_layer_t, offsety),                     \
+    offsetof(struct cute_tiled_layer_t, opacity),                     \
+    offsetof(struct cute_tiled_layer_t, property_count),              \
+    offsetof(struct cute_tiled_layer_t, properties),                  \
+    offsetof(struct cute_tiled_layer_t, type),                        \
+    offsetof(struct cute_tiled_layer_t, visible),                     \
+    offsetof(struct cute_tiled_layer_t, width),                       \
+    offsetof(struct cute_tiled_layer_t, x),                           \
+    offsetof(struct cute_tiled_layer_t, y),                           \
+    offsetof(struct cute_tiled_layer_t, id),                          \
+    offsetof(struct cute_tiled_layer_t, next),                        \
+    sizeof(struct cute_tiled_object_t),                               \
+    offsetof(struct cute_tiled_object_t, ellipse),                    \
+    offsetof(struct cute_tiled_object_t, gid),                        \
+    offsetof(struct cute_tiled_object_t, height),                     \
+    offsetof(struct cute_tiled_object_t, id),                         \
+    offsetof(struct cute_tiled_object_t, name),                       \
+    offsetof(struct cute_tiled_object_t, point),                      \
+    offsetof(struct cute_tiled_object_t, vert_count),                 \
+    offsetof(struct cute_tiled_object_t, vertices),                   \
+    offsetof(struct cute_tiled_object_t, vert_type),                  \
+    offsetof(struct cute_tiled_object_t, property_count),             \
+    offsetof(struct cute_tiled_object_t, properties),                 \
+    offsetof(struct cute_tiled_object_t, rotation),                   \
+    offsetof(struct cute_tiled_object_t, type),                       \
+    offsetof(struct cute_tiled_object_t, visible),                    \
+    offsetof(struct cute_tiled_object_t, width),                      \
+    offsetof(struct cute_tiled_object_t, x),                          \
+    offsetof(struct cute_tiled_object_t, y),                          \
+    offsetof(struct cute_tiled_object_t, next),                       \
+    sizeof(struct cute_tiled_property_t),                             \
+    offsetof(struct cute_tiled_property_t, data),                     \
+    offsetof(struct cute_tiled_property_t, type),                     \
+    offsetof(struct cute_tiled_property_t, name),                     \
+    sizeof(struct cute_tiled_tileset_t),                              \
+    offsetof(struct cute_tiled_tileset_t, backgroundcolor),           \
+    offsetof(struct cute_tiled_tileset_t, columns),                   \
+    offsetof(struct cute_tiled_tileset_t, firstgid),                  \
+    offsetof(struct cute_tiled_tileset_t, image),                     \
+    offsetof(struct cute_tiled_tileset_t, imageheight),               \
+    offsetof(struct cute_tiled_tileset_t, imagewidth),                \
+    offsetof(struct cute_tiled_tileset_t, margin),                    \
+    offsetof(struct cute_tiled_tileset_t, name),                      \
+    offsetof(struct cute_tiled_tileset_t, property_count),            \
+    offsetof(struct cute_tiled_tileset_t, properties),                \
+    offsetof(struct cute_tiled_tileset_t, spacing),                   \
+    offsetof(struct cute_tiled_tileset_t, tilecount),                 \
+    offsetof(struct cute_tiled_tileset_t, tiledversion),              \
+    offsetof(struct cute_tiled_tileset_t, tileheight),                \
+    offsetof(struct cute_tiled_tileset_t, tileoffset_x),              \
+    offsetof(struct cute_tiled_tileset_t, tileoffset_y),              \
+    offsetof(struct cute_tiled_tileset_t, tiles),                     \
+    offsetof(struct cute_tiled_tileset_t, tilewidth),                 \
+    offsetof(struct cute_tiled_tileset_t, transparentcolor),          \
+    offsetof(struct cute_tiled_tileset_t, type),                      \
+    offsetof(struct cute_tiled_tileset_t, source),                    \
+    offsetof(struct cute_tiled_tileset_t, next),                      \
+    sizeof(struct cute_tiled_tile_descriptor_t),                      \
+    offsetof(struct cute_tiled_tile_descriptor_t, tile_index),        \
+    offsetof(struct cute_tiled_tile_descriptor_t, frame_count),       \
+    offsetof(struct cute_tiled_tile_descriptor_t, animation),         \
+    offsetof(struct cute_tiled_tile_descriptor_t, image),             \
+    offsetof(struct cute_tiled_tile_descriptor_t, imageheight),       \
+    offsetof(struct cute_tiled_tile_descriptor_t, imagewidth),        \
+    offsetof(struct cute_tiled_tile_descriptor_t, objectgroup),       \
+    offsetof(struct cute_tiled_tile_descriptor_t, property_count),    \
+    offsetof(struct cute_tiled_tile_descriptor_t, properties),        \
+    offsetof(struct cute_tiled_tile_descriptor_t, probability),       \
+    offsetof(struct cute_tiled_tile_descriptor_t, next),              \
+    sizeof(struct cute_tiled_frame_t),                                \
+    offsetof(struct cute_tiled_frame_t, duration),                    \
+    offsetof(struct cute_tiled_frame_t, tileid),                      \
+    sizeof(esz_animation_t),                                          \
+    sizeof(esz_entity_entry_t),                                       \
+    sizeof(esz_map_file_header_t)                                     \
+}
+#endif
+
+bool       is_map_file(const char* file_name);
+esz_status load_map_file(const char* file_name, esz_core_t* core);
+void       unload_map_file(esz_core_t* core);
+
+#endif // ESZ_MAPFILE_H
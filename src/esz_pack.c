@@ -0,0 +1,141 @@
+// SPDX-License-Identifier: MIT
+/**
+ * @file    esz_pack.c
+ * @brief   eszFW asset pack
+ */
+
+#include <picolog.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "esz_macros.h"
+
+DISABLE_WARNING_PUSH
+DISABLE_WARNING_PADDING
+DISABLE_WARNING_SPECTRE_MITIGATION
+DISABLE_WARNING_SYMBOL_NOT_DEFINED
+
+#include <SDL.h>
+
+DISABLE_WARNING_POP
+
+#include "esz_hash.h"
+#include "esz_pack.h"
+#include "esz_types.h"
+#include "esz_utils.h"
+
+bool find_in_asset_pack(const char* file_name, const unsigned char** data, size_t* size, esz_asset_pack_t* pack)
+{
+    char        normalised[ASSET_PATH_MAX] = { 0 };
+    const char* path;
+    uint64_t    hash;
+    uint32_t    lower = 0;
+    uint32_t    upper;
+
+    if (! pack->data || ! file_name)
+    {
+        return false;
+    }
+
+    path  = normalise_asset_path(file_name, normalised, sizeof(normalised));
+    hash  = generate_hash((const unsigned char*)path);
+    upper = pack->entry_count;
+
+    // The index is sorted by hash.
+    while (lower < upper)
+    {
+        uint32_t                middle = lower + ((upper - lower) / 2);
+        esz_asset_pack_entry_t* entry  = &pack->entry[middle];
+
+        if (entry->hash == hash)
+        {
+            // eszpack rejects colliding paths, so there is only one candidate.
+            if (0 != strcmp((const char*)(pack->data + entry->path_offset), path))
+            {
+                return false;
+            }
+
+            *data = pack->data + entry->offset;
+            *size = (size_t)entry->size;
+            return true;
+        }
+        else if (entry->hash < hash)
+        {
+            lower = middle + 1;
+        }
+        else
+        {
+            upper = middle;
+        }
+    }
+
+    return false;
+}
+
+esz_status mount_asset_pack(const char* file_name, esz_asset_pack_t* pack)
+{
+    esz_asset_pack_header_t* header;
+    unsigned char*           data;
+    size_t                   size = 0;
+
+    if (pack->data)
+    {
+        unmount_asset_pack(pack);
+    }
+
+    data = (unsigned char*)map_file(file_name, &size);
+    if (! data)
+    {
+        return ESZ_WARNING;
+    }
+
+    header = (esz_asset_pack_header_t*)data;
+
+    if (sizeof(esz_asset_pack_header_t) > size              ||
+        0 != memcmp(header->magic, ASSET_PACK_MAGIC, 8)     ||
+        ASSET_PACK_VERSION != header->version               ||
+        header->entry_count > (size - sizeof(esz_asset_pack_header_t)) / sizeof(esz_asset_pack_entry_t))
+    {
+        plog_error("%s: %s is not a valid asset pack.", __func__, file_name);
+        unmap_file(data, size);
+        return ESZ_WARNING;
+    }
+
+    pack->data        = data;
+    pack->size        = size;
+    pack->entry       = (esz_asset_pack_entry_t*)(data + sizeof(esz_asset_pack_header_t));
+    pack->entry_count = header->entry_count;
+
+    for (uint32_t index = 0; index < pack->entry_count; index += 1)
+    {
+        esz_asset_pack_entry_t* entry = &pack->entry[index];
+
+        if (entry->offset > size                                                      ||
+            entry->size > size - entry->offset                                        ||
+            entry->path_offset >= size                                                ||
+            ! memchr(data + entry->path_offset, 0, size - entry->path_offset))
+        {
+            plog_error("%s: %s is corrupt.", __func__, file_name);
+            unmount_asset_pack(pack);
+            return ESZ_WARNING;
+        }
+    }
+
+    plog_info("Mount asset pack %s with %u asset(s).", file_name, pack->entry_count);
+    return ESZ_OK;
+}
+
+void unmount_asset_pack(esz_asset_pack_t* pack)
+{
+    if (pack->data)
+    {
+        unmap_file(pack->data, pack->size);
+    }
+
+    pack->data        = NULL;
+    pack->entry       = NULL;
+    pack->size        = 0;
+    pack->entry_count = 0;
+}
@@ -0,0 +1,27 @@
+// SPDX-License-Identifier: MIT
+/**
+ * @file    esz_pack.h
+ * @brief   eszFW asset pack
+ * @details A single file that contains the game's assets, indexed by
+ *          the hash of their normalised path.  The path itself is
+ *          stored as well, so a lookup never returns the wrong asset.
+ *          Asset packs are built with the eszpack tool.
+ */
+
+#ifndef ESZ_PACK_H
+#define ESZ_PACK_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "esz_types.h"
+
+#define ASSET_PACK_MAGIC   "ESZAPACK"
+#define ASSET_PACK_VERSION 2
+
+bool       find_in_asset_pack(const char* file_name, const unsigned char** data, size_t* size, esz_asset_pack_t* pack);
+esz_status mount_asset_pack(const char* file_name, esz_asset_pack_t* pack);
+void       unmount_asset_pack(esz_asset_pack_t* pack);
+
+#endif // ESZ_PACK_H
@@ -0,0 +1,82 @@
+// SPDX-License-Identifier: MIT
+/**
+ * @file    esz_profile.c
+ * @brief   eszFW frame profiler
+ */
+
+#include <stdint.h>
+#include <SDL.h>
+
+#include "esz_profile.h"
+#include "esz_trace.h"
+#include "esz_types.h"
+#include "esz_utils.h"
+
+static const char* const frame_phase_name[ESZ_FRAME_PHASE_MAX] = {
+    "poll_events", "move_camera", "update_entities", "render_background",
+    "render_map_bg", "render_map_fg", "render_actors_bg", "render_actors_mg",
+    "render_actors_fg", "draw_scene"
+};
+
+void begin_frame_phase(const esz_frame_phase phase, esz_core_t* core)
+{
+    core->profiler.phase_start[phase] = SDL_GetPerformanceCounter();
+}
+
+// Phases that run more than once per frame are summed up.
+void end_frame_phase(const esz_frame_phase phase, esz_core_t* core)
+{
+    esz_frame_profiler_t* profiler = &core->profiler;
+    uint64_t              now      = SDL_GetPerformanceCounter();
+
+    profiler->phase_time[phase] += (double)(now - profiler->phase_start[phase]) * 1000.0 / (double)SDL_GetPerformanceFrequency();
+
+    TRACE_SCOPE("frame", frame_phase_name[phase], profiler->phase_start[phase], now);
+}
+
+// Called once the frame has been presented.
+void end_profiled_frame(esz_core_t* core)
+{
+    esz_frame_profiler_t* profiler = &core->profiler;
+
+    TRACE_COUNTER("frame", "actors_drawn", (double)core->render_stats.actors_drawn);
+
+    SDL_memcpy(profiler->frame[profiler->next_frame], profiler->phase_time, sizeof(profiler->phase_time));
+    SDL_memset(profiler->phase_time, 0, sizeof(profiler->phase_time));
+
+    profiler->next_frame = (profiler->next_frame + 1) % (int32_t)SDL_arraysize(profiler->frame);
+
+    if ((int32_t)SDL_arraysize(profiler->frame) > profiler->frame_count)
+    {
+        profiler->frame_count += 1;
+    }
+}
+
+esz_frame_phase_stats_t get_frame_phase_stats(const esz_frame_phase phase, const esz_frame_profiler_t* profiler)
+{
+    esz_frame_phase_stats_t stats = { 0 };
+    double                  sample[SDL_arraysize(profiler->frame)];
+    double                  sum   = 0.0;
+
+    stats.frame_count = profiler->frame_count;
+
+    if (0 == profiler->frame_count)
+    {
+        return stats;
+    }
+
+    for (int32_t index = 0; index < profiler->frame_count; index += 1)
+    {
+        sample[index]  = profiler->frame[index][phase];
+        sum           += sample[index];
+    }
+
+    sort_samples(sample, profiler->frame_count);
+
+    stats.average = sum / (double)profiler->frame_count;
+    stats.p95     = get_percentile(sample, profiler->frame_count, 95);
+    stats.p99     = get_percentile(sample, profiler->frame_count, 99);
+    stats.max     = sample[profiler->frame_count - 1];
+
+    return stats;
+}
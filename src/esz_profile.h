@@ -0,0 +1,31 @@
+// SPDX-License-Identifier: MIT
+/**
+ * @file    esz_profile.h
+ * @brief   eszFW frame profiler
+ * @details The phases of a frame are timed with the performance counter
+ *          and kept for the last 128 frames.  The timers are only
+ *          compiled in if USE_PROFILER or USE_TRACING is defined;
+ *          otherwise the macros below expand to nothing.
+ */
+
+#ifndef ESZ_PROFILE_H
+#define ESZ_PROFILE_H
+
+#include "esz_types.h"
+
+#if defined(USE_PROFILER) || defined(USE_TRACING)
+    #define PROFILE_BEGIN(phase, core) begin_frame_phase(phase, core)
+    #define PROFILE_END(phase, core)   end_frame_phase(phase, core)
+    #define PROFILE_END_FRAME(core)    end_profiled_frame(core)
+#else
+    #define PROFILE_BEGIN(phase, core) ((void)0)
+    #define PROFILE_END(phase, core)   ((void)0)
+    #define PROFILE_END_FRAME(core)    ((void)0)
+#endif
+
+void                    begin_frame_phase(const esz_frame_phase phase, esz_core_t* core);
+void                    end_frame_phase(const esz_frame_phase phase, esz_core_t* core);
+void                    end_profiled_frame(esz_core_t* core);
+esz_frame_phase_stats_t get_frame_phase_stats(const esz_frame_phase phase, const esz_frame_profiler_t* profiler);
+
+#endif // ESZ_PROFILE_H
@@ -0,0 +1,301 @@
+// SPDX-License-Identifier: MIT
+/**
+ * @file    esz_qoi.c
+ * @brief   eszFW QOI image codec
+ */
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "esz_qoi.h"
+
+#define QOI_OP_INDEX   0x00
+#define QOI_OP_DIFF    0x40
+#define QOI_OP_LUMA    0x80
+#define QOI_OP_RUN     0xc0
+#define QOI_OP_RGB     0xfe
+#define QOI_OP_RGBA    0xff
+#define QOI_MASK       0xc0
+#define QOI_PADDING    8
+#define QOI_INDEX_SIZE 64
+
+#define QOI_HASH(c) (((c).r * 3 + (c).g * 5 + (c).b * 7 + (c).a * 11) % QOI_INDEX_SIZE)
+
+typedef struct qoi_rgba
+{
+    unsigned char r;
+    unsigned char g;
+    unsigned char b;
+    unsigned char a;
+
+} qoi_rgba_t;
+
+static const unsigned char qoi_padding[QOI_PADDING] = { 0, 0, 0, 0, 0, 0, 0, 1 };
+
+static bool     is_same_color(const qoi_rgba_t* a, const qoi_rgba_t* b);
+static uint32_t read_u32(const unsigned char* buffer);
+static void     write_u32(uint32_t value, unsigned char* buffer);
+
+/* Always yields 8-bit RGBA pixels, allocated with malloc().  The
+ * channel count stored in the header is informative only.
+ */
+unsigned char* decode_qoi(const unsigned char* buffer, size_t length, int32_t* width, int32_t* height)
+{
+    qoi_rgba_t     index[QOI_INDEX_SIZE] = { { 0 } };
+    qoi_rgba_t     color                 = { 0, 0, 0, 255 };
+    unsigned char* pixels;
+    size_t         pixel_count;
+    size_t         chunks_end;
+    size_t         pos                   = QOI_HEADER_SIZE;
+    uint32_t       image_width;
+    uint32_t       image_height;
+    int32_t        run                   = 0;
+
+    if (! is_qoi(buffer, length))
+    {
+        return NULL;
+    }
+
+    image_width  = read_u32(buffer + 4);
+    image_height = read_u32(buffer + 8);
+
+    if (0 == image_width || 0 == image_height || image_height >= QOI_MAX_PIXELS / image_width)
+    {
+        return NULL;
+    }
+
+    pixel_count = (size_t)image_width * (size_t)image_height;
+    pixels      = (unsigned char*)malloc(pixel_count * 4);
+    if (! pixels)
+    {
+        return NULL;
+    }
+
+    // The padding guarantees that a chunk can be read without checks.
+    chunks_end = length - QOI_PADDING;
+
+    for (size_t offset = 0; offset < pixel_count * 4; offset += 4)
+    {
+        if (0 < run)
+        {
+            run -= 1;
+        }
+        else if (pos < chunks_end)
+        {
+            unsigned char tag = buffer[pos];
+
+            pos += 1;
+
+            if (QOI_OP_RGB == tag)
+            {
+                color.r  = buffer[pos];
+                color.g  = buffer[pos + 1];
+                color.b  = buffer[pos + 2];
+                pos     += 3;
+            }
+            else if (QOI_OP_RGBA == tag)
+            {
+                color.r  = buffer[pos];
+                color.g  = buffer[pos + 1];
+                color.b  = buffer[pos + 2];
+                color.a  = buffer[pos + 3];
+                pos     += 4;
+            }
+            else if (QOI_OP_INDEX == (tag & QOI_MASK))
+            {
+                color = index[tag];
+            }
+            else if (QOI_OP_DIFF == (tag & QOI_MASK))
+            {
+                color.r += (unsigned char)(((tag >> 4) & 0x03) - 2);
+                color.g += (unsigned char)(((tag >> 2) & 0x03) - 2);
+                color.b += (unsigned char)((tag & 0x03) - 2);
+            }
+            else if (QOI_OP_LUMA == (tag & QOI_MASK))
+            {
+                unsigned char next  = buffer[pos];
+                int           dg    = (tag & 0x3f) - 32;
+
+                pos     += 1;
+                color.r += (unsigned char)(dg - 8 + ((next >> 4) & 0x0f));
+                color.g += (unsigned char)dg;
+                color.b += (unsigned char)(dg - 8 + (next & 0x0f));
+            }
+            else // QOI_OP_RUN
+            {
+                run = tag & 0x3f;
+            }
+
+            index[QOI_HASH(color)] = color;
+        }
+
+        pixels[offset]     = color.r;
+        pixels[offset + 1] = color.g;
+        pixels[offset + 2] = color.b;
+        pixels[offset + 3] = color.a;
+    }
+
+    *width  = (int32_t)image_width;
+    *height = (int32_t)image_height;
+
+    return pixels;
+}
+
+// Expects 8-bit RGBA pixels; the result is allocated with malloc().
+unsigned char* encode_qoi(const unsigned char* pixels, int32_t width, int32_t height, size_t* length)
+{
+    qoi_rgba_t     index[QOI_INDEX_SIZE] = { { 0 } };
+    qoi_rgba_t     previous              = { 0, 0, 0, 255 };
+    unsigned char* buffer;
+    size_t         pixel_count;
+    size_t         pos                   = QOI_HEADER_SIZE;
+    int32_t        run                   = 0;
+
+    if (0 >= width || 0 >= height || height >= QOI_MAX_PIXELS / width)
+    {
+        return NULL;
+    }
+
+    pixel_count = (size_t)width * (size_t)height;
+
+    // Worst case: every pixel needs a QOI_OP_RGBA chunk.
+    buffer = (unsigned char*)malloc(QOI_HEADER_SIZE + (pixel_count * 5) + QOI_PADDING);
+    if (! buffer)
+    {
+        return NULL;
+    }
+
+    memcpy(buffer, QOI_MAGIC, 4);
+    write_u32((uint32_t)width,  buffer + 4);
+    write_u32((uint32_t)height, buffer + 8);
+    buffer[12] = 4; // RGBA
+    buffer[13] = 0; // sRGB with linear alpha
+
+    for (size_t offset = 0; offset < pixel_count * 4; offset += 4)
+    {
+        qoi_rgba_t color;
+
+        color.r = pixels[offset];
+        color.g = pixels[offset + 1];
+        color.b = pixels[offset + 2];
+        color.a = pixels[offset + 3];
+
+        if (is_same_color(&color, &previous))
+        {
+            run += 1;
+
+            if (62 == run || offset == (pixel_count - 1) * 4)
+            {
+                buffer[pos]  = (unsigned char)(QOI_OP_RUN | (run - 1));
+                pos         += 1;
+                run          = 0;
+            }
+            continue;
+        }
+
+        if (0 < run)
+        {
+            buffer[pos]  = (unsigned char)(QOI_OP_RUN | (run - 1));
+            pos         += 1;
+            run          = 0;
+        }
+
+        if (is_same_color(&color, &index[QOI_HASH(color)]))
+        {
+            buffer[pos]  = (unsigned char)(QOI_OP_INDEX | QOI_HASH(color));
+            pos         += 1;
+        }
+        else if (color.a == previous.a)
+        {
+            signed char dr    = (signed char)(color.r - previous.r);
+            signed char dg    = (signed char)(color.g - previous.g);
+            signed char db    = (signed char)(color.b - previous.b);
+            signed char dr_dg = (signed char)(dr - dg);
+            signed char db_dg = (signed char)(db - dg);
+
+            index[QOI_HASH(color)] = color;
+
+            if (-3 < dr && 2 > dr && -3 < dg && 2 > dg && -3 < db && 2 > db)
+            {
+                buffer[pos]  = (unsigned char)(QOI_OP_DIFF | ((dr + 2) << 4) | ((dg + 2) << 2) | (db + 2));
+                pos         += 1;
+            }
+            else if (-9 < dr_dg && 8 > dr_dg && -33 < dg && 32 > dg && -9 < db_dg && 8 > db_dg)
+            {
+                buffer[pos]      = (unsigned char)(QOI_OP_LUMA | (dg + 32));
+                buffer[pos + 1]  = (unsigned char)(((dr_dg + 8) << 4) | (db_dg + 8));
+                pos             += 2;
+            }
+            else
+            {
+                buffer[pos]      = QOI_OP_RGB;
+                buffer[pos + 1]  = color.r;
+                buffer[pos + 2]  = color.g;
+                buffer[pos + 3]  = color.b;
+                pos             += 4;
+            }
+        }
+        else
+        {
+            index[QOI_HASH(color)] = color;
+
+            buffer[pos]      = QOI_OP_RGBA;
+            buffer[pos + 1]  = color.r;
+            buffer[pos + 2]  = color.g;
+            buffer[pos + 3]  = color.b;
+            buffer[pos + 4]  = color.a;
+            pos             += 5;
+        }
+
+        previous = color;
+    }
+
+    memcpy(buffer + pos, qoi_padding, QOI_PADDING);
+    *length = pos + QOI_PADDING;
+
+    return buffer;
+}
+
+bool is_qoi(const unsigned char* buffer, size_t length)
+{
+    if (! buffer || QOI_HEADER_SIZE + QOI_PADDING > length)
+    {
+        return false;
+    }
+
+    return 0 == memcmp(buffer, QOI_MAGIC, 4);
+}
+
+bool is_qoi_file(const char* file_name)
+{
+    size_t length           = strlen(file_name);
+    size_t extension_length = strlen(QOI_FILE_EXTENSION);
+
+    if (length <= extension_length)
+    {
+        return false;
+    }
+
+    return 0 == strcmp(file_name + length - extension_length, QOI_FILE_EXTENSION);
+}
+
+static bool is_same_color(const qoi_rgba_t* a, const qoi_rgba_t* b)
+{
+    return a->r == b->r && a->g == b->g && a->b == b->b && a->a == b->a;
+}
+
+static uint32_t read_u32(const unsigned char* buffer)
+{
+    return ((uint32_t)buffer[0] << 24) | ((uint32_t)buffer[1] << 16) | ((uint32_t)buffer[2] << 8) | (uint32_t)buffer[3];
+}
+
+static void write_u32(uint32_t value, unsigned char* buffer)
+{
+    buffer[0] = (unsigned char)(value >> 24);
+    buffer[1] = (unsigned char)(value >> 16);
+    buffer[2] = (unsigned char)(value >> 8);
+    buffer[3] = (unsigned char)value;
+}
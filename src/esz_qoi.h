@@ -0,0 +1,28 @@
+// SPDX-License-Identifier: MIT
+/**
+ * @file    esz_qoi.h
+ * @brief   eszFW QOI image codec
+ * @details The "Quite OK Image" format is lossless like PNG, but is
+ *          decoded in a single pass without inflating, which makes it
+ *          several times faster to load.  Images are converted with
+ *          the eszqoi tool.
+ */
+
+#ifndef ESZ_QOI_H
+#define ESZ_QOI_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#define QOI_FILE_EXTENSION ".qoi"
+#define QOI_HEADER_SIZE    14
+#define QOI_MAGIC          "qoif"
+#define QOI_MAX_PIXELS     400000000
+
+unsigned char* decode_qoi(const unsigned char* buffer, size_t length, int32_t* width, int32_t* height);
+unsigned char* encode_qoi(const unsigned char* pixels, int32_t width, int32_t height, size_t* length);
+bool           is_qoi(const unsigned char* buffer, size_t length);
+bool           is_qoi_file(const char* file_name);
+
+#endif // ESZ_QOI_H
@@ -0,0 +1,985 @@
+// SPDX-License-Identifier: MIT
+/**
+ * @file    esz_reload.c
+ * @brief   eszFW hot reloading
+ */
+
+#include <picolog.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#if defined(__linux__)
+    #define HAVE_INOTIFY
+    #include <errno.h>
+    #include <sys/inotify.h>
+    #include <unistd.h>
+#endif
+
+#include "esz_macros.h"
+
+DISABLE_WARNING_PUSH
+DISABLE_WARNING_PADDING
+DISABLE_WARNING_SPECTRE_MITIGATION
+DISABLE_WARNING_SYMBOL_NOT_DEFINED
+
+#include <SDL.h>
+#include <cwalk.h>
+#include <stb_sprintf.h>
+
+DISABLE_WARNING_POP
+
+#include "esz.h"
+#include "esz_atlas.h"
+#include "esz_compat.h"
+#include "esz_hash.h"
+#include "esz_init.h"
+#include "esz_reload.h"
+#include "esz_stream.h"
+#include "esz_types.h"
+#include "esz_utils.h"
+
+static void                add_changed_file(const char* file_name, esz_core_t* core);
+static void                find_dirty_tiles(esz_map_t* next_map, bool* is_level_dirty, bool* is_region_dirty, esz_core_t* core);
+static void                free_entities(esz_map_t* map);
+static void                free_tile_layers(esz_map_t* map);
+static esz_tiled_layer_t** gather_tile_layers(int32_t* layer_count, esz_core_t* core);
+static int32_t             get_tile_layer_level(esz_tiled_layer_t* layer, esz_core_t* core);
+static void                invalidate_map(const bool* is_level_dirty, const bool* is_region_dirty, esz_core_t* core);
+static void                invalidate_map_image(int32_t page, const SDL_Rect* rect, esz_core_t* core);
+static bool                is_map_layout_unchanged(esz_map_t* next_map, esz_core_t* core);
+static void                mark_dirty_tile(int32_t level, int32_t pos_x, int32_t pos_y, bool* is_level_dirty, bool* is_region_dirty, esz_core_t* core);
+static void                read_file_events(esz_core_t* core);
+static esz_status          reload_map(esz_window_t* window, esz_core_t* core);
+static esz_status          reload_map_layers(esz_window_t* window, esz_core_t* core);
+static void                restore_actor_state(const esz_actor_state_t* actor_state, int32_t actor_count, esz_core_t* core);
+static esz_actor_state_t*  save_actor_state(int32_t* actor_count, esz_core_t* core);
+static esz_status          watch_directory(const char* file_name, esz_core_t* core);
+static esz_status          watch_map_files(esz_core_t* core);
+
+void unwatch_map_files(esz_core_t* core)
+{
+    esz_hot_reload_t* hot_reload = &core->hot_reload;
+
+    #ifdef HAVE_INOTIFY
+    // Closing the instance removes all of its watches.
+    if (hot_reload->is_watching)
+    {
+        close(hot_reload->descriptor);
+    }
+    #endif
+
+    for (int32_t index = 0; index < hot_reload->watch_count; index += 1)
+    {
+        free(hot_reload->watch[index].directory);
+    }
+    free(hot_reload->watch);
+
+    for (int32_t index = 0; index < hot_reload->changed_file_count; index += 1)
+    {
+        free(hot_reload->changed_file[index]);
+    }
+    free(hot_reload->changed_file);
+
+    hot_reload->watch              = NULL;
+    hot_reload->changed_file       = NULL;
+    hot_reload->changed_file_count = 0;
+    hot_reload->watch_count        = 0;
+    hot_reload->descriptor         = -1;
+    hot_reload->is_map_changed     = false;
+    hot_reload->is_watching        = false;
+}
+
+void update_hot_reload(esz_window_t* window, esz_core_t* core)
+{
+    esz_hot_reload_t* hot_reload        = &core->hot_reload;
+    bool              is_map_reload_due = false;
+
+    if (! hot_reload->is_enabled || core->loader.core)
+    {
+        return;
+    }
+
+    // Watches are set up lazily, once the map is in place.
+    if (! hot_reload->is_watching)
+    {
+        if (ESZ_OK != watch_map_files(core))
+        {
+            unwatch_map_files(core);
+            hot_reload->is_enabled = false;
+            return;
+        }
+    }
+
+    read_file_events(core);
+
+    if (! hot_reload->is_map_changed && 0 == hot_reload->changed_file_count)
+    {
+        return;
+    }
+
+    // Editors tend to write a file in several steps.
+    if (! SDL_TICKS_PASSED(SDL_GetTicks(), hot_reload->last_change + HOT_RELOAD_DELAY))
+    {
+        return;
+    }
+
+    for (int32_t index = 0; index < hot_reload->changed_file_count; index += 1)
+    {
+        uint64_t   start = SDL_GetPerformanceCounter();
+        int32_t    page  = -1;
+        SDL_Rect   rect  = { 0 };
+        esz_status status;
+
+        status = reload_map_image(hot_reload->changed_file[index], &page, &rect, window, core);
+
+        if (ESZ_OK == status)
+        {
+            invalidate_map_image(page, &rect, core);
+
+            plog_info(
+                "Reload image: %s in %.2f ms.",
+                hot_reload->changed_file[index],
+                (double)(SDL_GetPerformanceCounter() - start) * 1000.0 / (double)SDL_GetPerformanceFrequency());
+        }
+        else if (0 <= page)
+        {
+            // The image was decoded but no longer fits the atlas.
+            is_map_reload_due = true;
+        }
+
+        free(hot_reload->changed_file[index]);
+    }
+    hot_reload->changed_file_count = 0;
+
+    if (is_map_reload_due)
+    {
+        hot_reload->is_map_changed = false;
+        reload_map(window, core);
+    }
+    else if (hot_reload->is_map_changed)
+    {
+        hot_reload->is_map_changed = false;
+        reload_map_layers(window, core);
+    }
+}
+
+static void add_changed_file(const char* file_name, esz_core_t* core)
+{
+    esz_hot_reload_t* hot_reload = &core->hot_reload;
+    char**            changed_file;
+
+    for (int32_t index = 0; index < hot_reload->changed_file_count; index += 1)
+    {
+        if (0 == SDL_strcmp(file_name, hot_reload->changed_file[index]))
+        {
+            return;
+        }
+    }
+
+    changed_file = (char**)realloc(hot_reload->changed_file, (size_t)(hot_reload->changed_file_count + 1) * sizeof(char*));
+    if (! changed_file)
+    {
+        plog_warn("%s: error allocating memory.", __func__);
+        return;
+    }
+    hot_reload->changed_file = changed_file;
+
+    changed_file[hot_reload->changed_file_count] = (char*)calloc(1, strlen(file_name) + 1);
+    if (! changed_file[hot_reload->changed_file_count])
+    {
+        plog_warn("%s: error allocating memory.", __func__);
+        return;
+    }
+    SDL_strlcpy(changed_file[hot_reload->changed_file_count], file_name, strlen(file_name) + 1);
+
+    hot_reload->changed_file_count += 1;
+}
+
+// Compares the tile layers of the loaded map cell by cell.
+static void find_dirty_tiles(esz_map_t* next_map, bool* is_level_dirty, bool* is_region_dirty, esz_core_t* core)
+{
+    esz_map_t*          map         = core->map;
+    esz_tiled_layer_t** layer       = NULL;
+    esz_tiled_layer_t** next_layer  = NULL;
+    int32_t             layer_count = 0;
+    int32_t             map_width   = (int32_t)map->handle->width;
+    int32_t             cell_count  = (int32_t)(map->handle->height * map->handle->width);
+    int32_t             tile_width  = get_tile_width(map->handle);
+    int32_t             tile_height = get_tile_height(map->handle);
+
+    layer      = gather_tile_layers(&layer_count, core);
+    core->map  = next_map;
+    next_layer = gather_tile_layers(&layer_count, core);
+    core->map  = map;
+
+    if (! layer || ! next_layer)
+    {
+        // Re-bake everything rather than nothing.
+        for (int32_t level = 0; level < ESZ_MAP_LAYER_LEVEL_MAX; level += 1)
+        {
+            is_level_dirty[level] = true;
+        }
+
+        for (int32_t index = 0; is_region_dirty && index < map->region_count; index += 1)
+        {
+            is_region_dirty[index] = true;
+        }
+        goto exit;
+    }
+
+    for (int32_t index = 0; index < layer_count; index += 1)
+    {
+        int32_t* content      = get_layer_content(layer[index]);
+        int32_t* next_content = get_layer_content(next_layer[index]);
+        int32_t  level;
+
+        // Invisible layers only contribute their tile properties.
+        if (! layer[index]->visible)
+        {
+            continue;
+        }
+
+        level = get_tile_layer_level(layer[index], core);
+
+        for (int32_t index_cell = 0; index_cell < cell_count; index_cell += 1)
+        {
+            if (content[index_cell] != next_content[index_cell])
+            {
+                mark_dirty_tile(
+                    level,
+                    (index_cell % map_width) * tile_width,
+                    (index_cell / map_width) * tile_height,
+                    is_level_dirty,
+                    is_region_dirty,
+                    core);
+            }
+        }
+    }
+
+exit:
+    free(layer);
+    free(next_layer);
+}
+
+static void free_entities(esz_map_t* map)
+{
+    for (int32_t index = 0; index < map->entity_count; index += 1)
+    {
+        if (map->entity[index].actor)
+        {
+            free(map->entity[index].actor->animation);
+            free(map->entity[index].actor);
+        }
+    }
+    free(map->entity);
+
+    map->entity       = NULL;
+    map->entity_count = 0;
+}
+
+static void free_tile_layers(esz_map_t* map)
+{
+    for (int32_t index = 0; index < map->tile_layer_count; index += 1)
+    {
+        free(map->tile_layer[index].cell);
+        free(map->tile_layer[index].region_cell);
+    }
+    free(map->tile_layer);
+    free(map->animated_tile);
+    free(map->tile_properties);
+
+    map->tile_layer          = NULL;
+    map->animated_tile       = NULL;
+    map->tile_properties     = NULL;
+    map->tile_layer_count    = 0;
+    map->animated_tile_index = 0;
+
+    // Binary maps own their flags.
+    if (! map->binary_map)
+    {
+        free(map->tile_flag);
+        map->tile_flag       = NULL;
+        map->tile_flag_count = 0;
+    }
+}
+
+static esz_tiled_layer_t** gather_tile_layers(int32_t* layer_count, esz_core_t* core)
+{
+    esz_tiled_layer_t** tile_layer;
+    esz_tiled_layer_t*  layer = get_head_layer(core->map->handle);
+
+    *layer_count = 0;
+
+    while (layer)
+    {
+        if (is_tiled_layer_of_type(ESZ_TILE_LAYER, layer, core))
+        {
+            *layer_count += 1;
+        }
+        layer = layer->next;
+    }
+
+    tile_layer = (esz_tiled_layer_t**)calloc((size_t)*layer_count + 1, sizeof(esz_tiled_layer_t*));
+    if (! tile_layer)
+    {
+        plog_error("%s: error allocating memory.", __func__);
+        return NULL;
+    }
+
+    *layer_count = 0;
+    layer        = get_head_layer(core->map->handle);
+
+    while (layer)
+    {
+        if (is_tiled_layer_of_type(ESZ_TILE_LAYER, layer, core))
+        {
+            tile_layer[*layer_count]  = layer;
+            *layer_count             += 1;
+        }
+        layer = layer->next;
+    }
+
+    return tile_layer;
+}
+
+static int32_t get_tile_layer_level(esz_tiled_layer_t* layer, esz_core_t* core)
+{
+    int32_t prop_cnt = get_layer_property_count(layer);
+
+    if (get_boolean_property(H_is_in_foreground, layer->properties, prop_cnt, core))
+    {
+        return ESZ_MAP_LAYER_FG;
+    }
+
+    return ESZ_MAP_LAYER_BG;
+}
+
+/* Non-streamed maps bake each level into one texture, streamed maps
+ * bake each region separately.  Either is baked again the next time
+ * it is rendered.
+ */
+static void invalidate_map(const bool* is_level_dirty, const bool* is_region_dirty, esz_core_t* core)
+{
+    int32_t invalidated_count = 0;
+
+    if (is_region_dirty)
+    {
+        for (int32_t index = 0; index < core->map->region_count; index += 1)
+        {
+            if (is_region_dirty[index])
+            {
+                invalidate_map_region(index, core);
+                invalidated_count += 1;
+            }
+        }
+
+        plog_info("Re-bake %d region(s).", invalidated_count);
+        return;
+    }
+
+    for (int32_t level = 0; level < ESZ_MAP_LAYER_LEVEL_MAX; level += 1)
+    {
+        if (is_level_dirty[level] && core->map->layer_texture[level])
+        {
+            SDL_DestroyTexture(core->map->layer_texture[level]);
+            core->map->layer_texture[level] = NULL;
+            invalidated_count += 1;
+        }
+    }
+
+    plog_info("Re-bake %d layer(s).", invalidated_count);
+}
+
+// Sprites and backgrounds are drawn from the atlas directly.
+static void invalidate_map_image(int32_t page, const SDL_Rect* rect, esz_core_t* core)
+{
+    esz_map_t* map                                     = core->map;
+    bool*      is_region_dirty                         = NULL;
+    bool       is_level_dirty[ESZ_MAP_LAYER_LEVEL_MAX] = { false };
+
+    if (map->region)
+    {
+        is_region_dirty = (bool*)calloc((size_t)map->region_count, sizeof(bool));
+        if (! is_region_dirty)
+        {
+            plog_error("%s: error allocating memory.", __func__);
+            return;
+        }
+    }
+
+    for (int32_t index = 0; index < map->tile_layer_count; index += 1)
+    {
+        esz_tile_layer_t* tile_layer = &map->tile_layer[index];
+
+        for (int32_t index_cell = 0; index_cell < tile_layer->cell_count; index_cell += 1)
+        {
+            esz_tile_cell_t* cell = &tile_layer->cell[index_cell];
+            esz_tile_t*      tile;
+
+            if (cell->gid >= map->tile_count)
+            {
+                continue;
+            }
+
+            tile = &map->tile[cell->gid];
+
+            if (page == tile->page && SDL_HasIntersection(&tile->src, rect))
+            {
+                mark_dirty_tile(tile_layer->level, cell->dst_x, cell->dst_y, is_level_dirty, is_region_dirty, core);
+            }
+        }
+    }
+
+    invalidate_map(is_level_dirty, is_region_dirty, core);
+    free(is_region_dirty);
+}
+
+/* Only edits that keep the tile layout, the tilesets and the images
+ * intact can be applied in place.
+ */
+static bool is_map_layout_unchanged(esz_map_t* next_map, esz_core_t* core)
+{
+    esz_map_t*          map              = core->map;
+    esz_tiled_map_t*    handle           = map->handle;
+    esz_tiled_map_t*    next_handle      = next_map->handle;
+    esz_image_t*        image            = NULL;
+    esz_image_t*        next_image       = NULL;
+    esz_tiled_layer_t** layer            = NULL;
+    esz_tiled_layer_t** next_layer       = NULL;
+    int32_t             image_count      = 0;
+    int32_t             next_image_count = 0;
+    int32_t             layer_count      = 0;
+    int32_t             next_layer_count = 0;
+    bool                is_unchanged     = false;
+
+    if (next_map->binary_map ||
+        handle->width               != next_handle->width               ||
+        handle->height              != next_handle->height              ||
+        get_tile_width(handle)      != get_tile_width(next_handle)      ||
+        get_tile_height(handle)     != get_tile_height(next_handle)     ||
+        get_tileset_count(handle)   != get_tileset_count(next_handle))
+    {
+        return false;
+    }
+
+    for (int32_t index = 0; index < get_tileset_count(handle); index += 1)
+    {
+        if (get_tileset_first_gid(index, handle)   != get_tileset_first_gid(index, next_handle)  ||
+            get_tileset_tile_count(index, handle)  != get_tileset_tile_count(index, next_handle) ||
+            get_tileset_tile_width(index, handle)  != get_tileset_tile_width(index, next_handle) ||
+            get_tileset_tile_height(index, handle) != get_tileset_tile_height(index, next_handle))
+        {
+            return false;
+        }
+    }
+
+    // Functions reading the map handle have to see the new map.
+    if (ESZ_OK != gather_map_images(&image, &image_count, core))
+    {
+        goto exit;
+    }
+    layer = gather_tile_layers(&layer_count, core);
+
+    core->map = next_map;
+
+    if (ESZ_OK != gather_map_images(&next_image, &next_image_count, core))
+    {
+        core->map = map;
+        goto exit;
+    }
+    next_layer = gather_tile_layers(&next_layer_count, core);
+
+    core->map = map;
+
+    if (! layer || ! next_layer || image_count != next_image_count || layer_count != next_layer_count)
+    {
+        goto exit;
+    }
+
+    for (int32_t index = 0; index < image_count; index += 1)
+    {
+        if (image[index].hash != next_image[index].hash)
+        {
+            goto exit;
+        }
+    }
+
+    for (int32_t index = 0; index < layer_count; index += 1)
+    {
+        if (layer[index]->visible != next_layer[index]->visible ||
+            get_tile_layer_level(layer[index], core) != get_tile_layer_level(next_layer[index], core))
+        {
+            goto exit;
+        }
+    }
+
+    is_unchanged = true;
+
+exit:
+    free_map_images(image, image_count);
+    free_map_images(next_image, next_image_count);
+    free(layer);
+    free(next_layer);
+
+    return is_unchanged;
+}
+
+static void mark_dirty_tile(int32_t level, int32_t pos_x, int32_t pos_y, bool* is_level_dirty, bool* is_region_dirty, esz_core_t* core)
+{
+    is_level_dirty[level] = true;
+
+    if (is_region_dirty)
+    {
+        int32_t column = pos_x / core->map->region_width;
+        int32_t row    = pos_y / core->map->region_height;
+
+        is_region_dirty[(row * core->map->region_column_count) + column] = true;
+
+        // Oversized tiles are also baked into the regions above and to the right.
+        if (0 < row)
+        {
+            is_region_dirty[((row - 1) * core->map->region_column_count) + column] = true;
+        }
+
+        if (column + 1 < core->map->region_column_count)
+        {
+            is_region_dirty[(row * core->map->region_column_count) + column + 1] = true;
+
+            if (0 < row)
+            {
+                is_region_dirty[((row - 1) * core->map->region_column_count) + column + 1] = true;
+            }
+        }
+    }
+}
+
+static void read_file_events(esz_core_t* core)
+{
+    #ifdef HAVE_INOTIFY
+    esz_hot_reload_t* hot_reload = &core->hot_reload;
+    uint64_t          map_hash   = generate_hash((const unsigned char*)core->map->file_name);
+    union
+    {
+        struct inotify_event event;
+        char                 buffer[4096];
+
+    } events;
+
+    for (;;)
+    {
+        ssize_t length = read(hot_reload->descriptor, events.buffer, sizeof(events.buffer));
+        char*   next   = events.buffer;
+
+        if (0 >= length)
+        {
+            // EAGAIN: no more events pending.
+            break;
+        }
+
+        while (next < events.buffer + length)
+        {
+            struct inotify_event* event = (struct inotify_event*)(void*)next;
+
+            next += sizeof(struct inotify_event) + event->len;
+
+            if (0 == event->len)
+            {
+                continue;
+            }
+
+            // Different paths may lead to the same directory.
+            for (int32_t index = 0; index < hot_reload->watch_count; index += 1)
+            {
+                char     file_name[512] = { 0 };
+                uint64_t hash;
+                int32_t  page;
+                SDL_Rect rect;
+
+                if (event->wd != hot_reload->watch[index].descriptor)
+                {
+                    continue;
+                }
+
+                stbsp_snprintf(file_name, (int)sizeof(file_name), "%s%s", hot_reload->watch[index].directory, event->name);
+                hash = generate_hash((const unsigned char*)file_name);
+
+                if (map_hash == hash)
+                {
+                    hot_reload->is_map_changed = true;
+                    hot_reload->last_change    = SDL_GetTicks();
+                }
+                else if (get_atlas_region(hash, &page, &rect, &core->map->atlas))
+                {
+                    add_changed_file(file_name, core);
+                    hot_reload->last_change = SDL_GetTicks();
+                }
+            }
+        }
+    }
+
+    #else
+    (void)core;
+    #endif
+}
+
+// Falls back to loading the map from scratch.
+static esz_status reload_map(esz_window_t* window, esz_core_t* core)
+{
+    esz_status         status      = ESZ_OK;
+    esz_actor_state_t* actor_state = NULL;
+    char*              file_name   = NULL;
+    int32_t            actor_count = 0;
+    size_t             length      = strlen(core->map->file_name) + 1;
+
+    file_name = (char*)calloc(1, length);
+    if (! file_name)
+    {
+        plog_error("%s: error allocating memory.", __func__);
+        return ESZ_ERROR_CRITICAL;
+    }
+    SDL_strlcpy(file_name, core->map->file_name, length);
+
+    actor_state = save_actor_state(&actor_count, core);
+
+    esz_unload_map(window, core);
+
+    status = esz_load_map(file_name, window, core);
+    if (ESZ_OK == status)
+    {
+        restore_actor_state(actor_state, actor_count, core);
+        plog_info("Reload map file: %s in %.2f ms.", file_name, core->load_stats.load_time);
+    }
+
+    free(actor_state);
+    free(file_name);
+
+    return status;
+}
+
+/* Swaps in the tile layers and entities of the edited map, keeping the
+ * texture atlas, the tileset and everything baked from tiles that did
+ * not change.
+ */
+static esz_status reload_map_layers(esz_window_t* window, esz_core_t* core)
+{
+    esz_status         status                                  = ESZ_OK;
+    esz_map_t*         map                                     = core->map;
+    esz_map_t*         next_map                                = NULL;
+    esz_actor_state_t* actor_state                             = NULL;
+    bool*              is_region_dirty                         = NULL;
+    bool               is_level_dirty[ESZ_MAP_LAYER_LEVEL_MAX] = { false };
+    int32_t            actor_count                             = 0;
+    uint64_t           start                                   = SDL_GetPerformanceCounter();
+
+    if (map->binary_map)
+    {
+        return reload_map(window, core);
+    }
+
+    next_map = (esz_map_t*)calloc(1, sizeof(struct esz_map));
+    if (! next_map)
+    {
+        plog_error("%s: error allocating memory.", __func__);
+        return ESZ_ERROR_CRITICAL;
+    }
+
+    // Image paths are relative to the map.
+    next_map->path        = map->path;
+    next_map->path_length = map->path_length;
+
+    core->map = next_map;
+    status    = load_tiled_map(map->file_name, core);
+    core->map = map;
+
+    if (ESZ_OK != status)
+    {
+        // Keep the current map until the next edit.
+        free(next_map);
+        return ESZ_WARNING;
+    }
+
+    if (! is_map_layout_unchanged(next_map, core))
+    {
+        core->map = next_map;
+        unload_tiled_map(core);
+        core->map = map;
+        free(next_map);
+
+        return reload_map(window, core);
+    }
+
+    if (map->region)
+    {
+        is_region_dirty = (bool*)calloc((size_t)map->region_count, sizeof(bool));
+        if (! is_region_dirty)
+        {
+            plog_error("%s: error allocating memory.", __func__);
+            status = ESZ_ERROR_CRITICAL;
+            goto exit;
+        }
+    }
+
+    find_dirty_tiles(next_map, is_level_dirty, is_region_dirty, core);
+
+    actor_state = save_actor_state(&actor_count, core);
+
+    free_entities(map);
+    free_tile_layers(map);
+    unload_tiled_map(core);
+
+    map->handle = next_map->handle;
+    #ifndef USE_LIBTMX
+    map->hash_id_objectgroup = next_map->hash_id_objectgroup;
+    map->hash_id_tilelayer   = next_map->hash_id_tilelayer;
+    #endif
+
+    free(next_map);
+    next_map = NULL;
+
+    if (ESZ_OK != load_tile_layers(core) ||
+        (map->region && ESZ_OK != create_map_regions(core)) ||
+        ESZ_OK != load_entities(core))
+    {
+        status = reload_map(window, core);
+        goto exit;
+    }
+
+    restore_actor_state(actor_state, actor_count, core);
+    invalidate_map(is_level_dirty, is_region_dirty, core);
+
+    plog_info(
+        "Reload map file: %s in %.2f ms.",
+        map->file_name,
+        (double)(SDL_GetPerformanceCounter() - start) * 1000.0 / (double)SDL_GetPerformanceFrequency());
+
+exit:
+    if (next_map)
+    {
+        core->map = next_map;
+        unload_tiled_map(core);
+        core->map = map;
+        free(next_map);
+    }
+
+    free(actor_state);
+    free(is_region_dirty);
+
+    return status;
+}
+
+// Actors are matched by their object ID.
+static void restore_actor_state(const esz_actor_state_t* actor_state, int32_t actor_count, esz_core_t* core)
+{
+    // Set up by the map rather than by the game.
+    const uint32_t authored_state =
+        (1UL << STATE_ANIMATED)      | (1UL << STATE_FLOATING)    |
+        (1UL << STATE_GRAVITATIONAL) | (1UL << STATE_IN_BACKGROUND) |
+        (1UL << STATE_IN_FOREGROUND) | (1UL << STATE_IN_MIDGROUND);
+
+    for (int32_t index = 0; index < core->map->entity_count; index += 1)
+    {
+        esz_entity_t* entity = &core->map->entity[index];
+        esz_actor_t*  actor  = entity->actor;
+
+        if (! actor)
+        {
+            continue;
+        }
+
+        for (int32_t index_state = 0; index_state < actor_count; index_state += 1)
+        {
+            const esz_actor_state_t* state = &actor_state[index_state];
+
+            if (entity->id != state->id)
+            {
+                continue;
+            }
+
+            entity->pos_x                     = state->pos_x;
+            entity->pos_y                     = state->pos_y;
+            entity->is_in_loaded_region       = state->is_in_loaded_region;
+            actor->time_since_last_anim_frame = state->time_since_last_anim_frame;
+            actor->velocity_x                 = state->velocity_x;
+            actor->velocity_y                 = state->velocity_y;
+            actor->action                     = state->action;
+            actor->state                      = (actor->state & authored_state) | (state->state & ~authored_state);
+            actor->current_animation          = state->current_animation;
+            actor->current_frame              = state->current_frame;
+
+            if (state->is_active_player)
+            {
+                core->map->active_player_actor_id = index;
+            }
+
+            if (state->is_camera_target)
+            {
+                core->camera.target_actor_id = index;
+            }
+
+            update_bounding_box(entity);
+            break;
+        }
+    }
+}
+
+static esz_actor_state_t* save_actor_state(int32_t* actor_count, esz_core_t* core)
+{
+    esz_actor_state_t* actor_state;
+
+    *actor_count = 0;
+
+    if (0 >= core->map->entity_count)
+    {
+        return NULL;
+    }
+
+    actor_state = (esz_actor_state_t*)calloc((size_t)core->map->entity_count, sizeof(struct esz_actor_state));
+    if (! actor_state)
+    {
+        plog_warn("%s: error allocating memory.", __func__);
+        return NULL;
+    }
+
+    for (int32_t index = 0; index < core->map->entity_count; index += 1)
+    {
+        esz_entity_t*      entity = &core->map->entity[index];
+        esz_actor_t*       actor  = entity->actor;
+        esz_actor_state_t* state  = &actor_state[*actor_count];
+
+        if (! actor)
+        {
+            continue;
+        }
+
+        state->pos_x                      = entity->pos_x;
+        state->pos_y                      = entity->pos_y;
+        state->time_since_last_anim_frame = actor->time_since_last_anim_frame;
+        state->velocity_x                 = actor->velocity_x;
+        state->velocity_y                 = actor->velocity_y;
+        state->action                     = actor->action;
+        state->state                      = actor->state;
+        state->current_animation          = actor->current_animation;
+        state->current_frame              = actor->current_frame;
+        state->id                         = entity->id;
+        state->is_active_player           = index == core->map->active_player_actor_id;
+        state->is_camera_target           = index == core->camera.target_actor_id;
+        state->is_in_loaded_region        = entity->is_in_loaded_region;
+
+        *actor_count += 1;
+    }
+
+    return actor_state;
+}
+
+static esz_status watch_directory(const char* file_name, esz_core_t* core)
+{
+    #ifdef HAVE_INOTIFY
+    esz_hot_reload_t* hot_reload = &core->hot_reload;
+    esz_file_watch_t* watch;
+    char*             directory;
+    size_t            length     = 0;
+
+    cwk_path_get_dirname(file_name, &length);
+
+    directory = (char*)calloc(1, length + 1);
+    if (! directory)
+    {
+        plog_error("%s: error allocating memory.", __func__);
+        return ESZ_ERROR_CRITICAL;
+    }
+    SDL_strlcpy(directory, file_name, length + 1);
+
+    for (int32_t index = 0; index < hot_reload->watch_count; index += 1)
+    {
+        if (0 == SDL_strcmp(directory, hot_reload->watch[index].directory))
+        {
+            free(directory);
+            return ESZ_OK;
+        }
+    }
+
+    watch = (esz_file_watch_t*)realloc(hot_reload->watch, (size_t)(hot_reload->watch_count + 1) * sizeof(struct esz_file_watch));
+    if (! watch)
+    {
+        plog_error("%s: error allocating memory.", __func__);
+        free(directory);
+        return ESZ_ERROR_CRITICAL;
+    }
+    hot_reload->watch = watch;
+
+    watch             = &hot_reload->watch[hot_reload->watch_count];
+    watch->directory  = directory;
+    watch->descriptor = inotify_add_watch(hot_reload->descriptor, length ? directory : ".", IN_CLOSE_WRITE | IN_MOVED_TO);
+
+    // Not fatal: the other directories are still watched.
+    if (0 > watch->descriptor)
+    {
+        plog_warn("%s: could not watch %s: %s.", __func__, length ? directory : ".", strerror(errno));
+        free(directory);
+        return ESZ_OK;
+    }
+
+    hot_reload->watch_count += 1;
+
+    return ESZ_OK;
+
+    #else
+    (void)file_name;
+    (void)core;
+    return ESZ_WARNING;
+    #endif
+}
+
+static esz_status watch_map_files(esz_core_t* core)
+{
+    #ifdef HAVE_INOTIFY
+    esz_hot_reload_t* hot_reload  = &core->hot_reload;
+    esz_status        status      = ESZ_OK;
+    esz_image_t*      image       = NULL;
+    int32_t           image_count = 0;
+
+    hot_reload->descriptor = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+    if (0 > hot_reload->descriptor)
+    {
+        plog_error("%s: %s.", __func__, strerror(errno));
+        return ESZ_WARNING;
+    }
+    hot_reload->is_watching = true;
+
+    status = watch_directory(core->map->file_name, core);
+    if (ESZ_OK != status)
+    {
+        return status;
+    }
+
+    status = gather_map_images(&image, &image_count, core);
+    if (ESZ_OK != status)
+    {
+        goto exit;
+    }
+
+    for (int32_t index = 0; index < image_count; index += 1)
+    {
+        status = watch_directory(image[index].file_name, core);
+        if (ESZ_OK != status)
+        {
+            goto exit;
+        }
+    }
+
+    plog_info("Watch %d directories for changes.", hot_reload->watch_count);
+
+exit:
+    free_map_images(image, image_count);
+
+    return status;
+
+    #else
+    (void)core;
+    plog_warn("%s: hot reloading is only supported on Linux.", __func__);
+    return ESZ_WARNING;
+    #endif
+}
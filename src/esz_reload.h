@@ -0,0 +1,23 @@
+// SPDX-License-Identifier: MIT
+/**
+ * @file    esz_reload.h
+ * @brief   eszFW hot reloading
+ * @details Watches the map file and the images it references for
+ *          changes.  Edited images are written over their region of
+ *          the texture atlas, edited tile layers are swapped in place;
+ *          either way only the layers or regions that show a changed
+ *          tile are baked again.  Actors keep their runtime state as
+ *          long as their object ID still exists.
+ */
+
+#ifndef ESZ_RELOAD_H
+#define ESZ_RELOAD_H
+
+#include "esz_types.h"
+
+#define HOT_RELOAD_DELAY 50 // Milliseconds without changes before reloading.
+
+void unwatch_map_files(esz_core_t* core);
+void update_hot_reload(esz_window_t* window, esz_core_t* core);
+
+#endif // ESZ_RELOAD_H
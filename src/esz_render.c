@@ -4,18 +4,166 @@
  * @brief   eszFW rendering and scene drawing
  */
 
+#include <math.h>
 #include <picolog.h>
 #include <stdbool.h>
 #include <stdint.h>
+#include <stdlib.h>
 
 #include "esz_compat.h"
 #include "esz_hash.h"
+#include "esz_latency.h"
 #include "esz_macros.h"
+#include "esz_profile.h"
+#include "esz_stream.h"
 #include "esz_types.h"
 #include "esz_utils.h"
 
+#if SDL_VERSION_ATLEAST(2, 0, 18)
+    #define GEOMETRY_BATCH_SIZE 4096 // Quads per SDL_RenderGeometry() call.
+#endif
+
 static esz_status render_background_layer(int32_t index, esz_window_t* window, esz_core_t* core);
 
+// Cells are drawn at their map position shifted by the given offset.
+esz_status bake_tile_cells(const esz_tile_cell_t* cell, int32_t cell_count, int32_t offset_x, int32_t offset_y, esz_window_t* window, esz_core_t* core)
+{
+    esz_status  status      = ESZ_OK;
+    esz_tile_t* tile        = core->map->tile;
+    int32_t     tile_count  = core->map->tile_count;
+    int32_t     tile_height = get_tile_height(core->map->handle);
+
+    #if SDL_VERSION_ATLEAST(2, 0, 18)
+    SDL_Vertex* vertex = (SDL_Vertex*)calloc(GEOMETRY_BATCH_SIZE * 4, sizeof(SDL_Vertex));
+    int*        index  = (int*)calloc(GEOMETRY_BATCH_SIZE * 6, sizeof(int));
+
+    if (! vertex || ! index)
+    {
+        plog_error("%s: error allocating memory.", __func__);
+        status = ESZ_ERROR_CRITICAL;
+        goto exit;
+    }
+
+    // The index pattern is the same for every batch.
+    for (int32_t quad = 0; quad < GEOMETRY_BATCH_SIZE; quad += 1)
+    {
+        index[(quad * 6) + 0] = (quad * 4) + 0;
+        index[(quad * 6) + 1] = (quad * 4) + 1;
+        index[(quad * 6) + 2] = (quad * 4) + 2;
+        index[(quad * 6) + 3] = (quad * 4) + 2;
+        index[(quad * 6) + 4] = (quad * 4) + 3;
+        index[(quad * 6) + 5] = (quad * 4) + 0;
+    }
+
+    for (int32_t page = 0; page < core->map->atlas.page_count; page += 1)
+    {
+        SDL_Texture* texture     = core->map->atlas.page[page].texture;
+        float        page_width  = (float)core->map->atlas.page[page].width;
+        float        page_height = (float)core->map->atlas.page[page].height;
+        int32_t      quad_count  = 0;
+
+        for (int32_t index_cell = 0; index_cell < cell_count; index_cell += 1)
+        {
+            int32_t     gid = cell[index_cell].gid;
+            esz_tile_t* src;
+            SDL_Vertex* quad;
+            float       x0, y0, x1, y1;
+            float       u0, v0, u1, v1;
+
+            if (gid >= tile_count)
+            {
+                continue;
+            }
+
+            src = &tile[gid];
+            if (0 >= src->src.w || page != src->page)
+            {
+                continue;
+            }
+
+            // Tiles larger than the grid are aligned to the bottom of their cell.
+            x0 = (float)(cell[index_cell].dst_x + offset_x);
+            y0 = (float)(cell[index_cell].dst_y + offset_y + tile_height - src->src.h);
+            x1 = x0 + (float)src->src.w;
+            y1 = y0 + (float)src->src.h;
+            u0 = (float)src->src.x / page_width;
+            v0 = (float)src->src.y / page_height;
+            u1 = (float)(src->src.x + src->src.w) / page_width;
+            v1 = (float)(src->src.y + src->src.h) / page_height;
+
+            quad = &vertex[quad_count * 4];
+            quad[0] = (SDL_Vertex){ { x0, y0 }, { 255, 255, 255, 255 }, { u0, v0 } };
+            quad[1] = (SDL_Vertex){ { x1, y0 }, { 255, 255, 255, 255 }, { u1, v0 } };
+            quad[2] = (SDL_Vertex){ { x1, y1 }, { 255, 255, 255, 255 }, { u1, v1 } };
+            quad[3] = (SDL_Vertex){ { x0, y1 }, { 255, 255, 255, 255 }, { u0, v1 } };
+
+            quad_count                  += 1;
+            core->load_stats.tiles_baked += 1;
+
+            if (GEOMETRY_BATCH_SIZE == quad_count)
+            {
+                if (0 > SDL_RenderGeometry(window->renderer, texture, vertex, quad_count * 4, index, quad_count * 6))
+                {
+                    plog_error("%s: %s.", __func__, SDL_GetError());
+                    status = ESZ_ERROR_CRITICAL;
+                    goto exit;
+                }
+                core->load_stats.bake_draw_calls += 1;
+                quad_count = 0;
+            }
+        }
+
+        if (0 < quad_count)
+        {
+            if (0 > SDL_RenderGeometry(window->renderer, texture, vertex, quad_count * 4, index, quad_count * 6))
+            {
+                plog_error("%s: %s.", __func__, SDL_GetError());
+                status = ESZ_ERROR_CRITICAL;
+                goto exit;
+            }
+            core->load_stats.bake_draw_calls += 1;
+        }
+    }
+
+exit:
+    free(vertex);
+    free(index);
+
+    #else // SDL_RenderGeometry() requires SDL 2.0.18.
+    for (int32_t index_cell = 0; index_cell < cell_count; index_cell += 1)
+    {
+        int32_t     gid = cell[index_cell].gid;
+        esz_tile_t* src;
+        SDL_Rect    dst;
+
+        if (gid >= tile_count)
+        {
+            continue;
+        }
+
+        src = &tile[gid];
+        if (0 >= src->src.w)
+        {
+            continue;
+        }
+
+        // Tiles larger than the grid are aligned to the bottom of their cell.
+        dst.w = src->src.w;
+        dst.h = src->src.h;
+        dst.x = cell[index_cell].dst_x + offset_x;
+        dst.y = cell[index_cell].dst_y + offset_y + tile_height - src->src.h;
+
+        SDL_RenderCopy(window->renderer, core->map->atlas.page[src->page].texture, &src->src, &dst);
+
+        core->load_stats.tiles_baked     += 1;
+        core->load_stats.bake_draw_calls += 1;
+    }
+
+    #endif
+
+    return status;
+}
+
 esz_status create_and_set_render_target(SDL_Texture** target, esz_window_t* window)
 {
     if (! (*target))
@@ -35,7 +183,7 @@ esz_status create_and_set_render_target(SDL_Texture** target, esz_window_t* wind
     }
     else
     {
-        if (0 > SDL_SetTextureBlendMode((*target), SDL_BLENDMODE_BLEND))
+        if (0 > SDL_SetTextureBlendMode((*target), window->blend_mode))
         {
             plog_error("%s: %s.", __func__, SDL_GetError());
             SDL_DestroyTexture((*target));
@@ -80,7 +228,16 @@ esz_status draw_scene(esz_window_t* window, esz_core_t* core)
             return ESZ_ERROR_CRITICAL;
         }
 
+        if (core->input_latency.is_overlay_enabled)
+        {
+            if (ESZ_OK != render_latency_overlay(window, core))
+            {
+                return ESZ_ERROR_CRITICAL;
+            }
+        }
+
         SDL_RenderPresent(window->renderer);
+        record_present(core);
         SDL_RenderClear(window->renderer);
 
         return ESZ_OK;
@@ -105,7 +262,16 @@ esz_status draw_scene(esz_window_t* window, esz_core_t* core)
         }
     }
 
+    if (core->input_latency.is_overlay_enabled)
+    {
+        if (ESZ_OK != render_latency_overlay(window, core))
+        {
+            return ESZ_ERROR_CRITICAL;
+        }
+    }
+
     SDL_RenderPresent(window->renderer);
+    record_present(core);
 
     SDL_RenderClear(window->renderer);
     return ESZ_OK;
@@ -211,6 +377,8 @@ esz_status render_actors(int32_t level, esz_window_t* window, esz_core_t* core)
                             src.y  = (*actor)->animation[current_animation - 1].offset_y          * object->height;
                         }
 
+                        src.x += core->map->sprite[(*actor)->sprite_sheet_id - 1].rect.x;
+                        src.y += core->map->sprite[(*actor)->sprite_sheet_id - 1].rect.y;
                         src.w  = object->width;
                         src.h  = object->height;
                         dst.x  = (int32_t)pos_x - (object->width  / 2);
@@ -218,11 +386,24 @@ esz_status render_actors(int32_t level, esz_window_t* window, esz_core_t* core)
                         dst.w  = object->width;
                         dst.h  = object->height;
 
+                        /* Skip actors outside of the viewport.  Flipped
+                         * sprites are mirrored around the centre of the
+                         * destination, so they get an additional margin
+                         * of one sprite width.
+                         */
+                        if (! is_rect_in_viewport(&dst, (SDL_FLIP_NONE == flip) ? 0 : dst.w, window))
+                        {
+                            core->render_stats.actors_culled += 1;
+                            break;
+                        }
+
                         if (0 > SDL_RenderCopyEx(window->renderer, core->map->sprite[(*actor)->sprite_sheet_id - 1].texture, &src, &dst, 0, NULL, flip))
                         {
                             plog_error("%s: %s.", __func__, SDL_GetError());
                             return ESZ_ERROR_CRITICAL;
                         }
+
+                        core->render_stats.actors_drawn += 1;
                         break;
                     }
                 }
@@ -310,17 +491,15 @@ esz_status render_background(esz_window_t* window, esz_core_t* core)
 
 esz_status render_map(int32_t level, esz_window_t* window, esz_core_t* core)
 {
-    esz_tiled_layer_t* layer;
-    bool               render_animated_tiles = false;
-    esz_render_layer   render_layer          = ESZ_MAP_FG;
+    bool             render_animated_tiles = false;
+    esz_render_layer render_layer          = ESZ_MAP_FG;
+    uint64_t         bake_start;
 
     if (! core->is_map_loaded)
     {
         return ESZ_OK;
     }
 
-    layer = get_head_layer(core->map->handle);
-
     if (level >= ESZ_MAP_LAYER_LEVEL_MAX)
     {
         plog_error("%s: invalid layer level selected.", __func__);
@@ -345,6 +524,12 @@ esz_status render_map(int32_t level, esz_window_t* window, esz_core_t* core)
     // Update and render animated tiles.
     core->map->time_since_last_anim_frame += window->time_since_last_frame;
 
+    // Streamed maps are drawn region by region.
+    if (core->map->region)
+    {
+        return render_map_regions(level, render_animated_tiles, window, core);
+    }
+
     if (0 < core->map->animated_tile_index &&
         core->map->time_since_last_anim_frame >= 1.0 / (double)(core->map->animated_tile_fps) && render_animated_tiles)
     {
@@ -378,23 +563,17 @@ esz_status render_map(int32_t level, esz_window_t* window, esz_core_t* core)
 
         for (int32_t index = 0; core->map->animated_tile_index > index; index += 1)
         {
-            esz_tiled_tileset_t* tileset;
-            int32_t              gid          = core->map->animated_tile[index].gid;
-            int32_t              next_tile_id = 0;
-            int32_t              local_id;
-            SDL_Rect             dst;
-            SDL_Rect             src;
-
-            local_id = core->map->animated_tile[index].id + 1;
-            tileset  = get_head_tileset(core->map->handle);
-            src.w    = dst.w = get_tile_width(core->map->handle);
-            src.h    = dst.h = get_tile_height(core->map->handle);
-            dst.x    = (int32_t)core->map->animated_tile[index].dst_x;
-            dst.y    = (int32_t)core->map->animated_tile[index].dst_y;
+            int32_t     gid          = core->map->animated_tile[index].gid;
+            int32_t     next_tile_id = 0;
+            esz_tile_t* tile         = &core->map->tile[core->map->animated_tile[index].id];
+            SDL_Rect    dst;
 
-            get_tile_position(local_id, &src.x, &src.y, core->map->handle);
+            dst.w = tile->src.w;
+            dst.h = tile->src.h;
+            dst.x = (int32_t)core->map->animated_tile[index].dst_x;
+            dst.y = (int32_t)core->map->animated_tile[index].dst_y + get_tile_height(core->map->handle) - tile->src.h;
 
-            if (0 > SDL_RenderCopy(window->renderer, core->map->tileset_texture, &src, &dst))
+            if (0 > SDL_RenderCopy(window->renderer, core->map->atlas.page[tile->page].texture, &tile->src, &dst))
             {
                 plog_error("%s: %s.", __func__, SDL_GetError());
                 return ESZ_ERROR_CRITICAL;
@@ -419,7 +598,7 @@ esz_status render_map(int32_t level, esz_window_t* window, esz_core_t* core)
         }
         SDL_RenderClear(window->renderer);
 
-        if (0 > SDL_SetTextureBlendMode(core->map->animated_tile_texture, SDL_BLENDMODE_BLEND))
+        if (0 > SDL_SetTextureBlendMode(core->map->animated_tile_texture, window->blend_mode))
         {
             plog_error("%s: %s.", __func__, SDL_GetError());
             return ESZ_ERROR_CRITICAL;
@@ -460,6 +639,8 @@ esz_status render_map(int32_t level, esz_window_t* window, esz_core_t* core)
     }
 
     // Texture does not yet exist. Render it!
+    bake_start = SDL_GetPerformanceCounter();
+
     core->map->layer_texture[level] = SDL_CreateTexture(
         window->renderer,
         SDL_PIXELFORMAT_ARGB8888,
@@ -480,78 +661,23 @@ esz_status render_map(int32_t level, esz_window_t* window, esz_core_t* core)
     }
     SDL_RenderClear(window->renderer);
 
-    while (layer)
+    for (int32_t index = 0; index < core->map->tile_layer_count; index += 1)
     {
-        SDL_Rect dst;
-        SDL_Rect src;
+        esz_tile_layer_t* tile_layer = &core->map->tile_layer[index];
+        esz_status        status;
 
-        if (is_tiled_layer_of_type(ESZ_TILE_LAYER, layer, core))
+        if (level != tile_layer->level)
         {
-            bool    is_in_foreground  = false;
-            bool    is_layer_rendered = false;
-            int32_t prop_cnt = get_layer_property_count(layer);
-
-            is_in_foreground = get_boolean_property(H_is_in_foreground, layer->properties, prop_cnt, core);
-
-            if (ESZ_MAP_LAYER_BG == level && false == is_in_foreground)
-            {
-                is_layer_rendered = true;
-            }
-            else if (ESZ_MAP_LAYER_FG == level && is_in_foreground)
-            {
-                is_layer_rendered = true;
-            }
-
-            if (layer->visible && is_layer_rendered)
-            {
-                for (int32_t index_height = 0; index_height < (int32_t)core->map->handle->height; index_height += 1)
-                {
-                    for (int32_t index_width = 0; index_width < (int32_t)core->map->handle->width; index_width += 1)
-                    {
-                        int32_t* layer_content = get_layer_content(layer);
-                        int32_t  gid           = remove_gid_flip_bits((int32_t)layer_content[(index_height * (int32_t)core->map->handle->width) + index_width]);
-                        int32_t  local_id      = gid - get_first_gid(core->map->handle);
-
-                        if (is_gid_valid(gid, core->map->handle))
-                        {
-                            esz_tiled_tileset_t* tileset = get_head_tileset(core->map->handle);
-
-                            src.w = dst.w = get_tile_width(core->map->handle);
-                            src.h = dst.h = get_tile_height(core->map->handle);
-                            dst.x = (int32_t)(index_width  * get_tile_width(core->map->handle));
-                            dst.y = (int32_t)(index_height * get_tile_height(core->map->handle));
-
-                            get_tile_position(gid, &src.x, &src.y, core->map->handle);
-                            SDL_RenderCopy(window->renderer, core->map->tileset_texture, &src, &dst);
-
-                            if (render_animated_tiles)
-                            {
-                                int32_t animation_length = 0;
-                                int32_t id               = 0;
-
-                                if (is_tile_animated(gid, &animation_length, &id, core->map->handle))
-                                {
-                                    core->map->animated_tile[core->map->animated_tile_index].gid              = get_local_id(gid, core->map->handle);
-                                    core->map->animated_tile[core->map->animated_tile_index].id               = id;
-                                    core->map->animated_tile[core->map->animated_tile_index].dst_x            = dst.x;
-                                    core->map->animated_tile[core->map->animated_tile_index].dst_y            = dst.y;
-                                    core->map->animated_tile[core->map->animated_tile_index].current_frame    = 0;
-                                    core->map->animated_tile[core->map->animated_tile_index].animation_length = animation_length;
-
-                                    core->map->animated_tile_index += 1;
-                                }
-                            }
-                        }
-                    }
-                }
+            continue;
+        }
 
-                {
-                    const char* layer_name = get_layer_name(layer);
-                    plog_info("Render map layer: %s", layer_name);
-                }
-            }
+        status = bake_tile_cells(tile_layer->cell, tile_layer->cell_count, 0, 0, window, core);
+        if (ESZ_OK != status)
+        {
+            return status;
         }
-        layer = layer->next;
+
+        plog_info("Render map layer: %s", tile_layer->name);
     }
 
     if (0 > SDL_SetRenderTarget(window->renderer, core->map->render_target[render_layer]))
@@ -560,12 +686,14 @@ esz_status render_map(int32_t level, esz_window_t* window, esz_core_t* core)
         return ESZ_ERROR_CRITICAL;
     }
 
-    if (0 > SDL_SetTextureBlendMode(core->map->layer_texture[level], SDL_BLENDMODE_BLEND))
+    if (0 > SDL_SetTextureBlendMode(core->map->layer_texture[level], window->blend_mode))
     {
         plog_error("%s: %s.", __func__, SDL_GetError());
         return ESZ_ERROR_CRITICAL;
     }
 
+    core->load_stats.bake_time += (double)(SDL_GetPerformanceCounter() - bake_start) * 1000.0 / (double)SDL_GetPerformanceFrequency();
+
     return ESZ_OK;
 }
 
@@ -573,7 +701,12 @@ esz_status render_scene(esz_window_t* window, esz_core_t* core)
 {
     esz_status status = ESZ_OK;
 
+    core->render_stats.actors_culled = 0;
+    core->render_stats.actors_drawn  = 0;
+
+    PROFILE_BEGIN(ESZ_PHASE_RENDER_BACKGROUND, core);
     status = render_background(window, core);
+    PROFILE_END(ESZ_PHASE_RENDER_BACKGROUND, core);
     if (ESZ_OK != status)
     {
         return status;
@@ -581,7 +714,9 @@ esz_status render_scene(esz_window_t* window, esz_core_t* core)
 
     for (int32_t index = 0; index < ESZ_MAP_LAYER_LEVEL_MAX; index  += 1)
     {
+        PROFILE_BEGIN((esz_frame_phase)(ESZ_PHASE_RENDER_MAP_BG + index), core);
         status = render_map(index, window, core);
+        PROFILE_END((esz_frame_phase)(ESZ_PHASE_RENDER_MAP_BG + index), core);
         if (ESZ_OK != status)
         {
             return status;
@@ -590,7 +725,9 @@ esz_status render_scene(esz_window_t* window, esz_core_t* core)
 
     for (int32_t index = 0; index < ESZ_ACTOR_LAYER_LEVEL_MAX; index += 1)
     {
+        PROFILE_BEGIN((esz_frame_phase)(ESZ_PHASE_RENDER_ACTORS_BG + index), core);
         status = render_actors(index, window, core);
+        PROFILE_END((esz_frame_phase)(ESZ_PHASE_RENDER_ACTORS_BG + index), core);
         if (ESZ_OK != status)
         {
             return status;
@@ -602,57 +739,44 @@ esz_status render_scene(esz_window_t* window, esz_core_t* core)
 
 static esz_status render_background_layer(int32_t index, esz_window_t* window, esz_core_t* core)
 {
-    esz_render_layer render_layer = ESZ_BACKGROUND;
-    int32_t          width        = 0;
-    SDL_Rect         dst;
-    double           pos_x_a;
-    double           pos_x_b;
-
-    if (0 > SDL_QueryTexture(core->map->background.layer[index].texture, NULL, NULL, &width, NULL))
-    {
-        plog_error("%s: %s.", __func__, SDL_GetError());
-        return ESZ_ERROR_CRITICAL;
-    }
-
-    if (core->map->background.layer[index].pos_x < -width)
-    {
-        core->map->background.layer[index].pos_x = +width;
-    }
+    esz_render_layer        render_layer = ESZ_BACKGROUND;
+    esz_background_layer_t* layer        = &core->map->background.layer[index];
+    int32_t                 width        = layer->width;
+    SDL_Rect                dst;
 
-    if (core->map->background.layer[index].pos_x > +width)
+    if (0 >= width)
     {
-        core->map->background.layer[index].pos_x = -width;
+        return ESZ_OK;
     }
 
-    pos_x_a = core->map->background.layer[index].pos_x;
-    if (0 < pos_x_a)
+    // The velocity is given per frame at the display's refresh rate; late frames scroll further.
+    if (0 < layer->velocity)
     {
-        pos_x_b = pos_x_a - width;
-    }
-    else
-    {
-        pos_x_b = pos_x_a + width;
-    }
+        double distance = layer->velocity * window->time_since_last_frame * (double)window->refresh_rate;
 
-    if (0 < core->map->background.layer[index].velocity)
-    {
         if (ESZ_RIGHT == core->map->background.direction)
         {
-            core->map->background.layer[index].pos_x -= core->map->background.layer[index].velocity;
+            layer->pos_x -= distance;
         }
         else
         {
-            core->map->background.layer[index].pos_x += core->map->background.layer[index].velocity;
+            layer->pos_x += distance;
         }
     }
 
+    layer->pos_x = fmod(layer->pos_x, (double)width);
+    if (0 < layer->pos_x)
+    {
+        layer->pos_x -= width;
+    }
+
     if (ESZ_TOP == core->map->background.alignment)
     {
-        dst.y = (int32_t)(core->map->background.layer[index].pos_y - core->camera.pos_y);
+        dst.y = (int32_t)(layer->pos_y - core->camera.pos_y);
     }
     else
     {
-        dst.y = (int32_t)(core->map->background.layer[index].pos_y + (window->logical_height - core->map->background.layer[index].height));
+        dst.y = (int32_t)(layer->pos_y + (window->logical_height - layer->height));
     }
 
     if (0 > SDL_SetRenderTarget(window->renderer, core->map->render_target[render_layer]))
@@ -663,31 +787,35 @@ static esz_status render_background_layer(int32_t index, esz_window_t* window, e
 
     if (0 == index)
     {
-        SDL_SetRenderDrawColor(
-            window->renderer,
-            (core->map->handle->backgroundcolor >> 16) & 0xFF,
-            (core->map->handle->backgroundcolor >> 8)  & 0xFF,
-            (core->map->handle->backgroundcolor)       & 0xFF,
-            0);
+        if (window->is_premultiplied_alpha_enabled)
+        {
+            // A fully transparent premultiplied colour is black.
+            SDL_SetRenderDrawColor(window->renderer, 0, 0, 0, 0);
+        }
+        else
+        {
+            SDL_SetRenderDrawColor(
+                window->renderer,
+                (core->map->handle->backgroundcolor >> 16) & 0xFF,
+                (core->map->handle->backgroundcolor >> 8)  & 0xFF,
+                (core->map->handle->backgroundcolor)       & 0xFF,
+                0);
+        }
 
         SDL_RenderClear(window->renderer);
     }
 
-    dst.x = (int32_t)pos_x_a;
     dst.w = width;
-    dst.h = core->map->background.layer[index].height;
-
-    if (0 > SDL_RenderCopyEx(window->renderer, core->map->background.layer[index].texture, NULL, &dst, 0, NULL, SDL_FLIP_NONE))
-    {
-        plog_error("%s: %s.", __func__, SDL_GetError());
-        return ESZ_ERROR_CRITICAL;
-    }
+    dst.h = layer->height;
 
-    dst.x = (int32_t)pos_x_b;
-    if (0 > SDL_RenderCopyEx(window->renderer, core->map->background.layer[index].texture, NULL, &dst, 0, NULL, SDL_FLIP_NONE))
+    // Repeat the image until the render target is covered.
+    for (dst.x = (int32_t)layer->pos_x; dst.x < window->width; dst.x += width)
     {
-        plog_error("%s: %s.", __func__, SDL_GetError());
-        return ESZ_ERROR_CRITICAL;
+        if (0 > SDL_RenderCopy(window->renderer, layer->texture, &layer->src, &dst))
+        {
+            plog_error("%s: %s.", __func__, SDL_GetError());
+            return ESZ_ERROR_CRITICAL;
+        }
     }
 
     return ESZ_OK;
@@ -11,6 +11,7 @@
 
 #include "esz_types.h"
 
+esz_status bake_tile_cells(const esz_tile_cell_t* cell, int32_t cell_count, int32_t offset_x, int32_t offset_y, esz_window_t* window, esz_core_t* core);
 esz_status create_and_set_render_target(SDL_Texture** target, esz_window_t* window);
 esz_status draw_scene(esz_window_t* window, esz_core_t* core);
 esz_status render_actors(int32_t level, esz_window_t* window, esz_core_t* core);
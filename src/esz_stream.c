@@ -0,0 +1,596 @@
+// SPDX-License-Identifier: MIT
+/**
+ * @file    esz_stream.c
+ * @brief   eszFW map streaming
+ */
+
+#include <math.h>
+#include <picolog.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdlib.h>
+
+#include "esz_macros.h"
+
+DISABLE_WARNING_PUSH
+DISABLE_WARNING_PADDING
+DISABLE_WARNING_SPECTRE_MITIGATION
+DISABLE_WARNING_SYMBOL_NOT_DEFINED
+
+#include <SDL.h>
+
+DISABLE_WARNING_POP
+
+#include "esz_compat.h"
+#include "esz_event.h"
+#include "esz_render.h"
+#include "esz_stream.h"
+#include "esz_types.h"
+#include "esz_utils.h"
+
+static esz_status bake_map_region(int32_t index, esz_window_t* window, esz_core_t* core);
+static void       evict_map_region(int32_t loaded_index, esz_core_t* core);
+static int32_t    gather_region_cells(int32_t index, const esz_tile_layer_t* tile_layer, const SDL_Rect* rect, esz_tile_cell_t* cell, esz_core_t* core);
+static void       get_region_range(int32_t margin, SDL_Rect* range, esz_window_t* window, esz_core_t* core);
+static void       get_region_rect(int32_t index, SDL_Rect* rect, esz_core_t* core);
+static void       update_region_entities(esz_window_t* window, esz_core_t* core);
+
+/* Sorts the cells of every tile layer by region, so each region can be
+ * baked from a contiguous slice.  The order within a region is kept.
+ * Called again after the tile layers have been reloaded; regions that
+ * are already loaded stay loaded.
+ */
+esz_status create_map_regions(esz_core_t* core)
+{
+    esz_status status     = ESZ_OK;
+    esz_map_t* map        = core->map;
+    int32_t*   next_cell  = NULL;
+    int32_t    map_width  = (int32_t)map->handle->width;
+    int32_t    map_height = (int32_t)map->handle->height;
+
+    map->region_column_count = (map_width  + MAP_REGION_SIZE - 1) / MAP_REGION_SIZE;
+    map->region_row_count    = (map_height + MAP_REGION_SIZE - 1) / MAP_REGION_SIZE;
+    map->region_count        = map->region_column_count * map->region_row_count;
+    map->region_width        = MAP_REGION_SIZE * get_tile_width(map->handle);
+    map->region_height       = MAP_REGION_SIZE * get_tile_height(map->handle);
+
+    if (0 >= map->region_count)
+    {
+        return ESZ_OK;
+    }
+
+    if (! map->region)
+    {
+        map->region        = (esz_map_region_t*)calloc_counted((size_t)map->region_count, sizeof(struct esz_map_region));
+        map->loaded_region = (int32_t*)calloc_counted((size_t)map->region_count, sizeof(int32_t));
+    }
+    next_cell = (int32_t*)calloc_counted((size_t)map->region_count, sizeof(int32_t));
+
+    if (! map->region || ! map->loaded_region || ! next_cell)
+    {
+        plog_error("%s: error allocating memory.", __func__);
+        status = ESZ_ERROR_CRITICAL;
+        goto exit;
+    }
+
+    for (int32_t index = 0; index < map->tile_layer_count; index += 1)
+    {
+        esz_tile_layer_t* tile_layer = &map->tile_layer[index];
+        esz_tile_cell_t*  cell;
+
+        tile_layer->region_cell = (int32_t*)calloc_counted((size_t)map->region_count + 1, sizeof(int32_t));
+        if (! tile_layer->region_cell)
+        {
+            plog_error("%s: error allocating memory.", __func__);
+            status = ESZ_ERROR_CRITICAL;
+            goto exit;
+        }
+
+        if (0 >= tile_layer->cell_count)
+        {
+            continue;
+        }
+
+        cell = (esz_tile_cell_t*)malloc_counted((size_t)tile_layer->cell_count * sizeof(struct esz_tile_cell));
+        if (! cell)
+        {
+            plog_error("%s: error allocating memory.", __func__);
+            status = ESZ_ERROR_CRITICAL;
+            goto exit;
+        }
+
+        for (int32_t index_cell = 0; index_cell < tile_layer->cell_count; index_cell += 1)
+        {
+            int32_t column = tile_layer->cell[index_cell].dst_x / map->region_width;
+            int32_t row    = tile_layer->cell[index_cell].dst_y / map->region_height;
+
+            tile_layer->region_cell[(row * map->region_column_count) + column + 1] += 1;
+        }
+
+        for (int32_t region = 0; region < map->region_count; region += 1)
+        {
+            tile_layer->region_cell[region + 1] += tile_layer->region_cell[region];
+            next_cell[region]                    = tile_layer->region_cell[region];
+        }
+
+        for (int32_t index_cell = 0; index_cell < tile_layer->cell_count; index_cell += 1)
+        {
+            int32_t column = tile_layer->cell[index_cell].dst_x / map->region_width;
+            int32_t row    = tile_layer->cell[index_cell].dst_y / map->region_height;
+            int32_t region = (row * map->region_column_count) + column;
+
+            cell[next_cell[region]]  = tile_layer->cell[index_cell];
+            next_cell[region]       += 1;
+        }
+
+        free(tile_layer->cell);
+        tile_layer->cell = cell;
+    }
+
+    plog_info("Split map into %d region(s) of %dx%d tiles.", map->region_count, MAP_REGION_SIZE, MAP_REGION_SIZE);
+
+exit:
+    free(next_cell);
+
+    return status;
+}
+
+void destroy_map_regions(esz_core_t* core)
+{
+    while (0 < core->map->loaded_region_count)
+    {
+        evict_map_region(core->map->loaded_region_count - 1, core);
+    }
+
+    for (int32_t index = 0; index < core->map->tile_layer_count; index += 1)
+    {
+        free(core->map->tile_layer[index].region_cell);
+        core->map->tile_layer[index].region_cell = NULL;
+    }
+
+    free(core->map->region);
+    free(core->map->loaded_region);
+
+    core->map->region        = NULL;
+    core->map->loaded_region = NULL;
+    core->map->region_count  = 0;
+}
+
+void invalidate_map_region(int32_t index, esz_core_t* core)
+{
+    for (int32_t loaded_index = 0; loaded_index < core->map->loaded_region_count; loaded_index += 1)
+    {
+        if (index == core->map->loaded_region[loaded_index])
+        {
+            evict_map_region(loaded_index, core);
+            return;
+        }
+    }
+}
+
+esz_status render_map_regions(int32_t level, bool render_animated_tiles, esz_window_t* window, esz_core_t* core)
+{
+    SDL_Rect range;
+    int32_t  tile_height = get_tile_height(core->map->handle);
+    bool     next_frame  = false;
+
+    get_region_range(0, &range, window, core);
+
+    for (int32_t row = range.y; row < range.y + range.h; row += 1)
+    {
+        for (int32_t column = range.x; column < range.x + range.w; column += 1)
+        {
+            int32_t           index  = (row * core->map->region_column_count) + column;
+            esz_map_region_t* region = &core->map->region[index];
+            SDL_Rect          dst;
+
+            // Not baked yet: draw its cells directly until it is.
+            if (! region->is_loaded)
+            {
+                for (int32_t layer = 0; layer < core->map->tile_layer_count; layer += 1)
+                {
+                    esz_tile_layer_t* tile_layer = &core->map->tile_layer[layer];
+                    int32_t           first_cell = tile_layer->region_cell[index];
+                    int32_t           cell_count = tile_layer->region_cell[index + 1] - first_cell;
+
+                    if (level != tile_layer->level || 0 >= cell_count)
+                    {
+                        continue;
+                    }
+
+                    if (ESZ_OK != bake_tile_cells(
+                            &tile_layer->cell[first_cell],
+                            cell_count,
+                            (int32_t)(core->map->pos_x - core->camera.pos_x),
+                            (int32_t)(core->map->pos_y - core->camera.pos_y),
+                            window,
+                            core))
+                    {
+                        return ESZ_ERROR_CRITICAL;
+                    }
+                }
+                continue;
+            }
+
+            if (! region->texture[level])
+            {
+                continue;
+            }
+
+            get_region_rect(index, &dst, core);
+            dst.x += (int32_t)(core->map->pos_x - core->camera.pos_x);
+            dst.y += (int32_t)(core->map->pos_y - core->camera.pos_y);
+
+            if (0 > SDL_RenderCopy(window->renderer, region->texture[level], NULL, &dst))
+            {
+                plog_error("%s: %s.", __func__, SDL_GetError());
+                return ESZ_ERROR_CRITICAL;
+            }
+        }
+    }
+
+    if (! render_animated_tiles || 0 >= core->map->animated_tile_index)
+    {
+        return ESZ_OK;
+    }
+
+    if (core->map->time_since_last_anim_frame >= 1.0 / (double)(core->map->animated_tile_fps))
+    {
+        core->map->time_since_last_anim_frame = 0.0;
+        next_frame                            = true;
+    }
+
+    /* A map sized texture for the animated tiles would defeat the
+     * purpose, so they are drawn directly.  Tiles off screen don't
+     * advance; nobody can tell.
+     */
+    for (int32_t index = 0; index < core->map->animated_tile_index; index += 1)
+    {
+        esz_animated_tile_t* animated_tile = &core->map->animated_tile[index];
+        esz_tile_t*          tile          = &core->map->tile[animated_tile->id];
+        SDL_Rect             dst;
+
+        dst.w = tile->src.w;
+        dst.h = tile->src.h;
+        dst.x = animated_tile->dst_x + (int32_t)(core->map->pos_x - core->camera.pos_x);
+        dst.y = animated_tile->dst_y + tile_height - tile->src.h + (int32_t)(core->map->pos_y - core->camera.pos_y);
+
+        if (! is_rect_in_viewport(&dst, 0, window))
+        {
+            continue;
+        }
+
+        if (0 > SDL_RenderCopy(window->renderer, core->map->atlas.page[tile->page].texture, &tile->src, &dst))
+        {
+            plog_error("%s: %s.", __func__, SDL_GetError());
+            return ESZ_ERROR_CRITICAL;
+        }
+
+        if (next_frame)
+        {
+            animated_tile->current_frame += 1;
+
+            if (animated_tile->current_frame >= animated_tile->animation_length)
+            {
+                animated_tile->current_frame = 0;
+            }
+
+            animated_tile->id = get_next_animated_tile_id(animated_tile->gid, animated_tile->current_frame, core->map->handle);
+        }
+    }
+
+    return ESZ_OK;
+}
+
+void update_map_regions(esz_window_t* window, esz_core_t* core)
+{
+    uint64_t start            = SDL_GetPerformanceCounter();
+    SDL_Rect visible;
+    SDL_Rect wanted;
+    SDL_Rect kept;
+    bool     is_within_budget = true;
+
+    get_region_range(0,                     &visible, window, core);
+    get_region_range(MAP_REGION_MARGIN,     &wanted,  window, core);
+    get_region_range(MAP_REGION_MARGIN + 1, &kept,    window, core);
+
+    /* Regions are only evicted once they are one region beyond the
+     * margin, so moving back and forth along a border doesn't bake the
+     * same region over and over again.
+     */
+    for (int32_t loaded_index = core->map->loaded_region_count - 1; loaded_index >= 0; loaded_index -= 1)
+    {
+        SDL_Point region;
+
+        region.x = core->map->loaded_region[loaded_index] % core->map->region_column_count;
+        region.y = core->map->loaded_region[loaded_index] / core->map->region_column_count;
+
+        if (! SDL_PointInRect(&region, &kept))
+        {
+            evict_map_region(loaded_index, core);
+        }
+    }
+
+    /* Visible regions are baked first, then the margin.  At least one
+     * region is baked per frame; visible regions that have to wait are
+     * drawn from their cells in the meantime.
+     */
+    for (int32_t pass = 0; pass < 2 && is_within_budget; pass += 1)
+    {
+        const SDL_Rect* range = (0 == pass) ? &visible : &wanted;
+
+        for (int32_t row = range->y; row < range->y + range->h && is_within_budget; row += 1)
+        {
+            for (int32_t column = range->x; column < range->x + range->w && is_within_budget; column += 1)
+            {
+                int32_t index = (row * core->map->region_column_count) + column;
+                double  elapsed;
+
+                if (core->map->region[index].is_loaded)
+                {
+                    continue;
+                }
+
+                if (ESZ_OK != bake_map_region(index, window, core))
+                {
+                    is_within_budget = false;
+                    break;
+                }
+
+                elapsed          = (double)(SDL_GetPerformanceCounter() - start) * 1000.0 / (double)SDL_GetPerformanceFrequency();
+                is_within_budget = elapsed < MAP_REGION_BAKE_BUDGET;
+            }
+        }
+    }
+
+    update_region_entities(window, core);
+}
+
+static esz_status bake_map_region(int32_t index, esz_window_t* window, esz_core_t* core)
+{
+    esz_status        status     = ESZ_OK;
+    esz_map_region_t* region     = &core->map->region[index];
+    esz_tile_cell_t*  cell       = NULL;
+    int32_t           cell_limit = 0;
+    uint64_t          bake_start = SDL_GetPerformanceCounter();
+    SDL_Rect          rect;
+
+    get_region_rect(index, &rect, core);
+
+    for (int32_t layer = 0; layer < core->map->tile_layer_count; layer += 1)
+    {
+        cell_limit = SDL_max(cell_limit, gather_region_cells(index, &core->map->tile_layer[layer], &rect, NULL, core));
+    }
+
+    if (0 < cell_limit)
+    {
+        cell = (esz_tile_cell_t*)malloc((size_t)cell_limit * sizeof(struct esz_tile_cell));
+        if (! cell)
+        {
+            plog_error("%s: error allocating memory.", __func__);
+            status = ESZ_ERROR_CRITICAL;
+            goto exit;
+        }
+    }
+
+    for (int32_t level = 0; level < ESZ_MAP_LAYER_LEVEL_MAX; level += 1)
+    {
+        for (int32_t layer = 0; layer < core->map->tile_layer_count; layer += 1)
+        {
+            esz_tile_layer_t* tile_layer = &core->map->tile_layer[layer];
+            int32_t           cell_count;
+
+            if (level != tile_layer->level)
+            {
+                continue;
+            }
+
+            // Empty regions don't need a texture at all.
+            cell_count = gather_region_cells(index, tile_layer, &rect, cell, core);
+            if (0 >= cell_count)
+            {
+                continue;
+            }
+
+            if (! region->texture[level])
+            {
+                region->texture[level] = SDL_CreateTexture(
+                    window->renderer,
+                    SDL_PIXELFORMAT_ARGB8888,
+                    SDL_TEXTUREACCESS_TARGET,
+                    rect.w,
+                    rect.h);
+
+                if (! region->texture[level])
+                {
+                    plog_error("%s: %s.", __func__, SDL_GetError());
+                    status = ESZ_ERROR_CRITICAL;
+                    goto exit;
+                }
+
+                if (0 > SDL_SetTextureBlendMode(region->texture[level], window->blend_mode) ||
+                    0 > SDL_SetRenderTarget(window->renderer, region->texture[level]))
+                {
+                    plog_error("%s: %s.", __func__, SDL_GetError());
+                    status = ESZ_ERROR_CRITICAL;
+                    goto exit;
+                }
+                SDL_RenderClear(window->renderer);
+            }
+
+            status = bake_tile_cells(cell, cell_count, -rect.x, -rect.y, window, core);
+            if (ESZ_OK != status)
+            {
+                goto exit;
+            }
+        }
+    }
+
+exit:
+    SDL_SetRenderTarget(window->renderer, NULL);
+    free(cell);
+
+    // Loaded even if baking failed, so the textures are released on eviction.
+    region->is_loaded = true;
+    core->map->loaded_region[core->map->loaded_region_count] = index;
+    core->map->loaded_region_count += 1;
+
+    core->load_stats.bake_time += (double)(SDL_GetPerformanceCounter() - bake_start) * 1000.0 / (double)SDL_GetPerformanceFrequency();
+
+    return status;
+}
+
+static void evict_map_region(int32_t loaded_index, esz_core_t* core)
+{
+    int32_t           index  = core->map->loaded_region[loaded_index];
+    esz_map_region_t* region = &core->map->region[index];
+
+    for (int32_t level = 0; level < ESZ_MAP_LAYER_LEVEL_MAX; level += 1)
+    {
+        if (region->texture[level])
+        {
+            SDL_DestroyTexture(region->texture[level]);
+            region->texture[level] = NULL;
+        }
+    }
+
+    region->is_loaded = false;
+
+    core->map->loaded_region_count          -= 1;
+    core->map->loaded_region[loaded_index]  = core->map->loaded_region[core->map->loaded_region_count];
+}
+
+/* Tiles larger than the grid reach up and to the right, into the
+ * neighbouring regions.  So besides its own cells, a region is baked
+ * with the cells of the regions to its left and below whose tiles
+ * overlap it; the render target clips the rest.  Cells to the left
+ * come first and cells below last, close to the order they are drawn
+ * in without streaming.  Without a buffer, the number of cells that
+ * may be gathered is returned.
+ */
+static int32_t gather_region_cells(int32_t index, const esz_tile_layer_t* tile_layer, const SDL_Rect* rect, esz_tile_cell_t* cell, esz_core_t* core)
+{
+    const SDL_Point source[4]   = { { -1, 0 }, { 0, 0 }, { -1, 1 }, { 0, 1 } };
+    int32_t         column      = index % core->map->region_column_count;
+    int32_t         row         = index / core->map->region_column_count;
+    int32_t         tile_height = get_tile_height(core->map->handle);
+    int32_t         cell_count  = 0;
+
+    for (int32_t source_index = 0; source_index < 4; source_index += 1)
+    {
+        int32_t source_column = column + source[source_index].x;
+        int32_t source_row    = row    + source[source_index].y;
+        int32_t region;
+
+        if (0 > source_column || source_row >= core->map->region_row_count)
+        {
+            continue;
+        }
+
+        region = (source_row * core->map->region_column_count) + source_column;
+
+        if (! cell)
+        {
+            cell_count += tile_layer->region_cell[region + 1] - tile_layer->region_cell[region];
+            continue;
+        }
+
+        for (int32_t index_cell = tile_layer->region_cell[region]; index_cell < tile_layer->region_cell[region + 1]; index_cell += 1)
+        {
+            const esz_tile_cell_t* next = &tile_layer->cell[index_cell];
+
+            if (region != index)
+            {
+                esz_tile_t* tile;
+                SDL_Rect    dst;
+
+                if (next->gid >= core->map->tile_count)
+                {
+                    continue;
+                }
+
+                tile  = &core->map->tile[next->gid];
+                dst.w = tile->src.w;
+                dst.h = tile->src.h;
+                dst.x = next->dst_x;
+                dst.y = next->dst_y + tile_height - tile->src.h;
+
+                if (! SDL_HasIntersection(&dst, rect))
+                {
+                    continue;
+                }
+            }
+
+            cell[cell_count]  = *next;
+            cell_count       += 1;
+        }
+    }
+
+    return cell_count;
+}
+
+// The range is given in regions, clamped to the map.
+static void get_region_range(int32_t margin, SDL_Rect* range, esz_window_t* window, esz_core_t* core)
+{
+    double  view_x       = core->camera.pos_x - core->map->pos_x;
+    double  view_y       = core->camera.pos_y - core->map->pos_y;
+    int32_t first_column = (int32_t)floor(view_x / (double)core->map->region_width)  - margin;
+    int32_t first_row    = (int32_t)floor(view_y / (double)core->map->region_height) - margin;
+    int32_t last_column  = (int32_t)floor((view_x + (double)window->logical_width  - 1.0) / (double)core->map->region_width)  + margin;
+    int32_t last_row     = (int32_t)floor((view_y + (double)window->logical_height - 1.0) / (double)core->map->region_height) + margin;
+
+    first_column = SDL_max(first_column, 0);
+    first_row    = SDL_max(first_row,    0);
+    last_column  = SDL_min(last_column,  core->map->region_column_count - 1);
+    last_row     = SDL_min(last_row,     core->map->region_row_count    - 1);
+
+    range->x = first_column;
+    range->y = first_row;
+    range->w = SDL_max(last_column - first_column + 1, 0);
+    range->h = SDL_max(last_row    - first_row    + 1, 0);
+}
+
+// Regions along the right and bottom edge of the map may be smaller.
+static void get_region_rect(int32_t index, SDL_Rect* rect, esz_core_t* core)
+{
+    rect->x = (index % core->map->region_column_count) * core->map->region_width;
+    rect->y = (index / core->map->region_column_count) * core->map->region_height;
+    rect->w = SDL_min(core->map->region_width,  core->map->width  - rect->x);
+    rect->h = SDL_min(core->map->region_height, core->map->height - rect->y);
+}
+
+static void update_region_entities(esz_window_t* window, esz_core_t* core)
+{
+    for (int32_t index = 0; index < core->map->entity_count; index += 1)
+    {
+        esz_entity_t* entity              = &core->map->entity[index];
+        int32_t       column              = (int32_t)floor(entity->pos_x / (double)core->map->region_width);
+        int32_t       row                 = (int32_t)floor(entity->pos_y / (double)core->map->region_height);
+        bool          is_in_loaded_region = false;
+
+        if (0 <= column && column < core->map->region_column_count &&
+            0 <= row    && row    < core->map->region_row_count)
+        {
+            is_in_loaded_region = core->map->region[(row * core->map->region_column_count) + column].is_loaded;
+        }
+
+        if (is_in_loaded_region == entity->is_in_loaded_region)
+        {
+            continue;
+        }
+
+        entity->is_in_loaded_region = is_in_loaded_region;
+        core->event.entity_id       = index;
+
+        post_engine_event(is_in_loaded_region ? EVENT_ENTITY_ENTERED_REGION : EVENT_ENTITY_LEFT_REGION, NULL, index, core);
+
+        if (is_in_loaded_region && core->event.entity_entered_region_cb)
+        {
+            core->event.entity_entered_region_cb(window, core);
+        }
+        else if (! is_in_loaded_region && core->event.entity_left_region_cb)
+        {
+            core->event.entity_left_region_cb(window, core);
+        }
+    }
+}
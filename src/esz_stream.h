@@ -0,0 +1,31 @@
+// SPDX-License-Identifier: MIT
+/**
+ * @file    esz_stream.h
+ * @brief   eszFW map streaming
+ * @details Splits the tile layers of a map into square regions.  Only
+ *          the regions around the camera are baked into textures;
+ *          regions that fall too far behind are evicted again, so the
+ *          video memory used no longer grows with the size of the map.
+ *          The map itself and its tile cells stay in memory; only the
+ *          baked textures are streamed.
+ */
+
+#ifndef ESZ_STREAM_H
+#define ESZ_STREAM_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "esz_types.h"
+
+#define MAP_REGION_SIZE        32 // Tiles per region side.
+#define MAP_REGION_MARGIN      1  // Regions prefetched around the viewport.
+#define MAP_REGION_BAKE_BUDGET 4  // Milliseconds of baking per frame.
+
+esz_status create_map_regions(esz_core_t* core);
+void       destroy_map_regions(esz_core_t* core);
+void       invalidate_map_region(int32_t index, esz_core_t* core);
+esz_status render_map_regions(int32_t level, bool render_animated_tiles, esz_window_t* window, esz_core_t* core);
+void       update_map_regions(esz_window_t* window, esz_core_t* core);
+
+#endif // ESZ_STREAM_H
@@ -0,0 +1,250 @@
+// SPDX-License-Identifier: MIT
+/**
+ * @file    esz_trace.c
+ * @brief   eszFW trace recorder
+ */
+
+#include <picolog.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <SDL.h>
+
+#include "esz_trace.h"
+#include "esz_types.h"
+
+static esz_trace_event_t* begin_trace_event(void);
+static void               end_trace_event(esz_trace_event_t* event, char phase);
+static double             get_trace_time(uint64_t counter);
+
+/* The map loader works on a private copy of the core, so the recorder
+ * is shared by all threads instead of being part of a core.
+ */
+static esz_tracer_t tracer;
+
+void record_trace_counter(const char* category, const char* name, double value)
+{
+    esz_trace_event_t* event = begin_trace_event();
+
+    if (! event)
+    {
+        return;
+    }
+
+    event->category = category;
+    event->name     = name;
+    event->value    = value;
+    event->start    = SDL_GetPerformanceCounter();
+
+    end_trace_event(event, 'C');
+}
+
+// Scopes are recorded once they have ended, as complete events.
+void record_trace_scope(const char* category, const char* name, uint64_t start, uint64_t end)
+{
+    esz_trace_event_t* event = begin_trace_event();
+
+    if (! event)
+    {
+        return;
+    }
+
+    event->category = category;
+    event->name     = name;
+    event->start    = start;
+    event->end      = end;
+
+    end_trace_event(event, 'X');
+}
+
+esz_status start_trace(const char* file_name)
+{
+    size_t file_name_length;
+
+    if (tracer.event)
+    {
+        plog_warn("%s: a trace is already being recorded.", __func__);
+        return ESZ_WARNING;
+    }
+
+    tracer.event = (esz_trace_event_t*)calloc(TRACE_BUFFER_SIZE, sizeof(esz_trace_event_t));
+    if (! tracer.event)
+    {
+        plog_error("%s: error allocating memory.", __func__);
+        return ESZ_ERROR_CRITICAL;
+    }
+
+    file_name_length = strlen(file_name) + 1;
+    tracer.file_name = (char*)calloc(1, file_name_length);
+    if (! tracer.file_name)
+    {
+        plog_error("%s: error allocating memory.", __func__);
+        free(tracer.event);
+        tracer.event = NULL;
+        return ESZ_ERROR_CRITICAL;
+    }
+    SDL_strlcpy(tracer.file_name, file_name, file_name_length);
+
+    tracer.start          = SDL_GetPerformanceCounter();
+    tracer.main_thread_id = SDL_ThreadID();
+    SDL_AtomicSet(&tracer.event_count, 0);
+    SDL_AtomicCAS(&tracer.is_recording, 0, 1);
+
+    plog_info("Record trace: %s.", file_name);
+    return ESZ_OK;
+}
+
+esz_status stop_trace(void)
+{
+    esz_status status;
+
+    if (! tracer.event)
+    {
+        return ESZ_OK;
+    }
+
+    // Wait for the events that are still being recorded.
+    SDL_AtomicCAS(&tracer.is_recording, 1, 0);
+    while (0 < SDL_AtomicGet(&tracer.writer_count))
+    {
+        SDL_Delay(0);
+    }
+
+    status = write_trace();
+
+    free(tracer.event);
+    free(tracer.file_name);
+    tracer.event     = NULL;
+    tracer.file_name = NULL;
+
+    return status;
+}
+
+/* Can be called while recording: events that are still being written
+ * are not published yet and left out.
+ */
+esz_status write_trace(void)
+{
+    int32_t event_count;
+    int32_t dropped_count = 0;
+    FILE*   fp;
+
+    if (! tracer.event)
+    {
+        plog_warn("%s: no trace is being recorded.", __func__);
+        return ESZ_WARNING;
+    }
+
+    event_count = SDL_AtomicGet(&tracer.event_count);
+    if (TRACE_BUFFER_SIZE < event_count)
+    {
+        dropped_count = event_count - TRACE_BUFFER_SIZE;
+        event_count   = TRACE_BUFFER_SIZE;
+    }
+
+    fp = fopen(tracer.file_name, "w");
+    if (! fp)
+    {
+        plog_warn("%s: could not open %s for writing.", __func__, tracer.file_name);
+        return ESZ_WARNING;
+    }
+
+    fprintf(fp, "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n");
+    fprintf(
+        fp,
+        "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":%lu,\"args\":{\"name\":\"main\"}}",
+        (unsigned long)tracer.main_thread_id);
+
+    for (int32_t index = 0; index < event_count; index += 1)
+    {
+        esz_trace_event_t* event = &tracer.event[index];
+        int                phase = SDL_AtomicGet(&event->phase);
+
+        SDL_MemoryBarrierAcquire();
+
+        if ('X' == phase)
+        {
+            fprintf(
+                fp,
+                ",\n{\"name\":\"%s\",\"cat\":\"%s\",\"ph\":\"X\",\"ts\":%.3f,\"dur\":%.3f,\"pid\":1,\"tid\":%lu}",
+                event->name,
+                event->category,
+                get_trace_time(event->start),
+                get_trace_time(event->end) - get_trace_time(event->start),
+                (unsigned long)event->thread_id);
+        }
+        else if ('C' == phase)
+        {
+            fprintf(
+                fp,
+                ",\n{\"name\":\"%s\",\"cat\":\"%s\",\"ph\":\"C\",\"ts\":%.3f,\"pid\":1,\"tid\":%lu,\"args\":{\"value\":%.3f}}",
+                event->name,
+                event->category,
+                get_trace_time(event->start),
+                (unsigned long)event->thread_id,
+                event->value);
+        }
+    }
+
+    fprintf(fp, "\n]}\n");
+
+    if (ferror(fp))
+    {
+        plog_warn("%s: could not write to %s.", __func__, tracer.file_name);
+        fclose(fp);
+        return ESZ_WARNING;
+    }
+
+    fclose(fp);
+
+    if (0 < dropped_count)
+    {
+        plog_warn("%s: trace buffer full, %d event(s) dropped.", __func__, dropped_count);
+    }
+
+    plog_info("Write trace: %s (%d events).", tracer.file_name, event_count);
+    return ESZ_OK;
+}
+
+/* Writers are counted, so the buffer is not released while an event is
+ * being recorded into it.
+ */
+static esz_trace_event_t* begin_trace_event(void)
+{
+    int32_t index;
+
+    SDL_AtomicAdd(&tracer.writer_count, 1);
+
+    if (! SDL_AtomicGet(&tracer.is_recording))
+    {
+        SDL_AtomicAdd(&tracer.writer_count, -1);
+        return NULL;
+    }
+
+    // Events beyond the end of the buffer are dropped and counted.
+    index = SDL_AtomicAdd(&tracer.event_count, 1);
+    if (TRACE_BUFFER_SIZE <= index)
+    {
+        SDL_AtomicAdd(&tracer.writer_count, -1);
+        return NULL;
+    }
+
+    tracer.event[index].thread_id = SDL_ThreadID();
+
+    return &tracer.event[index];
+}
+
+// The event is published by setting its phase.
+static void end_trace_event(esz_trace_event_t* event, char phase)
+{
+    SDL_MemoryBarrierRelease();
+    SDL_AtomicSet(&event->phase, phase);
+    SDL_AtomicAdd(&tracer.writer_count, -1);
+}
+
+// Microseconds since the trace has been started.
+static double get_trace_time(uint64_t counter)
+{
+    return (double)(int64_t)(counter - tracer.start) * 1000000.0 / (double)SDL_GetPerformanceFrequency();
+}
@@ -0,0 +1,40 @@
+// SPDX-License-Identifier: MIT
+/**
+ * @file    esz_trace.h
+ * @brief   eszFW trace recorder
+ * @details Scopes and counters of the map loader, the frame phases and
+ *          the texture uploads are recorded into a preallocated buffer,
+ *          from any thread, and written as a Chrome trace JSON file
+ *          that can be opened in chrome://tracing or Perfetto.  The
+ *          recording calls are only compiled in if USE_TRACING is
+ *          defined; otherwise the macros below expand to nothing.
+ */
+
+#ifndef ESZ_TRACE_H
+#define ESZ_TRACE_H
+
+#include <stdint.h>
+#include <SDL.h>
+
+#include "esz_types.h"
+
+#define TRACE_BUFFER_SIZE 262144 // Events.
+
+#if defined(USE_TRACING)
+    #define TRACE_COUNTER(category, name, value)    record_trace_counter(category, name, value)
+    #define TRACE_SCOPE(category, name, start, end) record_trace_scope(category, name, start, end)
+    #define TRACE_START(start)                      const uint64_t start = SDL_GetPerformanceCounter()
+#else
+    // Still a declaration, so the call sites don't end up as empty statements.
+    #define TRACE_COUNTER(category, name, value)    ((void)0)
+    #define TRACE_SCOPE(category, name, start, end) ((void)(start))
+    #define TRACE_START(start)                      const uint64_t start = 0
+#endif
+
+void       record_trace_counter(const char* category, const char* name, double value);
+void       record_trace_scope(const char* category, const char* name, uint64_t start, uint64_t end);
+esz_status start_trace(const char* file_name);
+esz_status stop_trace(void);
+esz_status write_trace(void);
+
+#endif // ESZ_TRACE_H
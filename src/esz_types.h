@@ -47,8 +47,9 @@ typedef struct cute_tiled_tileset_t         esz_tiled_tileset_t;
 
 #endif
 
-typedef struct esz_window esz_window_t;
-typedef struct esz_core   esz_core_t;
+typedef struct esz_window    esz_window_t;
+typedef struct esz_core      esz_core_t;
+typedef struct esz_bus_event esz_bus_event_t;
 
 /**
  * @brief     Event callback function type
@@ -57,6 +58,13 @@ typedef struct esz_core   esz_core_t;
  */
 typedef void (*esz_event_callback)(esz_window_t* window, esz_core_t* core);
 
+/**
+ * @brief     Event handler function type
+ * @attention The event is only valid for the duration of the call; the
+ *            userdata pointer is the one given when subscribing.
+ */
+typedef void (*esz_event_handler)(const esz_bus_event_t* event, void* userdata, esz_window_t* window, esz_core_t* core);
+
 /**
  * @brief An enumeration of actor actions
  */
@@ -86,6 +94,16 @@ typedef enum
 
 } esz_direction;
 
+/**
+ * @brief An enumeration of event dispatch modes.
+ */
+typedef enum
+{
+    DISPATCH_INLINE = 0,
+    DISPATCH_DEFERRED
+
+} esz_dispatch_mode;
+
 /**
  * @brief An enumeration of actor layer levels.
  */
@@ -103,17 +121,70 @@ typedef enum
  */
 typedef enum
 {
-    EVENT_FINGERDOWN = 0,
+    EVENT_ENTITY_ENTERED_REGION = 0,
+    EVENT_ENTITY_LEFT_REGION,
+    EVENT_FINGERDOWN,
     EVENT_FINGERMOTION,
     EVENT_FINGERUP,
     EVENT_KEYDOWN,
     EVENT_KEYUP,
+    EVENT_MAP_LOAD_PROGRESS,
     EVENT_MAP_LOADED,
     EVENT_MAP_UNLOADED,
-    EVENT_MULTIGESTURE
+    EVENT_MULTIGESTURE,
+    EVENT_USER
 
 } esz_event_type;
 
+/**
+ * @brief An enumeration of frame phases.
+ */
+typedef enum
+{
+    ESZ_PHASE_POLL_EVENTS = 0,
+    ESZ_PHASE_MOVE_CAMERA,
+    ESZ_PHASE_UPDATE_ENTITIES,
+    ESZ_PHASE_RENDER_BACKGROUND,
+    ESZ_PHASE_RENDER_MAP_BG,
+    ESZ_PHASE_RENDER_MAP_FG,
+    ESZ_PHASE_RENDER_ACTORS_BG,
+    ESZ_PHASE_RENDER_ACTORS_MG,
+    ESZ_PHASE_RENDER_ACTORS_FG,
+    ESZ_PHASE_DRAW_SCENE,
+    ESZ_FRAME_PHASE_MAX
+
+} esz_frame_phase;
+
+/**
+ * @brief An enumeration of map loader states.
+ */
+typedef enum
+{
+    LOADER_IDLE = 0,
+    LOADER_RUNNING,
+    LOADER_READY,
+    LOADER_FAILED
+
+} esz_loader_state;
+
+/**
+ * @brief An enumeration of map loading stages.
+ */
+typedef enum
+{
+    ESZ_STAGE_MAP = 0,
+    ESZ_STAGE_TILED_MAP,
+    ESZ_STAGE_TILE_LAYERS,
+    ESZ_STAGE_PATHS,
+    ESZ_STAGE_ENTITIES,
+    ESZ_STAGE_TEXTURE_ATLAS,
+    ESZ_STAGE_TILESET,
+    ESZ_STAGE_SPRITES,
+    ESZ_STAGE_BACKGROUND,
+    ESZ_MAP_LOAD_STAGE_MAX
+
+} esz_map_load_stage;
+
 /**
  * @brief An enumeration of map layer levels.
  */
@@ -209,6 +280,124 @@ typedef struct esz_aabb
 
 } esz_aabb_t;
 
+/**
+ * @brief A structure that contains a texture atlas page.
+ */
+typedef struct esz_atlas_page
+{
+    SDL_Texture*   texture;
+    unsigned char* pixels;
+    int32_t        width;
+    int32_t        height;
+
+} esz_atlas_page_t;
+
+/**
+ * @brief A structure that contains the location of an image inside of
+ *        a texture atlas.
+ */
+typedef struct esz_atlas_region
+{
+    SDL_Rect rect;
+    uint64_t hash;
+    uint64_t key;
+    int32_t  page;
+
+} esz_atlas_region_t;
+
+/**
+ * @brief A structure that contains a texture atlas.
+ */
+typedef struct esz_atlas
+{
+    esz_atlas_page_t*   page;
+    esz_atlas_region_t* region;
+    uint32_t            format;
+    int32_t             page_count;
+    int32_t             region_count;
+
+} esz_atlas_t;
+
+/**
+ * @brief A structure that contains an entry of the asset pack index.
+ */
+typedef struct esz_asset_pack_entry
+{
+    uint64_t hash;
+    uint64_t offset;
+    uint64_t path_offset;
+    uint64_t size;
+
+} esz_asset_pack_entry_t;
+
+/**
+ * @brief A structure that contains the header of an asset pack.
+ */
+typedef struct esz_asset_pack_header
+{
+    char     magic[8];
+    uint32_t version;
+    uint32_t entry_count;
+
+} esz_asset_pack_header_t;
+
+/**
+ * @brief A structure that contains a mounted asset pack.
+ */
+typedef struct esz_asset_pack
+{
+    unsigned char*          data;
+    esz_asset_pack_entry_t* entry;
+    size_t                  size;
+    uint32_t                entry_count;
+
+} esz_asset_pack_t;
+
+/**
+ * @brief A structure that contains a texture atlas page kept in the
+ *        texture cache.
+ */
+typedef struct esz_texture_cache_entry
+{
+    struct esz_atlas_page page;
+    esz_atlas_region_t*   region;
+    uint64_t              last_used;
+    size_t                size;
+    int32_t               ref_count;
+    int32_t               region_count;
+
+} esz_texture_cache_entry_t;
+
+/**
+ * @brief A structure that contains the texture cache shared by all
+ *        maps.
+ */
+typedef struct esz_texture_cache
+{
+    esz_texture_cache_entry_t* entry;
+    SDL_mutex*                 lock;
+    size_t                     budget;
+    size_t                     size;
+    uint64_t                   tick;
+    int32_t                    entry_count;
+
+} esz_texture_cache_t;
+
+/**
+ * @brief A structure that contains the resources of unloaded maps that
+ *        are still being torn down.
+ */
+typedef struct esz_map_teardown
+{
+    SDL_Thread*     thread;
+    SDL_Texture**   texture;
+    struct esz_map* map;
+    SDL_atomic_t    is_done;
+    int32_t         texture_count;
+    int32_t         texture_limit;
+
+} esz_map_teardown_t;
+
 /**
  * @brief A structure that contains an animated tile.
  */
@@ -243,6 +432,7 @@ typedef struct esz_background_layer
     double       pos_x;
     double       pos_y;
     double       velocity;
+    SDL_Rect     src;
     SDL_Texture* texture;
     int32_t      width;
     int32_t      height;
@@ -290,6 +480,7 @@ typedef struct esz_window_config
     const int32_t logical_height;
     const bool    enable_fullscreen;
     const bool    enable_vsync;
+    const bool    enable_premultiplied_alpha;
 
 } esz_window_config_t;
 
@@ -299,18 +490,75 @@ typedef struct esz_window_config
 typedef struct esz_event
 {
     SDL_Event handle;
+    int32_t   entity_id;
 
+    void (*entity_entered_region_cb)(esz_window_t* window, esz_core_t* core);
+    void (*entity_left_region_cb)(esz_window_t*    window, esz_core_t* core);
     void (*finger_down_cb)(esz_window_t*   window, esz_core_t* core);
     void (*finger_motion_cb)(esz_window_t* window, esz_core_t* core);
     void (*finger_up_cb)(esz_window_t* window, esz_core_t* core);
     void (*key_down_cb)(esz_window_t* window, esz_core_t* core);
     void (*key_up_cb)(esz_window_t* window, esz_core_t* core);
+    void (*map_load_progress_cb)(esz_window_t* window, esz_core_t* core);
     void (*map_loaded_cb)(esz_window_t* window, esz_core_t* core);
     void (*map_unloaded_cb)(esz_window_t*  window, esz_core_t* core);
     void (*multi_gesture_cb)(esz_window_t* window, esz_core_t* core);
 
 } esz_event_t;
 
+/**
+ * @brief A structure that contains an event posted to the event bus.
+ */
+typedef struct esz_bus_event
+{
+    SDL_Event      handle;
+    void*          data;
+    uint64_t       timestamp;
+    esz_event_type type;
+    int32_t        value;
+
+} esz_bus_event_t;
+
+/**
+ * @brief A structure that contains a slot of the event queue.
+ */
+typedef struct esz_event_slot
+{
+    esz_bus_event_t event;
+    SDL_atomic_t    sequence;
+
+} esz_event_slot_t;
+
+/**
+ * @brief A structure that contains an event subscription.
+ */
+typedef struct esz_event_subscriber
+{
+    esz_event_handler handler;
+    void*             userdata;
+    esz_event_type    event_type;
+    esz_dispatch_mode mode;
+
+} esz_event_subscriber_t;
+
+/**
+ * @brief A structure that contains the event bus of an engine core.
+ */
+typedef struct esz_event_bus
+{
+    esz_event_slot_t*       slot;
+    esz_bus_event_t*        deferred;
+    esz_event_subscriber_t* subscriber;
+    SDL_atomic_t            tail;
+    SDL_atomic_t            dropped_count;
+    uint32_t                head;
+    int32_t                 deferred_count;
+    int32_t                 dispatch_depth;
+    int32_t                 subscriber_count;
+    int32_t                 subscriber_limit;
+
+} esz_event_bus_t;
+
 /**
  * @brief A structure that contains actor information.
  */
@@ -318,6 +566,8 @@ typedef struct esz_actor
 {
     double           acceleration;
     double           jumping_power;
+    double           last_velocity_x;
+    double           last_velocity_y;
     double           max_velocity_x;
     double           spawn_pos_x;
     double           spawn_pos_y;
@@ -330,12 +580,36 @@ typedef struct esz_actor
     int32_t          current_frame;
     int32_t          sprite_sheet_id;
     uint32_t         action;
+    uint32_t         last_action;
+    uint32_t         last_state;
     uint32_t         state;
     bool             connect_horizontal_map_ends;
     bool             connect_vertical_map_ends;
 
 } esz_actor_t;
 
+/**
+ * @brief A structure that contains the runtime state of an actor that
+ *        is kept across hot reloads.
+ */
+typedef struct esz_actor_state
+{
+    double   pos_x;
+    double   pos_y;
+    double   time_since_last_anim_frame;
+    double   velocity_x;
+    double   velocity_y;
+    uint32_t action;
+    uint32_t state;
+    int32_t  current_animation;
+    int32_t  current_frame;
+    int32_t  id;
+    bool     is_active_player;
+    bool     is_camera_target;
+    bool     is_in_loaded_region;
+
+} esz_actor_state_t;
+
 /**
  * @brief A structure that contains an entity
  */
@@ -350,19 +624,331 @@ typedef struct esz_entity
     int32_t             id;
     int32_t             index;
     int32_t             width;
+    bool                is_in_loaded_region;
 
 } esz_entity_t;
 
+/**
+ * @brief A structure that contains a directory watched for changes.
+ */
+typedef struct esz_file_watch
+{
+    char* directory;
+    int   descriptor;
+
+} esz_file_watch_t;
+
+/**
+ * @brief A structure that contains the state of the hot reloader.
+ */
+typedef struct esz_hot_reload
+{
+    esz_file_watch_t* watch;
+    char**            changed_file;
+    uint32_t          last_change;
+    int32_t           changed_file_count;
+    int32_t           watch_count;
+    int               descriptor;
+    bool              is_enabled;
+    bool              is_map_changed;
+    bool              is_watching;
+
+} esz_hot_reload_t;
+
+/**
+ * @brief A structure that contains a decoded RGBA image.
+ */
+typedef struct esz_image
+{
+    char*          file_name;
+    unsigned char* pixels;
+    uint64_t       hash;
+    uint64_t       key;
+    int32_t        width;
+    int32_t        height;
+
+} esz_image_t;
+
+/**
+ * @brief A structure that contains a list of images shared by the
+ *        threads decoding them.
+ */
+typedef struct esz_decode_queue
+{
+    esz_image_t*  image;
+    esz_window_t* window;
+    SDL_atomic_t* cancelled;
+    SDL_atomic_t  failed;
+    SDL_atomic_t  next_image;
+    int32_t       image_count;
+
+} esz_decode_queue_t;
+
+/**
+ * @brief A structure that contains an entry of the entity table of a
+ *        binary map file with its properties already resolved.
+ */
+typedef struct esz_entity_entry
+{
+    double   acceleration;
+    double   jumping_power;
+    double   max_velocity_x;
+    double   pos_x;
+    double   pos_y;
+    uint64_t animation_offset;
+    uint64_t name_offset;
+    uint64_t type_hash;
+    int32_t  animation_count;
+    int32_t  height;
+    int32_t  id;
+    int32_t  sprite_sheet_id;
+    int32_t  width;
+    uint32_t state;
+    bool     connect_horizontal_map_ends;
+    bool     connect_vertical_map_ends;
+    bool     is_player;
+
+} esz_entity_entry_t;
+
+/**
+ * @brief A structure that contains the header of a binary map file.
+ */
+typedef struct esz_map_file_header
+{
+    char     magic[8];
+    uint32_t version;
+    uint32_t pointer_size;
+    uint64_t layout;
+    uint64_t file_size;
+    uint64_t map_offset;
+    uint64_t relocation_offset;
+    uint64_t relocation_count;
+    uint64_t tile_flag_offset;
+    uint64_t entity_offset;
+    int32_t  tile_flag_count;
+    int32_t  entity_count;
+
+} esz_map_file_header_t;
+
+/**
+ * @brief A structure that contains the tile data of a layer that was
+ *        decoded ahead of the JSON parser.
+ */
+typedef struct esz_tile_data
+{
+    int32_t* gid;
+    int32_t  gid_count;
+    int32_t  gid_limit;
+    int32_t  layer_id;
+
+} esz_tile_data_t;
+
+/**
+ * @brief A structure that contains a Tiled JSON map with the tile data
+ *        of its layers split off.
+ */
+typedef struct esz_tiled_json
+{
+    char*            text;
+    esz_tile_data_t* tile_data;
+    size_t           text_length;
+    size_t           text_limit;
+    int32_t          tile_data_count;
+    int32_t          tile_data_limit;
+
+} esz_tiled_json_t;
+
+/**
+ * @brief A structure that contains map loading statistics.
+ */
+typedef struct esz_map_load_stats
+{
+    double   bake_time;
+    double   load_time;
+    double   stage_time[ESZ_MAP_LOAD_STAGE_MAX];
+    uint64_t bytes_allocated;
+    uint64_t stage_bytes[ESZ_MAP_LOAD_STAGE_MAX];
+    int32_t  bake_draw_calls;
+    int32_t  tiles_baked;
+
+} esz_map_load_stats_t;
+
+/**
+ * @brief A structure that contains the state of an asynchronous map
+ *        loader.
+ */
+typedef struct esz_map_loader
+{
+    SDL_Thread*   thread;
+    esz_core_t*   core;
+    esz_window_t* window;
+    char*         map_file_name;
+    SDL_atomic_t  cancelled;
+    SDL_atomic_t  progress;
+    SDL_atomic_t  state;
+    int32_t       reported_progress;
+    int32_t       uploaded_page_count;
+    bool          is_staged;
+    bool          is_staging;
+    bool          is_swap_requested;
+
+} esz_map_loader_t;
+
+/**
+ * @brief A structure that contains the frame profiler's history.
+ */
+typedef struct esz_frame_profiler
+{
+    double   frame[128][ESZ_FRAME_PHASE_MAX];
+    double   phase_time[ESZ_FRAME_PHASE_MAX];
+    uint64_t phase_start[ESZ_FRAME_PHASE_MAX];
+    int32_t  frame_count;
+    int32_t  next_frame;
+
+} esz_frame_profiler_t;
+
+/**
+ * @brief A structure that contains the statistics of a frame phase.
+ */
+typedef struct esz_frame_phase_stats
+{
+    double  average;
+    double  max;
+    double  p95;
+    double  p99;
+    int32_t frame_count;
+
+} esz_frame_phase_stats_t;
+
+/**
+ * @brief A structure that contains input-to-present latency samples.
+ */
+typedef struct esz_input_latency
+{
+    double   sample[256];
+    uint64_t pending_frame[64];
+    uint64_t pending_input[64];
+    uint64_t frame_count;
+    uint64_t last_input_frame;
+    int32_t  effective_count;
+    int32_t  next_sample;
+    int32_t  pending_count;
+    int32_t  sample_count;
+    bool     is_overlay_enabled;
+
+} esz_input_latency_t;
+
+/**
+ * @brief A structure that contains input-to-present latency statistics.
+ */
+typedef struct esz_input_latency_stats
+{
+    double   max;
+    double   p50;
+    double   p90;
+    double   p99;
+    uint64_t last_input_frame;
+    int32_t  sample_count;
+
+} esz_input_latency_stats_t;
+
+/**
+ * @brief A structure that contains per-frame render statistics.
+ */
+typedef struct esz_render_stats
+{
+    int32_t actors_culled;
+    int32_t actors_drawn;
+
+} esz_render_stats_t;
+
+/**
+ * @brief A structure that contains a trace event.
+ */
+typedef struct esz_trace_event
+{
+    const char*  category;
+    const char*  name;
+    double       value;
+    uint64_t     end;
+    uint64_t     start;
+    SDL_threadID thread_id;
+    SDL_atomic_t phase;
+
+} esz_trace_event_t;
+
+/**
+ * @brief A structure that contains the trace recorder.
+ */
+typedef struct esz_tracer
+{
+    esz_trace_event_t* event;
+    char*              file_name;
+    uint64_t           start;
+    SDL_threadID       main_thread_id;
+    SDL_atomic_t       event_count;
+    SDL_atomic_t       is_recording;
+    SDL_atomic_t       writer_count;
+
+} esz_tracer_t;
+
 /**
  * @brief A structure that contains a sprite.
  */
 typedef struct esz_sprite
 {
+    SDL_Rect     rect;
     SDL_Texture* texture;
     int32_t      id;
 
 } esz_sprite_t;
 
+/**
+ * @brief A structure that describes where a tile is found in the
+ *        texture atlas.
+ */
+typedef struct esz_tile
+{
+    SDL_Rect src;
+    int32_t  page;
+
+} esz_tile_t;
+
+/**
+ * @brief A structure that contains a non-empty cell of a tile layer.
+ */
+typedef struct esz_tile_cell
+{
+    int32_t dst_x;
+    int32_t dst_y;
+    int32_t gid;
+
+} esz_tile_cell_t;
+
+/**
+ * @brief A structure that contains the non-empty cells of a visible
+ *        tile layer, gathered once when the map is loaded.
+ */
+typedef struct esz_tile_layer
+{
+    const char*      name;
+    esz_tile_cell_t* cell;
+    int32_t*         region_cell;
+    int32_t          cell_count;
+    int32_t          level;
+
+} esz_tile_layer_t;
+
+/**
+ * @brief A structure that contains a region of a streamed map.
+ */
+typedef struct esz_map_region
+{
+    SDL_Texture* texture[ESZ_MAP_LAYER_LEVEL_MAX];
+    bool         is_loaded;
+
+} esz_map_region_t;
+
 /**
  * @brief A structure that contains a game map.
  */
@@ -381,27 +967,46 @@ typedef struct esz_map
     long long unsigned    hash_id_tilelayer;
     #endif
 
+    size_t                binary_map_size;
     size_t                path_length;
     const char*           string_property;
+    char*                 file_name;
     char*                 path;
+    void*                 binary_map;
     SDL_Texture*          animated_tile_texture;
     SDL_Texture*          layer_texture[ESZ_MAP_LAYER_LEVEL_MAX];
     SDL_Texture*          render_target[ESZ_RENDER_LAYER_MAX];
-    SDL_Texture*          tileset_texture;
     esz_animated_tile_t*  animated_tile;
+    struct esz_atlas      atlas;
     struct esz_background background;
+    esz_entity_entry_t*   binary_entity;
     esz_entity_t*         entity;
+    esz_map_region_t*     region;
     esz_sprite_t*         sprite;
+    esz_tile_t*           tile;
+    esz_tile_layer_t*     tile_layer;
     esz_tiled_map_t*      handle;
+    uint32_t*             tile_flag;
     uint32_t*             tile_properties;
+    int32_t*              loaded_region;
     int32_t               active_player_actor_id;
     int32_t               animated_tile_fps;
     int32_t               animated_tile_index;
+    int32_t               binary_entity_count;
     int32_t               height;
     int32_t               integer_property;
+    int32_t               loaded_region_count;
     int32_t               meter_in_pixel;
     int32_t               entity_count;
+    int32_t               region_column_count;
+    int32_t               region_count;
+    int32_t               region_height;
+    int32_t               region_row_count;
+    int32_t               region_width;
     int32_t               sprite_sheet_count;
+    int32_t               tile_count;
+    int32_t               tile_flag_count;
+    int32_t               tile_layer_count;
     int32_t               width;
     bool                  boolean_property;
 
@@ -412,13 +1017,24 @@ typedef struct esz_map
  */
 typedef struct esz_core
 {
-    struct esz_camera camera;
-    struct esz_event  event;
-    esz_map_t*        map;
-    uint32_t          debug;
-    bool              is_active;
-    bool              is_map_loaded;
-    bool              is_paused;
+    struct esz_camera         camera;
+    struct esz_event          event;
+    struct esz_event_bus      event_bus;
+    struct esz_frame_profiler profiler;
+    struct esz_hot_reload     hot_reload;
+    struct esz_input_latency  input_latency;
+    struct esz_map_load_stats load_stats;
+    struct esz_map_loader     loader;
+    struct esz_render_stats   render_stats;
+    esz_map_t*                map;
+    esz_map_t*                retired_map;
+    uint32_t                  debug;
+    bool                      is_active;
+    bool                      is_atlas_cache_enabled;
+    bool                      is_deferred_unload_enabled;
+    bool                      is_map_loaded;
+    bool                      is_map_streaming_enabled;
+    bool                      is_paused;
 
 } esz_core_t;
 
@@ -427,24 +1043,31 @@ typedef struct esz_core
  */
 typedef struct esz_window
 {
-    double        initial_zoom_level;
-    double        time_since_last_frame;
-    double        zoom_level;
-    SDL_Renderer* renderer;
-    SDL_Texture*  esz_logo;
-    SDL_Window*   window;
-    uint32_t      flags;
-    uint32_t      time_a;
-    uint32_t      time_b;
-    int32_t       height;
-    int32_t       logical_height;
-    int32_t       logical_width;
-    int32_t       pos_x;
-    int32_t       pos_y;
-    int32_t       refresh_rate;
-    int32_t       width;
-    bool          is_fullscreen;
-    bool          vsync_enabled;
+    struct esz_asset_pack    asset_pack;
+    struct esz_map_teardown  map_teardown;
+    struct esz_texture_cache texture_cache;
+    double                   initial_zoom_level;
+    double                   time_since_last_frame;
+    double                   zoom_level;
+    SDL_Renderer*            renderer;
+    SDL_Texture*             esz_logo;
+    SDL_Window*              window;
+    SDL_BlendMode            blend_mode;
+    uint64_t                 frame_start;
+    uint32_t                 flags;
+    uint32_t                 texture_format;
+    int32_t                  height;
+    int32_t                  logical_height;
+    int32_t                  logical_width;
+    int32_t                  max_texture_height;
+    int32_t                  max_texture_width;
+    int32_t                  pos_x;
+    int32_t                  pos_y;
+    int32_t                  refresh_rate;
+    int32_t                  width;
+    bool                     is_fullscreen;
+    bool                     is_premultiplied_alpha_enabled;
+    bool                     vsync_enabled;
 
 } esz_window_t;
 
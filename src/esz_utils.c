@@ -5,17 +5,72 @@
  */
 
 #include <math.h>
+#include <picolog.h>
 #include <stdbool.h>
 #include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
 #include <SDL.h>
 
+#if defined(__unix__) || defined(__APPLE__)
+    #define HAVE_MMAP
+    #include <fcntl.h>
+    #include <sys/mman.h>
+    #include <sys/stat.h>
+    #include <unistd.h>
+#endif
+
 #include "esz.h"
 #include "esz_compat.h"
+#include "esz_event.h"
 #include "esz_hash.h"
+#include "esz_latency.h"
 #include "esz_macros.h"
 #include "esz_types.h"
 #include "esz_utils.h"
 
+static int  compare_sample(const void* a, const void* b);
+static void count_allocation(size_t size);
+static bool is_actor_changed(const esz_actor_t* actor);
+
+static uint64_t     allocated_bytes;
+static SDL_SpinLock allocated_bytes_lock;
+
+/* The counting allocators are used for everything allocated while a map
+ * is loaded, so the load statistics can attribute memory to each stage.
+ * Only the requested sizes are summed up, and reallocations only count
+ * by how much they grow; frees are not tracked.
+ */
+void* calloc_counted(size_t count, size_t size)
+{
+    void* ptr;
+
+    if (0 != size && count > SIZE_MAX / size)
+    {
+        return NULL;
+    }
+
+    ptr = calloc(count, size);
+
+    if (ptr)
+    {
+        count_allocation(count * size);
+    }
+
+    return ptr;
+}
+
+uint64_t get_allocated_bytes(void)
+{
+    uint64_t bytes;
+
+    SDL_AtomicLock(&allocated_bytes_lock);
+    bytes = allocated_bytes;
+    SDL_AtomicUnlock(&allocated_bytes_lock);
+
+    return bytes;
+}
+
 bool get_boolean_property(const uint64_t name_hash, esz_tiled_property_t* properties, int32_t property_count, esz_core_t* core)
 {
     core->map->boolean_property = false;
@@ -37,6 +92,19 @@ int32_t get_integer_property(const uint64_t name_hash, esz_tiled_property_t* pro
     return core->map->integer_property;
 }
 
+// Nearest-rank method.
+double get_percentile(const double* sorted_sample, int32_t sample_count, int32_t percentile)
+{
+    int32_t rank = ((percentile * sample_count) + 99) / 100;
+
+    if (1 > rank)
+    {
+        rank = 1;
+    }
+
+    return sorted_sample[rank - 1];
+}
+
 const char* get_string_property(const uint64_t name_hash, esz_tiled_property_t* properties, int32_t property_count, esz_core_t* core)
 {
     core->map->string_property = NULL;
@@ -44,11 +112,143 @@ const char* get_string_property(const uint64_t name_hash, esz_tiled_property_t*
     return core->map->string_property;
 }
 
+uint32_t get_texture_format(esz_window_t* window)
+{
+    SDL_RendererInfo renderer_info = { 0 };
+
+    if (0 > SDL_GetRendererInfo(window->renderer, &renderer_info))
+    {
+        plog_warn("%s: %s.", __func__, SDL_GetError());
+        return SDL_PIXELFORMAT_ARGB8888;
+    }
+
+    // Use the first 32-bit format with alpha channel the renderer prefers.
+    for (uint32_t index = 0; index < renderer_info.num_texture_formats; index += 1)
+    {
+        switch (renderer_info.texture_formats[index])
+        {
+            case SDL_PIXELFORMAT_ARGB8888:
+            case SDL_PIXELFORMAT_ABGR8888:
+            case SDL_PIXELFORMAT_RGBA8888:
+            case SDL_PIXELFORMAT_BGRA8888:
+                return renderer_info.texture_formats[index];
+            default:
+                break;
+        }
+    }
+
+    return SDL_PIXELFORMAT_ARGB8888;
+}
+
 bool is_camera_at_horizontal_boundary(esz_core_t* core)
 {
     return core->camera.is_at_horizontal_boundary;
 }
 
+bool is_rect_in_viewport(const SDL_Rect* rect, int32_t margin, esz_window_t* window)
+{
+    SDL_Rect viewport;
+
+    viewport.x = 0 - margin;
+    viewport.y = 0 - margin;
+    viewport.w = window->logical_width  + (margin * 2);
+    viewport.h = window->logical_height + (margin * 2);
+
+    if (SDL_HasIntersection(rect, &viewport))
+    {
+        return true;
+    }
+
+    return false;
+}
+
+void* malloc_counted(size_t size)
+{
+    void* ptr = malloc(size);
+
+    if (ptr)
+    {
+        count_allocation(size);
+    }
+
+    return ptr;
+}
+
+void* map_file(const char* file_name, size_t* size)
+{
+    #ifdef HAVE_MMAP
+    struct stat file_info;
+    void*       data;
+    int         fd = open(file_name, O_RDONLY);
+
+    if (0 > fd)
+    {
+        plog_error("%s: could not open %s.", __func__, file_name);
+        return NULL;
+    }
+
+    if (0 != fstat(fd, &file_info) || 0 >= file_info.st_size)
+    {
+        plog_error("%s: could not stat %s.", __func__, file_name);
+        close(fd);
+        return NULL;
+    }
+
+    *size = (size_t)file_info.st_size;
+    data  = mmap(NULL, *size, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0);
+    close(fd);
+
+    if (MAP_FAILED == data)
+    {
+        plog_error("%s: could not map %s.", __func__, file_name);
+        return NULL;
+    }
+
+    return data;
+
+    #else // Read the file into memory instead.
+    void* data;
+    long  file_size;
+    FILE* fp = fopen(file_name, "rb");
+
+    if (! fp)
+    {
+        plog_error("%s: could not open %s.", __func__, file_name);
+        return NULL;
+    }
+
+    fseek(fp, 0, SEEK_END);
+    file_size = ftell(fp);
+    fseek(fp, 0, SEEK_SET);
+
+    if (0 >= file_size)
+    {
+        fclose(fp);
+        return NULL;
+    }
+
+    *size = (size_t)file_size;
+    data  = malloc(*size);
+    if (! data)
+    {
+        plog_error("%s: error allocating memory.", __func__);
+        fclose(fp);
+        return NULL;
+    }
+
+    if (1 != fread(data, *size, 1, fp))
+    {
+        plog_error("%s: could not read %s.", __func__, file_name);
+        free(data);
+        data = NULL;
+    }
+
+    fclose(fp);
+    return data;
+
+    #endif
+}
+
 void move_camera_to_target(esz_window_t* window, esz_core_t* core)
 {
     if (core->camera.is_locked)
@@ -83,30 +283,40 @@ void poll_events(esz_window_t* window, esz_core_t* core)
 
     while (0 != SDL_PollEvent(&core->event.handle))
     {
+        record_input(&core->event.handle, core);
+
         switch (core->event.handle.type)
         {
             case SDL_QUIT:
                 core->is_active = false;
                 return;
             case SDL_FINGERDOWN:
+                post_engine_event(EVENT_FINGERDOWN, &core->event.handle, 0, core);
+
                 if (core->event.finger_down_cb)
                 {
                     core->event.finger_down_cb(window, core);
                 }
                 break;
             case SDL_FINGERUP:
+                post_engine_event(EVENT_FINGERUP, &core->event.handle, 0, core);
+
                 if (core->event.finger_up_cb)
                 {
                     core->event.finger_up_cb(window, core);
                 }
                 break;
             case SDL_FINGERMOTION:
+                post_engine_event(EVENT_FINGERMOTION, &core->event.handle, 0, core);
+
                 if (core->event.finger_motion_cb)
                 {
                     core->event.finger_motion_cb(window, core);
                 }
                 break;
             case SDL_KEYDOWN:
+                post_engine_event(EVENT_KEYDOWN, &core->event.handle, 0, core);
+
                 if (core->event.key_down_cb)
                 {
                     core->event.key_down_cb(window, core);
@@ -127,12 +337,16 @@ void poll_events(esz_window_t* window, esz_core_t* core)
 
                 break;
             case SDL_KEYUP:
+                post_engine_event(EVENT_KEYUP, &core->event.handle, 0, core);
+
                 if (core->event.key_up_cb)
                 {
                     core->event.key_up_cb(window, core);
                 }
                 break;
             case SDL_MULTIGESTURE:
+                post_engine_event(EVENT_MULTIGESTURE, &core->event.handle, 0, core);
+
                 if (core->event.multi_gesture_cb)
                 {
                     core->event.multi_gesture_cb(window, core);
@@ -178,6 +392,18 @@ void poll_events(esz_window_t* window, esz_core_t* core)
     }
 }
 
+void* realloc_counted(void* ptr, size_t old_size, size_t size)
+{
+    void* new_ptr = realloc(ptr, size);
+
+    if (new_ptr && size > old_size)
+    {
+        count_allocation(size - old_size);
+    }
+
+    return new_ptr;
+}
+
 void set_camera_boundaries_to_map_size(esz_window_t* window, esz_core_t* core)
 {
     core->camera.is_at_horizontal_boundary = false;
@@ -207,6 +433,23 @@ void set_camera_boundaries_to_map_size(esz_window_t* window, esz_core_t* core)
     }
 }
 
+void sort_samples(double* sample, int32_t sample_count)
+{
+    qsort(sample, (size_t)sample_count, sizeof(double), compare_sample);
+}
+
+void unmap_file(void* data, size_t size)
+{
+    #ifdef HAVE_MMAP
+    munmap(data, size);
+
+    #else
+    (void)size;
+    free(data);
+
+    #endif
+}
+
 void update_bounding_box(esz_entity_t* entity)
 {
     entity->bounding_box.top    = entity->pos_y - (double)(entity->height / 2.0);
@@ -259,6 +502,18 @@ void update_entities(esz_window_t* window, esz_core_t* core)
                         double        distance_x            = acceleration_x * time_since_last_frame * time_since_last_frame;
                         double        distance_y            = acceleration_y * time_since_last_frame * time_since_last_frame;
 
+                        // Input latency
+                        // ----------------------------------------------------
+
+                        /* Whatever changed the player since the last
+                         * update was done by an input callback or the
+                         * application, not by the physics below.
+                         */
+                        if (index == core->map->active_player_actor_id && is_actor_changed(*actor))
+                        {
+                            record_state_change(core);
+                        }
+
                         // Vertical movement and gravity
                         // ----------------------------------------------------
 
@@ -417,6 +672,11 @@ void update_entities(esz_window_t* window, esz_core_t* core)
                             // tbd.
                         }
 
+                        (*actor)->last_action     = (*actor)->action;
+                        (*actor)->last_state      = (*actor)->state;
+                        (*actor)->last_velocity_x = (*actor)->velocity_x;
+                        (*actor)->last_velocity_y = (*actor)->velocity_y;
+
                        break;
                     }
                 }
@@ -433,3 +693,32 @@ void update_entities(esz_window_t* window, esz_core_t* core)
         layer = layer->next;
     }
 }
+
+static int compare_sample(const void* a, const void* b)
+{
+    double sample_a = *(const double*)a;
+    double sample_b = *(const double*)b;
+
+    return (sample_a > sample_b) - (sample_a < sample_b);
+}
+
+static void count_allocation(size_t size)
+{
+    SDL_AtomicLock(&allocated_bytes_lock);
+    allocated_bytes += (uint64_t)size;
+    SDL_AtomicUnlock(&allocated_bytes_lock);
+}
+
+// Compared against the end of the previous update.
+static bool is_actor_changed(const esz_actor_t* actor)
+{
+    if (actor->last_action != actor->action || actor->last_state != actor->state)
+    {
+        return true;
+    }
+
+    // Without ==, which -Wfloat-equal would flag.
+    return
+        actor->last_velocity_x < actor->velocity_x || actor->last_velocity_x > actor->velocity_x ||
+        actor->last_velocity_y < actor->velocity_y || actor->last_velocity_y > actor->velocity_y;
+}
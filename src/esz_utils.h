@@ -9,18 +9,29 @@
 #define ESZ_UTILS_H
 
 #include <stdbool.h>
+#include <stddef.h>
 #include <stdint.h>
 
 #include "esz_types.h"
 
+void*       calloc_counted(size_t count, size_t size);
+uint64_t    get_allocated_bytes(void);
 bool        get_boolean_property(const uint64_t name_hash, esz_tiled_property_t* properties, int32_t property_count, esz_core_t* core);
 double      get_decimal_property(const uint64_t name_hash, esz_tiled_property_t* properties, int32_t property_count, esz_core_t* core);
 int32_t     get_integer_property(const uint64_t name_hash, esz_tiled_property_t* properties, int32_t property_count, esz_core_t* core);
+double      get_percentile(const double* sorted_sample, int32_t sample_count, int32_t percentile);
 const char* get_string_property(const uint64_t name_hash, esz_tiled_property_t*  properties, int32_t property_count, esz_core_t* core);
+uint32_t    get_texture_format(esz_window_t* window);
 bool        is_camera_at_horizontal_boundary(esz_core_t* core);
+bool        is_rect_in_viewport(const SDL_Rect* rect, int32_t margin, esz_window_t* window);
+void*       malloc_counted(size_t size);
+void*       map_file(const char* file_name, size_t* size);
 void        move_camera_to_target(esz_window_t* window, esz_core_t* core);
 void        poll_events(esz_window_t* window, esz_core_t* core);
+void*       realloc_counted(void* ptr, size_t old_size, size_t size);
 void        set_camera_boundaries_to_map_size(esz_window_t* window, esz_core_t* core);
+void        sort_samples(double* sample, int32_t sample_count);
+void        unmap_file(void* data, size_t size);
 void        update_bounding_box(esz_entity_t* entity);
 void        update_entities(esz_window_t* window, esz_core_t* core);
 
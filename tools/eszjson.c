@@ -0,0 +1,465 @@
+// SPDX-License-Identifier: MIT
+/**
+ * @file    eszjson.c
+ * @brief   eszFW map parser benchmark
+ * @details Generates synthetic Tiled maps and compares how long
+ *          cute_tiled on its own, cute_tiled behind the tile data reader
+ *          used by eszFW and, in builds with USE_LIBTMX, libTMX take to
+ *          load them.
+ *
+ *          Usage: eszjson [size]...
+ *
+ *          Each size yields a square map with two tile layers, stored
+ *          once with CSV and once with base64 encoded tile data, plus a
+ *          TMX version for libTMX.  The sizes default to 100, 500, 1000,
+ *          2000 and 4000 tiles.  The maps are written to the working
+ *          directory and removed afterwards.
+ */
+
+#define SDL_MAIN_HANDLED
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "esz_macros.h"
+
+DISABLE_WARNING_PUSH
+DISABLE_WARNING_PADDING
+DISABLE_WARNING_SPECTRE_MITIGATION
+
+#define CUTE_TILED_IMPLEMENTATION
+#include <cute_tiled.h>
+
+#ifdef USE_LIBTMX
+#include <tmx.h>
+#endif
+
+DISABLE_WARNING_POP
+
+#include "esz_json.h"
+#include "esz_types.h"
+
+#define BENCHMARK_ROUNDS 3
+#define LAYER_COUNT      2
+
+static const int32_t default_size[] = { 100, 500, 1000, 2000, 4000 };
+
+static double   benchmark_cute_tiled(const char* file_name);
+static double   benchmark_reader(const char* file_name);
+static bool     benchmark_size(int32_t size);
+static long     get_file_size(const char* file_name);
+static uint32_t get_gid(int32_t layer, int32_t index, int32_t size);
+static double   get_milliseconds(clock_t start);
+static void     print_result(const char* name, double milliseconds);
+static bool     set_tile_layer_data(cute_tiled_map_t* map, esz_tiled_json_t* json);
+static bool     write_json_map(const char* file_name, int32_t size, bool is_base64);
+
+#ifdef USE_LIBTMX
+static double   benchmark_libtmx(const char* file_name);
+static bool     write_tmx_map(const char* file_name, int32_t size);
+#endif
+
+int main(int argc, char* argv[])
+{
+    int status = EXIT_SUCCESS;
+
+    if (1 == argc)
+    {
+        for (size_t index = 0; index < sizeof(default_size) / sizeof(default_size[0]); index += 1)
+        {
+            if (! benchmark_size(default_size[index]))
+            {
+                status = EXIT_FAILURE;
+            }
+        }
+
+        return status;
+    }
+
+    for (int index = 1; index < argc; index += 1)
+    {
+        int32_t size = (int32_t)strtol(argv[index], NULL, 10);
+
+        if (0 >= size || 16384 < size)
+        {
+            fprintf(stderr, "Usage: %s [size]...\n", argv[0]);
+            return EXIT_FAILURE;
+        }
+
+        if (! benchmark_size(size))
+        {
+            status = EXIT_FAILURE;
+        }
+    }
+
+    return status;
+}
+
+// Fastest of all rounds in milliseconds, or a negative value on error.
+static double benchmark_cute_tiled(const char* file_name)
+{
+    double best = -1.0;
+
+    for (int round = 0; round < BENCHMARK_ROUNDS; round += 1)
+    {
+        clock_t           start = clock();
+        cute_tiled_map_t* map   = cute_tiled_load_map_from_file(file_name, NULL);
+        double            time  = get_milliseconds(start);
+
+        if (! map)
+        {
+            return -1.0;
+        }
+
+        cute_tiled_free_map(map);
+
+        if (0.0 > best || time < best)
+        {
+            best = time;
+        }
+    }
+
+    return best;
+}
+
+static double benchmark_reader(const char* file_name)
+{
+    double best = -1.0;
+
+    for (int round = 0; round < BENCHMARK_ROUNDS; round += 1)
+    {
+        esz_tiled_json_t  json;
+        cute_tiled_map_t* map   = NULL;
+        clock_t           start = clock();
+        double            time;
+
+        if (read_tiled_json(file_name, &json))
+        {
+            map = cute_tiled_load_map_from_memory(json.text, (int)json.text_length, NULL);
+            if (map && ! set_tile_layer_data(map, &json))
+            {
+                cute_tiled_free_map(map);
+                map = NULL;
+            }
+        }
+        free_tiled_json(&json);
+
+        time = get_milliseconds(start);
+
+        if (! map)
+        {
+            return -1.0;
+        }
+
+        cute_tiled_free_map(map);
+
+        if (0.0 > best || time < best)
+        {
+            best = time;
+        }
+    }
+
+    return best;
+}
+
+static bool benchmark_size(int32_t size)
+{
+    char csv_file_name[64]    = { 0 };
+    char base64_file_name[64] = { 0 };
+    char tmx_file_name[64]    = { 0 };
+    bool is_done              = false;
+
+    snprintf(csv_file_name,    sizeof(csv_file_name),    "eszjson_%d_csv.json",    size);
+    snprintf(base64_file_name, sizeof(base64_file_name), "eszjson_%d_base64.json", size);
+    snprintf(tmx_file_name,    sizeof(tmx_file_name),    "eszjson_%d.tmx",         size);
+
+    if (! write_json_map(csv_file_name, size, false) || ! write_json_map(base64_file_name, size, true))
+    {
+        goto exit;
+    }
+
+    printf("%dx%d, %d layers\n", size, size, LAYER_COUNT);
+
+    printf("  CSV    %8.1f MiB:", (double)get_file_size(csv_file_name) / (1024.0 * 1024.0));
+    print_result("cute_tiled", benchmark_cute_tiled(csv_file_name));
+    print_result("eszFW",      benchmark_reader(csv_file_name));
+    printf("\n");
+
+    // cute_tiled doesn't decode base64 itself.
+    printf("  base64 %8.1f MiB:", (double)get_file_size(base64_file_name) / (1024.0 * 1024.0));
+    print_result("cute_tiled", benchmark_cute_tiled(base64_file_name));
+    print_result("eszFW",      benchmark_reader(base64_file_name));
+    printf("\n");
+
+    #ifdef USE_LIBTMX
+    if (! write_tmx_map(tmx_file_name, size))
+    {
+        goto exit;
+    }
+
+    printf("  TMX    %8.1f MiB:", (double)get_file_size(tmx_file_name) / (1024.0 * 1024.0));
+    print_result("libTMX", benchmark_libtmx(tmx_file_name));
+    printf("\n");
+    #endif
+
+    is_done = true;
+
+exit:
+    remove(csv_file_name);
+    remove(base64_file_name);
+    remove(tmx_file_name);
+
+    if (! is_done)
+    {
+        fprintf(stderr, "Could not write %dx%d map.\n", size, size);
+    }
+
+    return is_done;
+}
+
+static long get_file_size(const char* file_name)
+{
+    long  size = 0;
+    FILE* fp   = fopen(file_name, "rb");
+
+    if (fp)
+    {
+        fseek(fp, 0, SEEK_END);
+        size = ftell(fp);
+        fclose(fp);
+    }
+
+    return size;
+}
+
+/* A reproducible tile layer: about 70 percent of the tiles are empty,
+ * some of the others are flipped.
+ */
+static uint32_t get_gid(int32_t layer, int32_t index, int32_t size)
+{
+    uint32_t hash = (uint32_t)(index + (layer * size * size)) * 2654435761u;
+
+    hash ^= hash >> 15;
+
+    if (7 > hash % 10)
+    {
+        return 0;
+    }
+
+    return (1 + ((hash >> 8) % 256)) | ((0 == hash % 9) ? 0x80000000u : 0);
+}
+
+static double get_milliseconds(clock_t start)
+{
+    return (double)(clock() - start) * 1000.0 / (double)CLOCKS_PER_SEC;
+}
+
+static void print_result(const char* name, double milliseconds)
+{
+    if (0.0 > milliseconds)
+    {
+        printf("  %s %10s", name, "failed");
+    }
+    else
+    {
+        printf("  %s %7.1f ms", name, milliseconds);
+    }
+}
+
+// Same as in esz_compat.c, without group layers.
+static bool set_tile_layer_data(cute_tiled_map_t* map, esz_tiled_json_t* json)
+{
+    cute_tiled_layer_t* layer = map->layers;
+    int32_t             index = 0;
+
+    while (layer)
+    {
+        if (0 == strcmp(layer->type.ptr, "tilelayer"))
+        {
+            esz_tile_data_t* tile_data;
+
+            if (index >= json->tile_data_count)
+            {
+                return false;
+            }
+
+            tile_data = &json->tile_data[index];
+            if (tile_data->gid_count != layer->width * layer->height)
+            {
+                return false;
+            }
+
+            free(layer->data);
+            layer->data        = (int*)tile_data->gid;
+            layer->data_count  = tile_data->gid_count;
+            tile_data->gid     = NULL;
+            index             += 1;
+        }
+
+        layer = layer->next;
+    }
+
+    return index == json->tile_data_count;
+}
+
+static bool write_json_map(const char* file_name, int32_t size, bool is_base64)
+{
+    static const char base64_digit[] = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+    int32_t           tile_count     = size * size;
+    bool              is_done        = true;
+    FILE*             fp             = fopen(file_name, "wb");
+
+    if (! fp)
+    {
+        return false;
+    }
+
+    fprintf(fp, "{\"height\":%d,\"infinite\":false,\"layers\":[", size);
+
+    for (int32_t layer = 0; layer < LAYER_COUNT; layer += 1)
+    {
+        fprintf(fp, "%s{\"data\":", (0 < layer) ? "," : "");
+
+        if (is_base64)
+        {
+            unsigned char bytes[3];
+            int32_t       byte_count = 0;
+
+            fputc('"', fp);
+
+            // Four bytes per GID, so only the last group can be short.
+            for (int32_t index = 0; index < tile_count * 4; index += 1)
+            {
+                uint32_t gid = get_gid(layer, index / 4, size);
+
+                bytes[byte_count]  = (unsigned char)(gid >> ((index % 4) * 8));
+                byte_count        += 1;
+
+                if (3 == byte_count || index == (tile_count * 4) - 1)
+                {
+                    uint32_t group = ((uint32_t)bytes[0] << 16) | ((1 < byte_count) ? (uint32_t)bytes[1] << 8 : 0) | ((2 < byte_count) ? bytes[2] : 0);
+
+                    fputc(base64_digit[(group >> 18) & 0x3f], fp);
+                    fputc(base64_digit[(group >> 12) & 0x3f], fp);
+                    fputc((1 < byte_count) ? base64_digit[(group >> 6) & 0x3f] : '=', fp);
+                    fputc((2 < byte_count) ? base64_digit[group & 0x3f] : '=', fp);
+
+                    byte_count = 0;
+                }
+            }
+
+            fprintf(fp, "\",\"encoding\":\"base64\"");
+        }
+        else
+        {
+            fputc('[', fp);
+
+            for (int32_t index = 0; index < tile_count; index += 1)
+            {
+                fprintf(fp, "%s%u", (0 < index) ? "," : "", get_gid(layer, index, size));
+            }
+
+            fputc(']', fp);
+        }
+
+        fprintf(
+            fp,
+            ",\"height\":%d,\"id\":%d,\"name\":\"layer_%d\",\"opacity\":1,\"type\":\"tilelayer\",\"visible\":true,\"width\":%d,\"x\":0,\"y\":0}",
+            size, layer + 1, layer + 1, size);
+    }
+
+    fprintf(
+        fp,
+        "],\"nextlayerid\":%d,\"nextobjectid\":1,\"orientation\":\"orthogonal\",\"renderorder\":\"right-down\",\"tiledversion\":\"1.4.2\","
+        "\"tileheight\":16,\"tilesets\":[{\"columns\":16,\"firstgid\":1,\"image\":\"tiles.png\",\"imageheight\":256,\"imagewidth\":256,"
+        "\"margin\":0,\"name\":\"tiles\",\"spacing\":0,\"tilecount\":256,\"tileheight\":16,\"tilewidth\":16}],"
+        "\"tilewidth\":16,\"type\":\"map\",\"version\":1.4,\"width\":%d}",
+        LAYER_COUNT + 1, size);
+
+    if (ferror(fp))
+    {
+        is_done = false;
+    }
+
+    fclose(fp);
+
+    return is_done;
+}
+
+#ifdef USE_LIBTMX
+static double benchmark_libtmx(const char* file_name)
+{
+    double best = -1.0;
+
+    for (int round = 0; round < BENCHMARK_ROUNDS; round += 1)
+    {
+        clock_t  start = clock();
+        tmx_map* map   = tmx_load(file_name);
+        double   time  = get_milliseconds(start);
+
+        if (! map)
+        {
+            return -1.0;
+        }
+
+        tmx_map_free(map);
+
+        if (0.0 > best || time < best)
+        {
+            best = time;
+        }
+    }
+
+    return best;
+}
+
+static bool write_tmx_map(const char* file_name, int32_t size)
+{
+    int32_t tile_count = size * size;
+    bool    is_done    = true;
+    FILE*   fp         = fopen(file_name, "wb");
+
+    if (! fp)
+    {
+        return false;
+    }
+
+    fprintf(
+        fp,
+        "<?xml version=\"1.0\" encoding=\"UTF-8\"?>\n"
+        "<map version=\"1.4\" tiledversion=\"1.4.2\" orientation=\"orthogonal\" renderorder=\"right-down\" "
+        "width=\"%d\" height=\"%d\" tilewidth=\"16\" tileheight=\"16\" infinite=\"0\" nextlayerid=\"%d\" nextobjectid=\"1\">\n"
+        " <tileset firstgid=\"1\" name=\"tiles\" tilewidth=\"16\" tileheight=\"16\" tilecount=\"256\" columns=\"16\">\n"
+        "  <image source=\"tiles.png\" width=\"256\" height=\"256\"/>\n"
+        " </tileset>\n",
+        size, size, LAYER_COUNT + 1);
+
+    for (int32_t layer = 0; layer < LAYER_COUNT; layer += 1)
+    {
+        fprintf(fp, " <layer id=\"%d\" name=\"layer_%d\" width=\"%d\" height=\"%d\">\n  <data encoding=\"csv\">\n", layer + 1, layer + 1, size, size);
+
+        for (int32_t index = 0; index < tile_count; index += 1)
+        {
+            fprintf(fp, "%s%u", (0 < index) ? "," : "", get_gid(layer, index, size));
+        }
+
+        fprintf(fp, "\n</data>\n </layer>\n");
+    }
+
+    fprintf(fp, "</map>\n");
+
+    if (ferror(fp))
+    {
+        is_done = false;
+    }
+
+    fclose(fp);
+
+    return is_done;
+}
+#endif
@@ -0,0 +1,803 @@
+// SPDX-License-Identifier: MIT
+/**
+ * @file    eszmap.c
+ * @brief   eszFW map compiler
+ * @details Converts a Tiled JSON map into a binary map that eszFW can
+ *          map into memory and use without parsing it.
+ *
+ *          Usage: eszmap <map.json> <map.eszmap>
+ *
+ *          The output must be generated by a build of this tool that
+ *          matches the target's pointer size and cute_tiled version.
+ */
+
+#define SDL_MAIN_HANDLED
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "esz_macros.h"
+
+DISABLE_WARNING_PUSH
+DISABLE_WARNING_PADDING
+DISABLE_WARNING_SPECTRE_MITIGATION
+
+#define CUTE_TILED_IMPLEMENTATION
+#include <cute_tiled.h>
+
+DISABLE_WARNING_POP
+
+#include "esz_hash.h"
+#include "esz_mapfile.h"
+#include "esz_types.h"
+
+typedef struct interned_string
+{
+    const char* ptr;
+    size_t      offset;
+
+} interned_string_t;
+
+typedef struct writer
+{
+    unsigned char*     data;
+    uint64_t*          relocation;
+    interned_string_t* string;
+    size_t             size;
+    size_t             capacity;
+    size_t             relocation_count;
+    size_t             relocation_capacity;
+    size_t             string_count;
+    size_t             string_capacity;
+
+} writer_t;
+
+static cute_tiled_property_t* find_property(uint64_t name_hash, CUTE_TILED_PROPERTY_TYPE type, cute_tiled_property_t* property, int count);
+static bool                   get_boolean_property(uint64_t name_hash, cute_tiled_property_t* property, int count);
+static double                 get_decimal_property(uint64_t name_hash, cute_tiled_property_t* property, int count);
+static int32_t                get_integer_property(uint64_t name_hash, cute_tiled_property_t* property, int count);
+static size_t                 reserve(size_t size, writer_t* writer);
+static void                   set_pointer(size_t field, size_t target, writer_t* writer);
+static size_t                 write_entities(cute_tiled_map_t* map, int32_t* count, writer_t* writer);
+static size_t                 write_frames(cute_tiled_frame_t* frame, int count, writer_t* writer);
+static size_t                 write_layers(cute_tiled_layer_t* layer, writer_t* writer);
+static size_t                 write_map(cute_tiled_map_t* map, writer_t* writer);
+static size_t                 write_objects(cute_tiled_object_t* object, writer_t* writer);
+static size_t                 write_properties(cute_tiled_property_t* property, int count, writer_t* writer);
+static size_t                 write_string(const char* string, writer_t* writer);
+static size_t                 write_tile_flags(cute_tiled_map_t* map, int32_t* count, writer_t* writer);
+static size_t                 write_tiles(cute_tiled_tile_descriptor_t* tile, writer_t* writer);
+static size_t                 write_tilesets(cute_tiled_tileset_t* tileset, writer_t* writer);
+
+int main(int argc, char* argv[])
+{
+    writer_t               writer   = { 0 };
+    const size_t           layout[] = MAP_FILE_LAYOUT;
+    esz_map_file_header_t  header   = { 0 };
+    cute_tiled_map_t*      map;
+    FILE*                  fp;
+    size_t                 relocation_offset;
+    int                    status = EXIT_SUCCESS;
+
+    if (3 != argc)
+    {
+        fprintf(stderr, "Usage: %s <map.json> <map%s>\n", argv[0], MAP_FILE_EXTENSION);
+        return EXIT_FAILURE;
+    }
+
+    map = cute_tiled_load_map_from_file(argv[1], NULL);
+    if (! map)
+    {
+        fprintf(stderr, "%s: %s.\n", argv[1], cute_tiled_error_reason);
+        return EXIT_FAILURE;
+    }
+
+    // The header comes first, so offset 0 can stand for NULL.
+    reserve(sizeof(esz_map_file_header_t), &writer);
+
+    header.map_offset       = write_map(map, &writer);
+    header.tile_flag_offset = write_tile_flags(map, &header.tile_flag_count, &writer);
+    header.entity_offset    = write_entities(map, &header.entity_count, &writer);
+
+    relocation_offset = reserve(writer.relocation_count * sizeof(uint64_t), &writer);
+    memcpy(writer.data + relocation_offset, writer.relocation, writer.relocation_count * sizeof(uint64_t));
+
+    memcpy(header.magic, MAP_FILE_MAGIC, 8);
+    header.version           = MAP_FILE_VERSION;
+    header.pointer_size      = sizeof(void*);
+    header.layout            = generate_data_hash(layout, sizeof(layout));
+    header.file_size         = writer.size;
+    header.relocation_offset = relocation_offset;
+    header.relocation_count  = writer.relocation_count;
+    memcpy(writer.data, &header, sizeof(header));
+
+    fp = fopen(argv[2], "wb");
+    if (! fp || 1 != fwrite(writer.data, writer.size, 1, fp))
+    {
+        fprintf(stderr, "Could not write %s.\n", argv[2]);
+        status = EXIT_FAILURE;
+    }
+    else
+    {
+        printf(
+            "%s: %zu bytes, %zu relocations, %d tile flags, %d entities.\n",
+            argv[2],
+            writer.size,
+            writer.relocation_count,
+            header.tile_flag_count,
+            header.entity_count);
+    }
+
+    if (fp)
+    {
+        fclose(fp);
+    }
+
+    cute_tiled_free_map(map);
+    free(writer.data);
+    free(writer.relocation);
+    free(writer.string);
+
+    return status;
+}
+
+static cute_tiled_property_t* find_property(uint64_t name_hash, CUTE_TILED_PROPERTY_TYPE type, cute_tiled_property_t* property, int count)
+{
+    for (int index = 0; property && index < count; index += 1)
+    {
+        if (type == property[index].type && name_hash == generate_hash((const unsigned char*)property[index].name.ptr))
+        {
+            return &property[index];
+        }
+    }
+
+    return NULL;
+}
+
+static bool get_boolean_property(uint64_t name_hash, cute_tiled_property_t* property, int count)
+{
+    property = find_property(name_hash, CUTE_TILED_PROPERTY_BOOL, property, count);
+    return property ? (bool)property->data.boolean : false;
+}
+
+static double get_decimal_property(uint64_t name_hash, cute_tiled_property_t* property, int count)
+{
+    property = find_property(name_hash, CUTE_TILED_PROPERTY_FLOAT, property, count);
+    return property ? (double)property->data.floating : 0.0;
+}
+
+static int32_t get_integer_property(uint64_t name_hash, cute_tiled_property_t* property, int count)
+{
+    property = find_property(name_hash, CUTE_TILED_PROPERTY_INT, property, count);
+    return property ? (int32_t)property->data.integer : 0;
+}
+
+static size_t reserve(size_t size, writer_t* writer)
+{
+    size_t offset = (writer->size + (MAP_FILE_ALIGNMENT - 1)) & ~(size_t)(MAP_FILE_ALIGNMENT - 1);
+
+    if (offset + size > writer->capacity)
+    {
+        size_t         capacity = writer->capacity ? writer->capacity : 4096;
+        unsigned char* data;
+
+        while (offset + size > capacity)
+        {
+            capacity *= 2;
+        }
+
+        data = (unsigned char*)realloc(writer->data, capacity);
+        if (! data)
+        {
+            fprintf(stderr, "Error allocating memory.\n");
+            exit(EXIT_FAILURE);
+        }
+
+        memset(data + writer->capacity, 0, capacity - writer->capacity);
+        writer->data     = data;
+        writer->capacity = capacity;
+    }
+
+    writer->size = offset + size;
+    return offset;
+}
+
+/* Stores the offset of target in the pointer at field and records the
+ * field in the relocation table.
+ */
+static void set_pointer(size_t field, size_t target, writer_t* writer)
+{
+    uintptr_t value = (uintptr_t)target;
+
+    if (0 == target)
+    {
+        return;
+    }
+
+    memcpy(writer->data + field, &value, sizeof(value));
+
+    if (writer->relocation_count == writer->relocation_capacity)
+    {
+        size_t    capacity   = writer->relocation_capacity ? writer->relocation_capacity * 2 : 256;
+        uint64_t* relocation = (uint64_t*)realloc(writer->relocation, capacity * sizeof(uint64_t));
+
+        if (! relocation)
+        {
+            fprintf(stderr, "Error allocating memory.\n");
+            exit(EXIT_FAILURE);
+        }
+
+        writer->relocation          = relocation;
+        writer->relocation_capacity = capacity;
+    }
+
+    writer->relocation[writer->relocation_count] = field;
+    writer->relocation_count += 1;
+}
+
+/* Resolves the entities the way load_entities() does it, so that the
+ * engine can create them without looking up a single property.
+ */
+static size_t write_entities(cute_tiled_map_t* map, int32_t* count, writer_t* writer)
+{
+    size_t offset;
+    size_t entry = 0;
+
+    *count = 0;
+    for (cute_tiled_layer_t* layer = map->layers; layer; layer = layer->next)
+    {
+        if (layer->type.ptr && H_objectgroup == generate_hash((const unsigned char*)layer->type.ptr))
+        {
+            for (cute_tiled_object_t* object = layer->objects; object; object = object->next)
+            {
+                *count += 1;
+            }
+        }
+    }
+
+    if (0 == *count)
+    {
+        return 0;
+    }
+
+    offset = reserve((size_t)*count * sizeof(esz_entity_entry_t), writer);
+
+    for (cute_tiled_layer_t* layer = map->layers; layer; layer = layer->next)
+    {
+        if (! layer->type.ptr || H_objectgroup != generate_hash((const unsigned char*)layer->type.ptr))
+        {
+            continue;
+        }
+
+        for (cute_tiled_object_t* object = layer->objects; object; object = object->next)
+        {
+            esz_entity_entry_t     out        = { 0 };
+            cute_tiled_property_t* properties = object->properties;
+            int                    prop_cnt   = object->property_count;
+            char                   property_name[26];
+
+            out.id          = object->id;
+            out.pos_x       = (double)object->x;
+            out.pos_y       = (double)object->y;
+            out.name_offset = write_string(object->name.ptr, writer);
+            out.type_hash   = object->type.ptr ? generate_hash((const unsigned char*)object->type.ptr) : 0;
+
+            if (H_actor == out.type_hash)
+            {
+                out.acceleration                = get_decimal_property(H_acceleration, properties, prop_cnt);
+                out.jumping_power               = get_decimal_property(H_jumping_power, properties, prop_cnt);
+                out.max_velocity_x              = get_decimal_property(H_max_velocity_x, properties, prop_cnt);
+                out.sprite_sheet_id             = get_integer_property(H_sprite_sheet_id, properties, prop_cnt);
+                out.connect_horizontal_map_ends = get_boolean_property(H_connect_horizontal_map_ends, properties, prop_cnt);
+                out.connect_vertical_map_ends   = get_boolean_property(H_connect_vertical_map_ends, properties, prop_cnt);
+                out.is_player                   = get_boolean_property(H_is_player, properties, prop_cnt);
+
+                if (get_boolean_property(H_is_affected_by_gravity, properties, prop_cnt))
+                {
+                    SET_STATE(out.state, STATE_GRAVITATIONAL);
+                }
+                else
+                {
+                    SET_STATE(out.state, STATE_FLOATING);
+                }
+
+                if (get_boolean_property(H_is_animated, properties, prop_cnt))
+                {
+                    SET_STATE(out.state, STATE_ANIMATED);
+                }
+
+                if (get_boolean_property(H_is_in_midground, properties, prop_cnt))
+                {
+                    SET_STATE(out.state, STATE_IN_MIDGROUND);
+                }
+                else if (get_boolean_property(H_is_in_background, properties, prop_cnt))
+                {
+                    SET_STATE(out.state, STATE_IN_BACKGROUND);
+                }
+                else
+                {
+                    SET_STATE(out.state, STATE_IN_FOREGROUND);
+                }
+
+                if (get_boolean_property(H_is_left_oriented, properties, prop_cnt))
+                {
+                    SET_STATE(out.state, STATE_GOING_LEFT);
+                    SET_STATE(out.state, STATE_LOOKING_LEFT);
+                }
+                else
+                {
+                    SET_STATE(out.state, STATE_GOING_RIGHT);
+                    SET_STATE(out.state, STATE_LOOKING_RIGHT);
+                }
+
+                if (get_boolean_property(H_is_moving, properties, prop_cnt))
+                {
+                    SET_STATE(out.state, STATE_MOVING);
+                }
+
+                if (IS_STATE_SET(out.state, STATE_ANIMATED))
+                {
+                    for (;;)
+                    {
+                        snprintf(property_name, sizeof(property_name), "animation_%d", out.animation_count + 1);
+                        if (! get_boolean_property(generate_hash((const unsigned char*)property_name), properties, prop_cnt))
+                        {
+                            break;
+                        }
+                        out.animation_count += 1;
+                    }
+                }
+
+                if (0 < out.animation_count)
+                {
+                    out.animation_offset = reserve((size_t)out.animation_count * sizeof(esz_animation_t), writer);
+
+                    for (int32_t index = 0; index < out.animation_count; index += 1)
+                    {
+                        esz_animation_t animation = { 0 };
+
+                        snprintf(property_name, sizeof(property_name), "animation_%d_first_frame", index + 1);
+                        animation.first_frame = get_integer_property(generate_hash((const unsigned char*)property_name), properties, prop_cnt);
+
+                        if (0 == animation.first_frame)
+                        {
+                            animation.first_frame = 1;
+                        }
+
+                        snprintf(property_name, sizeof(property_name), "animation_%d_fps", index + 1);
+                        animation.fps = get_integer_property(generate_hash((const unsigned char*)property_name), properties, prop_cnt);
+
+                        snprintf(property_name, sizeof(property_name), "animation_%d_length", index + 1);
+                        animation.length = get_integer_property(generate_hash((const unsigned char*)property_name), properties, prop_cnt);
+
+                        snprintf(property_name, sizeof(property_name), "animation_%d_offset_y", index + 1);
+                        animation.offset_y = get_integer_property(generate_hash((const unsigned char*)property_name), properties, prop_cnt);
+
+                        memcpy(writer->data + out.animation_offset + ((size_t)index * sizeof(esz_animation_t)), &animation, sizeof(animation));
+                    }
+                }
+            }
+
+            out.width  = get_integer_property(H_width, properties, prop_cnt);
+            out.height = get_integer_property(H_height, properties, prop_cnt);
+
+            if (0 >= out.width && map->tilesets)
+            {
+                out.width = map->tilesets->tilewidth;
+            }
+
+            if (0 >= out.height && map->tilesets)
+            {
+                out.height = map->tilesets->tileheight;
+            }
+
+            memcpy(writer->data + offset + (entry * sizeof(esz_entity_entry_t)), &out, sizeof(out));
+            entry += 1;
+        }
+    }
+
+    return offset;
+}
+
+static size_t write_frames(cute_tiled_frame_t* frame, int count, writer_t* writer)
+{
+    size_t offset;
+
+    if (! frame || 0 >= count)
+    {
+        return 0;
+    }
+
+    offset = reserve((size_t)count * sizeof(cute_tiled_frame_t), writer);
+    memcpy(writer->data + offset, frame, (size_t)count * sizeof(cute_tiled_frame_t));
+
+    return offset;
+}
+
+static size_t write_layers(cute_tiled_layer_t* layer, writer_t* writer)
+{
+    size_t first    = 0;
+    size_t previous = 0;
+
+    while (layer)
+    {
+        cute_tiled_layer_t out    = { 0 };
+        size_t             offset = reserve(sizeof(cute_tiled_layer_t), writer);
+        size_t             data   = 0;
+
+        out.data_count     = layer->data_count;
+        out.height         = layer->height;
+        out.offsetx        = layer->offsetx;
+        out.offsety        = layer->offsety;
+        out.opacity        = layer->opacity;
+        out.property_count = layer->property_count;
+        out.visible        = layer->visible;
+        out.width          = layer->width;
+        out.x              = layer->x;
+        out.y              = layer->y;
+        out.id             = layer->id;
+        memcpy(writer->data + offset, &out, sizeof(out));
+
+        if (layer->data && 0 < layer->data_count)
+        {
+            data = reserve((size_t)layer->data_count * sizeof(int), writer);
+            memcpy(writer->data + data, layer->data, (size_t)layer->data_count * sizeof(int));
+        }
+
+        set_pointer(offset + offsetof(cute_tiled_layer_t, data),       data,                                                          writer);
+        set_pointer(offset + offsetof(cute_tiled_layer_t, draworder),  write_string(layer->draworder.ptr, writer),                    writer);
+        set_pointer(offset + offsetof(cute_tiled_layer_t, image),      write_string(layer->image.ptr, writer),                        writer);
+        set_pointer(offset + offsetof(cute_tiled_layer_t, layers),     write_layers(layer->layers, writer),                           writer);
+        set_pointer(offset + offsetof(cute_tiled_layer_t, name),       write_string(layer->name.ptr, writer),                         writer);
+        set_pointer(offset + offsetof(cute_tiled_layer_t, objects),    write_objects(layer->objects, writer),                         writer);
+        set_pointer(offset + offsetof(cute_tiled_layer_t, properties), write_properties(layer->properties, layer->property_count, writer), writer);
+        set_pointer(offset + offsetof(cute_tiled_layer_t, type),       write_string(layer->type.ptr, writer),                         writer);
+
+        if (previous)
+        {
+            set_pointer(previous + offsetof(cute_tiled_layer_t, next), offset, writer);
+        }
+        else
+        {
+            first = offset;
+        }
+
+        previous = offset;
+        layer    = layer->next;
+    }
+
+    return first;
+}
+
+static size_t write_map(cute_tiled_map_t* map, writer_t* writer)
+{
+    cute_tiled_map_t out    = { 0 };
+    size_t           offset = reserve(sizeof(cute_tiled_map_t), writer);
+
+    out.backgroundcolor = map->backgroundcolor;
+    out.height          = map->height;
+    out.infinite        = map->infinite;
+    out.nextobjectid    = map->nextobjectid;
+    out.property_count  = map->property_count;
+    out.tileheight      = map->tileheight;
+    out.tilewidth       = map->tilewidth;
+    out.version         = map->version;
+    out.width           = map->width;
+    out.nextlayerid     = map->nextlayerid;
+    memcpy(writer->data + offset, &out, sizeof(out));
+
+    set_pointer(offset + offsetof(cute_tiled_map_t, layers),       write_layers(map->layers, writer),                                writer);
+    set_pointer(offset + offsetof(cute_tiled_map_t, orientation),  write_string(map->orientation.ptr, writer),                       writer);
+    set_pointer(offset + offsetof(cute_tiled_map_t, properties),   write_properties(map->properties, map->property_count, writer),   writer);
+    set_pointer(offset + offsetof(cute_tiled_map_t, renderorder),  write_string(map->renderorder.ptr, writer),                       writer);
+    set_pointer(offset + offsetof(cute_tiled_map_t, tilesets),     write_tilesets(map->tilesets, writer),                            writer);
+    set_pointer(offset + offsetof(cute_tiled_map_t, tiledversion), write_string(map->tiledversion.ptr, writer),                      writer);
+    set_pointer(offset + offsetof(cute_tiled_map_t, type),         write_string(map->type.ptr, writer),                              writer);
+
+    return offset;
+}
+
+static size_t write_objects(cute_tiled_object_t* object, writer_t* writer)
+{
+    size_t first    = 0;
+    size_t previous = 0;
+
+    while (object)
+    {
+        cute_tiled_object_t out      = { 0 };
+        size_t              offset   = reserve(sizeof(cute_tiled_object_t), writer);
+        size_t              vertices = 0;
+
+        out.ellipse        = object->ellipse;
+        out.gid            = object->gid;
+        out.height         = object->height;
+        out.id             = object->id;
+        out.point          = object->point;
+        out.vert_count     = object->vert_count;
+        out.vert_type      = object->vert_type;
+        out.property_count = object->property_count;
+        out.rotation       = object->rotation;
+        out.visible        = object->visible;
+        out.width          = object->width;
+        out.x              = object->x;
+        out.y              = object->y;
+        memcpy(writer->data + offset, &out, sizeof(out));
+
+        if (object->vertices && 0 < object->vert_count)
+        {
+            vertices = reserve((size_t)object->vert_count * 2 * sizeof(float), writer);
+            memcpy(writer->data + vertices, object->vertices, (size_t)object->vert_count * 2 * sizeof(float));
+        }
+
+        set_pointer(offset + offsetof(cute_tiled_object_t, name),       write_string(object->name.ptr, writer),                                writer);
+        set_pointer(offset + offsetof(cute_tiled_object_t, properties), write_properties(object->properties, object->property_count, writer),   writer);
+        set_pointer(offset + offsetof(cute_tiled_object_t, type),       write_string(object->type.ptr, writer),                                writer);
+        set_pointer(offset + offsetof(cute_tiled_object_t, vertices),   vertices,                                                              writer);
+
+        if (previous)
+        {
+            set_pointer(previous + offsetof(cute_tiled_object_t, next), offset, writer);
+        }
+        else
+        {
+            first = offset;
+        }
+
+        previous = offset;
+        object   = object->next;
+    }
+
+    return first;
+}
+
+static size_t write_properties(cute_tiled_property_t* property, int count, writer_t* writer)
+{
+    size_t offset;
+
+    if (! property || 0 >= count)
+    {
+        return 0;
+    }
+
+    offset = reserve((size_t)count * sizeof(cute_tiled_property_t), writer);
+
+    for (int index = 0; index < count; index += 1)
+    {
+        cute_tiled_property_t out   = { 0 };
+        size_t                field = offset + ((size_t)index * sizeof(cute_tiled_property_t));
+
+        out.type = property[index].type;
+
+        switch (property[index].type)
+        {
+            case CUTE_TILED_PROPERTY_STRING:
+            case CUTE_TILED_PROPERTY_FILE:
+                break;
+            default:
+                out.data = property[index].data;
+                break;
+        }
+        memcpy(writer->data + field, &out, sizeof(out));
+
+        if (CUTE_TILED_PROPERTY_STRING == property[index].type || CUTE_TILED_PROPERTY_FILE == property[index].type)
+        {
+            set_pointer(field + offsetof(cute_tiled_property_t, data), write_string(property[index].data.string.ptr, writer), writer);
+        }
+
+        set_pointer(field + offsetof(cute_tiled_property_t, name), write_string(property[index].name.ptr, writer), writer);
+    }
+
+    return offset;
+}
+
+/* Strings are interned like cute_tiled does it: equal strings share one
+ * copy, so comparing the hash_id of two strings remains valid.
+ */
+static size_t write_string(const char* string, writer_t* writer)
+{
+    size_t length;
+    size_t offset;
+
+    if (! string)
+    {
+        return 0;
+    }
+
+    for (size_t index = 0; index < writer->string_count; index += 1)
+    {
+        if (0 == strcmp(writer->string[index].ptr, string))
+        {
+            return writer->string[index].offset;
+        }
+    }
+
+    length = strlen(string) + 1;
+    offset = reserve(length, writer);
+    memcpy(writer->data + offset, string, length);
+
+    if (writer->string_count == writer->string_capacity)
+    {
+        size_t             capacity = writer->string_capacity ? writer->string_capacity * 2 : 64;
+        interned_string_t* interned = (interned_string_t*)realloc(writer->string, capacity * sizeof(interned_string_t));
+
+        if (! interned)
+        {
+            fprintf(stderr, "Error allocating memory.\n");
+            exit(EXIT_FAILURE);
+        }
+
+        writer->string          = interned;
+        writer->string_capacity = capacity;
+    }
+
+    writer->string[writer->string_count].ptr    = string;
+    writer->string[writer->string_count].offset = offset;
+    writer->string_count += 1;
+
+    return offset;
+}
+
+/* Resolves the collision properties of every tile, indexed by gid.
+ */
+static size_t write_tile_flags(cute_tiled_map_t* map, int32_t* count, writer_t* writer)
+{
+    cute_tiled_tileset_t* tileset = map->tilesets;
+    uint32_t*             flag;
+    size_t                offset;
+
+    *count = 1;
+    while (tileset)
+    {
+        if (tileset->firstgid + tileset->tilecount > *count)
+        {
+            *count = tileset->firstgid + tileset->tilecount;
+        }
+        tileset = tileset->next;
+    }
+
+    offset = reserve((size_t)*count * sizeof(uint32_t), writer);
+
+    for (tileset = map->tilesets; tileset; tileset = tileset->next)
+    {
+        for (cute_tiled_tile_descriptor_t* tile = tileset->tiles; tile; tile = tile->next)
+        {
+            int32_t gid = tileset->firstgid + tile->tile_index;
+
+            if (gid >= *count)
+            {
+                continue;
+            }
+
+            flag = (uint32_t*)(writer->data + offset) + gid;
+
+            for (int index = 0; index < tile->property_count; index += 1)
+            {
+                cute_tiled_property_t* property = &tile->properties[index];
+                uint64_t               hash;
+
+                if (CUTE_TILED_PROPERTY_BOOL != property->type || ! property->data.boolean)
+                {
+                    continue;
+                }
+
+                hash = generate_hash((const unsigned char*)property->name.ptr);
+
+                switch (hash)
+                {
+                    case H_climbable:
+                        SET_STATE(*flag, TILE_CLIMBABLE);
+                        break;
+                    case H_solid_above:
+                        SET_STATE(*flag, TILE_SOLID_ABOVE);
+                        break;
+                    case H_solid_below:
+                        SET_STATE(*flag, TILE_SOLID_BELOW);
+                        break;
+                    case H_solid_left:
+                        SET_STATE(*flag, TILE_SOLID_LEFT);
+                        break;
+                    case H_solid_right:
+                        SET_STATE(*flag, TILE_SOLID_RIGHT);
+                        break;
+                    default:
+                        break;
+                }
+            }
+        }
+    }
+
+    return offset;
+}
+
+static size_t write_tiles(cute_tiled_tile_descriptor_t* tile, writer_t* writer)
+{
+    size_t first    = 0;
+    size_t previous = 0;
+
+    while (tile)
+    {
+        cute_tiled_tile_descriptor_t out    = { 0 };
+        size_t                       offset = reserve(sizeof(cute_tiled_tile_descriptor_t), writer);
+
+        out.tile_index     = tile->tile_index;
+        out.frame_count    = tile->frame_count;
+        out.imageheight    = tile->imageheight;
+        out.imagewidth     = tile->imagewidth;
+        out.property_count = tile->property_count;
+        out.probability    = tile->probability;
+        memcpy(writer->data + offset, &out, sizeof(out));
+
+        set_pointer(offset + offsetof(cute_tiled_tile_descriptor_t, animation),   write_frames(tile->animation, tile->frame_count, writer),       writer);
+        set_pointer(offset + offsetof(cute_tiled_tile_descriptor_t, image),       write_string(tile->image.ptr, writer),                           writer);
+        set_pointer(offset + offsetof(cute_tiled_tile_descriptor_t, objectgroup), write_layers(tile->objectgroup, writer),                         writer);
+        set_pointer(offset + offsetof(cute_tiled_tile_descriptor_t, properties),  write_properties(tile->properties, tile->property_count, writer), writer);
+
+        if (previous)
+        {
+            set_pointer(previous + offsetof(cute_tiled_tile_descriptor_t, next), offset, writer);
+        }
+        else
+        {
+            first = offset;
+        }
+
+        previous = offset;
+        tile     = tile->next;
+    }
+
+    return first;
+}
+
+static size_t write_tilesets(cute_tiled_tileset_t* tileset, writer_t* writer)
+{
+    size_t first    = 0;
+    size_t previous = 0;
+
+    while (tileset)
+    {
+        cute_tiled_tileset_t out    = { 0 };
+        size_t               offset = reserve(sizeof(cute_tiled_tileset_t), writer);
+
+        out.backgroundcolor  = tileset->backgroundcolor;
+        out.columns          = tileset->columns;
+        out.firstgid         = tileset->firstgid;
+        out.imageheight      = tileset->imageheight;
+        out.imagewidth       = tileset->imagewidth;
+        out.margin           = tileset->margin;
+        out.property_count   = tileset->property_count;
+        out.spacing          = tileset->spacing;
+        out.tilecount        = tileset->tilecount;
+        out.tileheight       = tileset->tileheight;
+        out.tileoffset_x     = tileset->tileoffset_x;
+        out.tileoffset_y     = tileset->tileoffset_y;
+        out.tilewidth        = tileset->tilewidth;
+        out.transparentcolor = tileset->transparentcolor;
+        memcpy(writer->data + offset, &out, sizeof(out));
+
+        set_pointer(offset + offsetof(cute_tiled_tileset_t, image),        write_string(tileset->image.ptr, writer),                                writer);
+        set_pointer(offset + offsetof(cute_tiled_tileset_t, name),         write_string(tileset->name.ptr, writer),                                 writer);
+        set_pointer(offset + offsetof(cute_tiled_tileset_t, properties),   write_properties(tileset->properties, tileset->property_count, writer),  writer);
+        set_pointer(offset + offsetof(cute_tiled_tileset_t, tiledversion), write_string(tileset->tiledversion.ptr, writer),                         writer);
+        set_pointer(offset + offsetof(cute_tiled_tileset_t, tiles),        write_tiles(tileset->tiles, writer),                                     writer);
+        set_pointer(offset + offsetof(cute_tiled_tileset_t, type),         write_string(tileset->type.ptr, writer),                                 writer);
+        set_pointer(offset + offsetof(cute_tiled_tileset_t, source),       write_string(tileset->source.ptr, writer),                               writer);
+
+        if (previous)
+        {
+            set_pointer(previous + offsetof(cute_tiled_tileset_t, next), offset, writer);
+        }
+        else
+        {
+            first = offset;
+        }
+
+        previous = offset;
+        tileset  = tileset->next;
+    }
+
+    return first;
+}
@@ -0,0 +1,221 @@
+// SPDX-License-Identifier: MIT
+/**
+ * @file    eszpack.c
+ * @brief   eszFW asset packer
+ * @details Bundles assets into a single asset pack that eszFW maps into
+ *          memory at startup.
+ *
+ *          Usage: eszpack <assets.eszpack> <file>...
+ *
+ *          Files are indexed by their path as given on the command
+ *          line, so the tool should be run from the directory the game
+ *          is started from.
+ */
+
+#define SDL_MAIN_HANDLED
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "esz_macros.h"
+
+#include "esz_hash.h"
+#include "esz_pack.h"
+#include "esz_types.h"
+
+#define PACK_ALIGNMENT 8
+
+typedef struct pack_file
+{
+    char                   path[ASSET_PATH_MAX];
+    const char*            file_name;
+    esz_asset_pack_entry_t entry;
+
+} pack_file_t;
+
+static int    compare_pack_files(const void* a, const void* b);
+static size_t pad_to_alignment(size_t offset, FILE* fp);
+static size_t write_file(const char* file_name, FILE* fp);
+
+int main(int argc, char* argv[])
+{
+    esz_asset_pack_header_t header = { 0 };
+    pack_file_t*            file;
+    FILE*                   fp;
+    size_t                  offset;
+    int                     file_count = argc - 2;
+    int                     status     = EXIT_SUCCESS;
+
+    if (3 > argc)
+    {
+        fprintf(stderr, "Usage: %s <assets.eszpack> <file>...\n", argv[0]);
+        return EXIT_FAILURE;
+    }
+
+    file = (pack_file_t*)calloc((size_t)file_count, sizeof(pack_file_t));
+    if (! file)
+    {
+        fprintf(stderr, "Error allocating memory.\n");
+        return EXIT_FAILURE;
+    }
+
+    for (int index = 0; index < file_count; index += 1)
+    {
+        const char* path = normalise_asset_path(argv[index + 2], file[index].path, sizeof(file[index].path));
+
+        if (path != file[index].path)
+        {
+            fprintf(stderr, "%s: path too long.\n", argv[index + 2]);
+            free(file);
+            return EXIT_FAILURE;
+        }
+
+        file[index].file_name  = argv[index + 2];
+        file[index].entry.hash = generate_hash((const unsigned char*)path);
+    }
+
+    // The index is sorted by hash, so assets can be found by bisection.
+    qsort(file, (size_t)file_count, sizeof(pack_file_t), compare_pack_files);
+
+    for (int index = 1; index < file_count; index += 1)
+    {
+        if (file[index].entry.hash == file[index - 1].entry.hash)
+        {
+            fprintf(stderr, "%s and %s share the same hash.\n", file[index - 1].file_name, file[index].file_name);
+            free(file);
+            return EXIT_FAILURE;
+        }
+    }
+
+    fp = fopen(argv[1], "wb");
+    if (! fp)
+    {
+        fprintf(stderr, "Could not open %s.\n", argv[1]);
+        free(file);
+        return EXIT_FAILURE;
+    }
+
+    memcpy(header.magic, ASSET_PACK_MAGIC, 8);
+    header.version     = ASSET_PACK_VERSION;
+    header.entry_count = (uint32_t)file_count;
+
+    // Header and index are written once the offsets are known.
+    offset = sizeof(esz_asset_pack_header_t) + ((size_t)file_count * sizeof(esz_asset_pack_entry_t));
+    fseek(fp, (long)offset, SEEK_SET);
+
+    for (int index = 0; index < file_count; index += 1)
+    {
+        size_t size;
+
+        offset = pad_to_alignment(offset, fp);
+        size   = write_file(file[index].file_name, fp);
+        if (0 == size)
+        {
+            status = EXIT_FAILURE;
+            goto exit;
+        }
+
+        file[index].entry.offset = offset;
+        file[index].entry.size   = size;
+        offset += size;
+    }
+
+    // The normalised paths let the engine tell a hash collision from a match.
+    for (int index = 0; index < file_count; index += 1)
+    {
+        size_t length = strlen(file[index].path) + 1;
+
+        if (length != fwrite(file[index].path, 1, length, fp))
+        {
+            status = EXIT_FAILURE;
+            goto exit;
+        }
+
+        file[index].entry.path_offset = offset;
+        offset += length;
+    }
+
+    fseek(fp, 0, SEEK_SET);
+    if (1 != fwrite(&header, sizeof(header), 1, fp))
+    {
+        status = EXIT_FAILURE;
+        goto exit;
+    }
+
+    for (int index = 0; index < file_count; index += 1)
+    {
+        if (1 != fwrite(&file[index].entry, sizeof(esz_asset_pack_entry_t), 1, fp))
+        {
+            status = EXIT_FAILURE;
+            goto exit;
+        }
+    }
+
+    printf("%s: %zu bytes, %d asset(s).\n", argv[1], offset, file_count);
+
+exit:
+    if (EXIT_SUCCESS != status)
+    {
+        fprintf(stderr, "Could not write %s.\n", argv[1]);
+    }
+
+    fclose(fp);
+    free(file);
+
+    return status;
+}
+
+static int compare_pack_files(const void* a, const void* b)
+{
+    uint64_t hash_a = ((const pack_file_t*)a)->entry.hash;
+    uint64_t hash_b = ((const pack_file_t*)b)->entry.hash;
+
+    return (hash_a > hash_b) - (hash_a < hash_b);
+}
+
+static size_t pad_to_alignment(size_t offset, FILE* fp)
+{
+    while (0 != offset % PACK_ALIGNMENT)
+    {
+        fputc(0, fp);
+        offset += 1;
+    }
+
+    return offset;
+}
+
+static size_t write_file(const char* file_name, FILE* fp)
+{
+    unsigned char buffer[4096];
+    size_t        size = 0;
+    size_t        read;
+    FILE*         input;
+
+    input = fopen(file_name, "rb");
+    if (! input)
+    {
+        fprintf(stderr, "Could not open %s.\n", file_name);
+        return 0;
+    }
+
+    while (0 < (read = fread(buffer, 1, sizeof(buffer), input)))
+    {
+        if (read != fwrite(buffer, 1, read, fp))
+        {
+            size = 0;
+            break;
+        }
+        size += read;
+    }
+
+    if (0 == size)
+    {
+        fprintf(stderr, "Could not read %s.\n", file_name);
+    }
+
+    fclose(input);
+    return size;
+}
@@ -0,0 +1,266 @@
+// SPDX-License-Identifier: MIT
+/**
+ * @file    eszqoi.c
+ * @brief   eszFW image converter
+ * @details Converts images to QOI, which eszFW decodes several times
+ *          faster than PNG.
+ *
+ *          Usage: eszqoi <image>...
+ *                 eszqoi -b <image>...
+ *
+ *          Each image is written next to the original with its file
+ *          extension replaced by .qoi; maps have to reference the new
+ *          files.  With -b, nothing is written: every image is decoded
+ *          from memory as PNG and as QOI instead and the throughput of
+ *          both decoders is compared, e.g. on demo/res/.
+ */
+
+#define SDL_MAIN_HANDLED
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "esz_macros.h"
+
+DISABLE_WARNING_PUSH
+DISABLE_WARNING_PADDING
+DISABLE_WARNING_SPECTRE_MITIGATION
+
+#define STB_IMAGE_IMPLEMENTATION
+#include <stb_image.h>
+#include <cwalk.h>
+
+DISABLE_WARNING_POP
+
+#include "esz_qoi.h"
+
+#define BENCHMARK_ROUNDS 20
+
+static bool           benchmark_image(const char* file_name);
+static bool           convert_image(const char* file_name);
+static double         get_throughput(size_t pixel_count, clock_t start);
+static unsigned char* read_file(const char* file_name, size_t* size);
+
+int main(int argc, char* argv[])
+{
+    bool is_benchmark = false;
+    int  first_image  = 1;
+    int  status       = EXIT_SUCCESS;
+
+    if (2 < argc && 0 == strcmp(argv[1], "-b"))
+    {
+        is_benchmark = true;
+        first_image  = 2;
+    }
+
+    if (first_image >= argc)
+    {
+        fprintf(stderr, "Usage: %s [-b] <image>...\n", argv[0]);
+        return EXIT_FAILURE;
+    }
+
+    for (int index = first_image; index < argc; index += 1)
+    {
+        bool is_done = is_benchmark ? benchmark_image(argv[index]) : convert_image(argv[index]);
+
+        if (! is_done)
+        {
+            status = EXIT_FAILURE;
+        }
+    }
+
+    return status;
+}
+
+static bool benchmark_image(const char* file_name)
+{
+    unsigned char* buffer;
+    unsigned char* pixels;
+    unsigned char* qoi        = NULL;
+    size_t         size;
+    size_t         qoi_size   = 0;
+    size_t         pixel_count;
+    double         png_throughput;
+    double         qoi_throughput;
+    clock_t        start;
+    int            width;
+    int            height;
+    int            orig_format;
+    int32_t        qoi_width;
+    int32_t        qoi_height;
+    bool           is_done    = false;
+
+    buffer = read_file(file_name, &size);
+    if (! buffer)
+    {
+        return false;
+    }
+
+    pixels = stbi_load_from_memory(buffer, (int)size, &width, &height, &orig_format, STBI_rgb_alpha);
+    if (! pixels)
+    {
+        fprintf(stderr, "%s: %s.\n", file_name, stbi_failure_reason());
+        goto exit;
+    }
+
+    qoi = encode_qoi(pixels, width, height, &qoi_size);
+    stbi_image_free(pixels);
+
+    if (! qoi)
+    {
+        fprintf(stderr, "Could not encode %s.\n", file_name);
+        goto exit;
+    }
+
+    pixel_count = (size_t)width * (size_t)height;
+
+    start = clock();
+    for (int round = 0; round < BENCHMARK_ROUNDS; round += 1)
+    {
+        stbi_image_free(stbi_load_from_memory(buffer, (int)size, &width, &height, &orig_format, STBI_rgb_alpha));
+    }
+    png_throughput = get_throughput(pixel_count, start);
+
+    start = clock();
+    for (int round = 0; round < BENCHMARK_ROUNDS; round += 1)
+    {
+        free(decode_qoi(qoi, qoi_size, &qoi_width, &qoi_height));
+    }
+    qoi_throughput = get_throughput(pixel_count, start);
+
+    printf(
+        "%s: %dx%d, PNG %zu bytes %.1f MiB/s, QOI %zu bytes %.1f MiB/s (%.1fx).\n",
+        file_name, width, height,
+        size, png_throughput,
+        qoi_size, qoi_throughput,
+        0.0 < png_throughput ? qoi_throughput / png_throughput : 0.0);
+
+    is_done = true;
+
+exit:
+    free(qoi);
+    free(buffer);
+
+    return is_done;
+}
+
+static bool convert_image(const char* file_name)
+{
+    char           qoi_file_name[256] = { 0 };
+    unsigned char* pixels;
+    unsigned char* qoi;
+    size_t         qoi_size           = 0;
+    int            width;
+    int            height;
+    int            orig_format;
+    bool           is_done            = false;
+    FILE*          fp;
+
+    if (sizeof(qoi_file_name) <= cwk_path_change_extension(file_name, QOI_FILE_EXTENSION, qoi_file_name, sizeof(qoi_file_name)))
+    {
+        fprintf(stderr, "%s: file name too long.\n", file_name);
+        return false;
+    }
+
+    pixels = stbi_load(file_name, &width, &height, &orig_format, STBI_rgb_alpha);
+    if (! pixels)
+    {
+        fprintf(stderr, "%s: %s.\n", file_name, stbi_failure_reason());
+        return false;
+    }
+
+    qoi = encode_qoi(pixels, width, height, &qoi_size);
+    stbi_image_free(pixels);
+
+    if (! qoi)
+    {
+        fprintf(stderr, "Could not encode %s.\n", file_name);
+        return false;
+    }
+
+    fp = fopen(qoi_file_name, "wb");
+    if (! fp)
+    {
+        fprintf(stderr, "Could not open %s.\n", qoi_file_name);
+        free(qoi);
+        return false;
+    }
+
+    if (1 == fwrite(qoi, qoi_size, 1, fp))
+    {
+        printf("%s: %zu bytes.\n", qoi_file_name, qoi_size);
+        is_done = true;
+    }
+    else
+    {
+        fprintf(stderr, "Could not write %s.\n", qoi_file_name);
+    }
+
+    fclose(fp);
+    free(qoi);
+
+    return is_done;
+}
+
+// Decoded RGBA bytes per second over all rounds.
+static double get_throughput(size_t pixel_count, clock_t start)
+{
+    double seconds = (double)(clock() - start) / (double)CLOCKS_PER_SEC;
+
+    if (0.0 >= seconds)
+    {
+        return 0.0;
+    }
+
+    return (double)(pixel_count * 4 * BENCHMARK_ROUNDS) / seconds / (1024.0 * 1024.0);
+}
+
+static unsigned char* read_file(const char* file_name, size_t* size)
+{
+    unsigned char* buffer;
+    long           file_size;
+    FILE*          fp = fopen(file_name, "rb");
+
+    if (! fp)
+    {
+        fprintf(stderr, "Could not open %s.\n", file_name);
+        return NULL;
+    }
+
+    fseek(fp, 0, SEEK_END);
+    file_size = ftell(fp);
+    fseek(fp, 0, SEEK_SET);
+
+    if (0 >= file_size)
+    {
+        fprintf(stderr, "Could not read %s.\n", file_name);
+        fclose(fp);
+        return NULL;
+    }
+
+    buffer = (unsigned char*)malloc((size_t)file_size);
+    if (! buffer)
+    {
+        fprintf(stderr, "Error allocating memory.\n");
+        fclose(fp);
+        return NULL;
+    }
+
+    if (1 != fread(buffer, (size_t)file_size, 1, fp))
+    {
+        fprintf(stderr, "Could not read %s.\n", file_name);
+        free(buffer);
+        fclose(fp);
+        return NULL;
+    }
+
+    fclose(fp);
+    *size = (size_t)file_size;
+
+    return buffer;
+}